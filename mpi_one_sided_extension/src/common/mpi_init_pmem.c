@@ -30,6 +30,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "error_codes.h"
 #include "logger.h"
 #include <mpi.h>
+#include "../mpi_one_sided_extension/mpi_win_pmem_reclaim.h"
 
 int MPI_ERR_PMEM;
 int MPI_ERR_PMEM_ROOT_PATH;
@@ -120,6 +121,8 @@ int MPI_Init_thread_pmem(int *argc, char ***argv, int required, int *provided) {
 int MPI_Finalize_pmem() {
    mpi_log_debug("Finalizing MPI.");
 
+   // Space of deleted files is freed before process exits, so it doesn't stay allocated until root path is used again.
+   wait_for_reclaimed_files();
    deinit_mpi_logging();
    MPI_Finalize();
 
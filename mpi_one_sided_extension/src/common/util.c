@@ -25,4 +25,23 @@ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include "util.h"
 
+// Error handlers of background thread are called by thread which waits for it.
+static __thread bool errhandlers_deferred = false;
+
+void defer_errhandlers(bool defer) {
+   errhandlers_deferred = defer;
+}
+
+void call_comm_errhandler(MPI_Comm comm, int error_code) {
+   if (!errhandlers_deferred) {
+      MPI_Comm_call_errhandler(comm, error_code);
+   }
+}
+
+void call_win_errhandler(MPI_Win win, int error_code) {
+   if (!errhandlers_deferred) {
+      MPI_Win_call_errhandler(win, error_code);
+   }
+}
@@ -29,6 +29,41 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef __UTIL_H__
 #define __UTIL_H__
 
+#include <stdbool.h>
+#include <mpi.h>
+
 #define UNUSED(x) (void)(x)
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Enable or disable deferring of error handlers for calling thread. Background threads don't call error handlers of windows and communicators used by
+ * application, their errors are returned to thread which waits for them and it calls error handler.
+ *
+ * @param defer  Flag specifying whether error handlers are deferred.
+ */
+void defer_errhandlers(bool defer);
+
+/**
+ * Call error handler of communicator unless error handlers are deferred for calling thread.
+ *
+ * @param comm        Communicator.
+ * @param error_code  Error code.
+ */
+void call_comm_errhandler(MPI_Comm comm, int error_code);
+
+/**
+ * Call error handler of window unless error handlers are deferred for calling thread.
+ *
+ * @param win         Window.
+ * @param error_code  Error code.
+ */
+void call_win_errhandler(MPI_Win win, int error_code);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -42,9 +42,17 @@ extern "C" {
 
 #define MPI_PMEM_MAX_ROOT_PATH 256
 
+#define MPI_PMEM_MAX_ROOT_PATHS 16
+
 // Variable holding root path to application's windows.
 extern char mpi_pmem_root_path[MPI_PMEM_MAX_ROOT_PATH];
 
+// Root paths set by MPI_Win_pmem_set_root_paths (only mpi_pmem_root_path if it was set by MPI_Win_pmem_set_root_path) and index of the one used as
+// mpi_pmem_root_path. Windows can be striped over all of them.
+extern char mpi_pmem_root_paths[MPI_PMEM_MAX_ROOT_PATHS][MPI_PMEM_MAX_ROOT_PATH];
+extern int mpi_pmem_root_paths_count;
+extern int mpi_pmem_root_path_index;
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,351 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_aggregate.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <libpmem.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem.h"
+#include "mpi_win_pmem_reclaim.h"
+
+struct MPI_Win_pmem_aggregator_structure {
+   MPI_Comm comm;          // Communicator of window, used for error handling.
+   MPI_Comm node_comm;     // Processes of window running on the same node (node leader has rank 0).
+   int node_rank;
+   int node_size;
+   int rank;               // Rank of process in communicator of window.
+   char leader_root_path[MPI_PMEM_MAX_ROOT_PATH]; // Directory containing node checkpoint files.
+};
+
+// Additional 20 characters for: "/.", "-", 10 characters for checkpoint number, "-node" and terminating zero.
+#define MPI_PMEM_AGGREGATE_FILE_NAME_LENGTH (MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 20)
+
+/**
+ * Round offset up to alignment of data in node checkpoint file.
+ *
+ * @param offset Offset to round.
+ *
+ * @returns Aligned offset.
+ */
+static MPI_Aint align_offset(MPI_Aint offset) {
+   return (offset + MPI_PMEM_AGGREGATE_ALIGNMENT - 1) / MPI_PMEM_AGGREGATE_ALIGNMENT * MPI_PMEM_AGGREGATE_ALIGNMENT;
+}
+
+/**
+ * Copy data of process to node checkpoint file. Non-temporal stores are used if file is placed in persistent memory, otherwise data is written to page
+ * cache and made durable by node leader.
+ *
+ * @param file_name  Name of node checkpoint file.
+ * @param offset     Offset of data of process.
+ * @param data       Window data.
+ * @param size       Size of window.
+ * @param pool       Pool of threads used to copy data (may be NULL).
+ *
+ * @returns True on success, false otherwise.
+ */
+static bool write_extent(const char *file_name, MPI_Aint offset, const void *data, MPI_Aint size, MPI_Win_pmem_copy_pool *pool) {
+   int fd;
+   bool result = true;
+   void *address;
+   off_t file_size;
+
+   if (size == 0) {
+      return true;
+   }
+   if ((fd = open(file_name, O_RDWR)) < 0) {
+      return false;
+   }
+   address = pmem_map(fd);
+   file_size = lseek(fd, 0, SEEK_END);
+   if (address != NULL && pmem_is_pmem((char*) address + offset, size)) {
+      parallel_pmem_memcpy(pool, (char*) address + offset, data, size);
+   } else {
+      result = parallel_pwrite(pool, fd, data, size, offset);
+   }
+   if (address != NULL) {
+      munmap(address, file_size);
+   }
+   close(fd);
+
+   return result;
+}
+
+/**
+ * Make node checkpoint file durable and commit its header. Called by node leader after all processes copied their data.
+ *
+ * @param directory  Directory containing node checkpoint file.
+ * @param file_name  Name of node checkpoint file.
+ * @param entries    Locations of data of all processes on node.
+ * @param count      Number of processes on node.
+ *
+ * @returns True on success, false otherwise.
+ */
+static bool commit_node_file(const char *directory, const char *file_name, MPI_Win_pmem_aggregate_entry *entries, int count) {
+   int fd, root_file_descriptor;
+   bool result;
+   MPI_Win_pmem_aggregate_header header;
+
+   if ((fd = open(file_name, O_RDWR)) < 0) {
+      return false;
+   }
+   // Single synchronization of the whole file replaces synchronization done by every process. Header is written only after data is durable.
+   result = parallel_pwrite(NULL, fd, entries, count * sizeof(MPI_Win_pmem_aggregate_entry), sizeof(MPI_Win_pmem_aggregate_header)) && fsync(fd) == 0;
+   header.count = count;
+   header.references = count;
+   result = result && parallel_pwrite(NULL, fd, &header, sizeof(MPI_Win_pmem_aggregate_header), 0) && fsync(fd) == 0;
+   close(fd);
+
+   root_file_descriptor = open(directory, O_RDONLY);
+   fsync(root_file_descriptor);
+   close(root_file_descriptor);
+
+   return result;
+}
+
+int create_checkpoint_aggregator(MPI_Comm comm, MPI_Win_pmem_aggregator **aggregator) {
+   int result;
+
+   *aggregator = malloc(sizeof(MPI_Win_pmem_aggregator));
+   if (*aggregator == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   (*aggregator)->comm = comm;
+   MPI_Comm_rank(comm, &(*aggregator)->rank);
+   result = MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, (*aggregator)->rank, MPI_INFO_NULL, &(*aggregator)->node_comm);
+   CHECK_ERROR_CODE(result);
+   MPI_Comm_rank((*aggregator)->node_comm, &(*aggregator)->node_rank);
+   MPI_Comm_size((*aggregator)->node_comm, &(*aggregator)->node_size);
+
+   // All processes of node use root path of node leader.
+   strcpy((*aggregator)->leader_root_path, mpi_pmem_root_path);
+   result = MPI_Bcast((*aggregator)->leader_root_path, MPI_PMEM_MAX_ROOT_PATH, MPI_CHAR, 0, (*aggregator)->node_comm);
+   CHECK_ERROR_CODE(result);
+   mpi_log_debug("Checkpoints of %d processes on node aggregated in '%s'.", (*aggregator)->node_size, (*aggregator)->leader_root_path);
+
+   return MPI_SUCCESS;
+}
+
+int write_aggregated_checkpoint(MPI_Win_pmem_aggregator *aggregator, const char *name, int version, bool prepared, const void *data, MPI_Aint size,
+                                MPI_Win_pmem_copy_pool *pool, int *node_version) {
+   int result, i, fd;
+   char status, all_status;
+   char file_name[MPI_PMEM_AGGREGATE_FILE_NAME_LENGTH], link_name[MPI_PMEM_AGGREGATE_FILE_NAME_LENGTH];
+   MPI_Aint local[2], offset;
+   MPI_Aint *sizes;
+   MPI_Win_pmem_aggregate_entry *entries;
+
+   // Processes could have created different number of checkpoints outside of MPI_Win_fence, so file is named after version of node leader.
+   *node_version = version;
+   result = MPI_Bcast(node_version, 1, MPI_INT, 0, aggregator->node_comm);
+   CHECK_ERROR_CODE(result);
+   sprintf(file_name, "%s/.%s-%d-node", aggregator->leader_root_path, name, *node_version);
+
+   // Place data of processes one after another in order of ranks on node.
+   sizes = malloc(2 * aggregator->node_size * sizeof(MPI_Aint));
+   entries = malloc(aggregator->node_size * sizeof(MPI_Win_pmem_aggregate_entry));
+   if (sizes == NULL || entries == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      free(sizes);
+      free(entries);
+      call_comm_errhandler(aggregator->comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   local[0] = aggregator->rank;
+   local[1] = size;
+   result = MPI_Allgather(local, 2, MPI_AINT, sizes, 2, MPI_AINT, aggregator->node_comm);
+   CHECK_ERROR_CODE(result);
+   offset = align_offset(sizeof(MPI_Win_pmem_aggregate_header) + aggregator->node_size * sizeof(MPI_Win_pmem_aggregate_entry));
+   for (i = 0; i < aggregator->node_size; i++) {
+      entries[i].rank = sizes[2 * i];
+      entries[i].offset = offset;
+      entries[i].size = sizes[2 * i + 1];
+      offset = align_offset(offset + sizes[2 * i + 1]);
+   }
+   free(sizes);
+
+   // Node leader creates and preallocates file, so other processes only write their data.
+   status = prepared ? 1 : 0;
+   if (aggregator->node_rank == 0 && prepared) {
+      if (access(file_name, F_OK) == 0) {
+         reclaim_file(mpi_pmem_root_path, file_name);
+      }
+      fd = open(file_name, O_CREAT | O_RDWR | O_TRUNC, 0666);
+      if (fd < 0 || posix_fallocate(fd, 0, offset) != 0) {
+         status = 0;
+      }
+      if (fd >= 0) {
+         close(fd);
+      }
+   }
+   result = MPI_Bcast(&status, 1, MPI_CHAR, 0, aggregator->node_comm);
+   CHECK_ERROR_CODE(result);
+   if (status == 0) {
+      mpi_log_error("Unable to create node checkpoint file '%s'.", file_name);
+      free(entries);
+      call_comm_errhandler(aggregator->comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   // Process which isn't prepared only reports failure to other processes of node.
+   status = prepared && write_extent(file_name, entries[aggregator->node_rank].offset, data, size, pool) ? 1 : 0;
+   result = MPI_Allreduce(&status, &all_status, 1, MPI_CHAR, MPI_MIN, aggregator->node_comm);
+   CHECK_ERROR_CODE(result);
+   if (aggregator->node_rank == 0 && all_status == 1) {
+      all_status = commit_node_file(aggregator->leader_root_path, file_name, entries, aggregator->node_size) ? 1 : 0;
+   }
+   free(entries);
+   result = MPI_Bcast(&all_status, 1, MPI_CHAR, 0, aggregator->node_comm);
+   CHECK_ERROR_CODE(result);
+   if (all_status == 0) {
+      mpi_log_error("Node checkpoint file '%s' wasn't written by all processes.", file_name);
+      call_comm_errhandler(aggregator->comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   // Processes with other root path than node leader refer to node checkpoint file with link, so they find it when their version is deleted.
+   if (strcmp(aggregator->leader_root_path, mpi_pmem_root_path) != 0) {
+      sprintf(link_name, "%s/.%s-%d-node", mpi_pmem_root_path, name, *node_version);
+      remove(link_name);
+      if (symlink(file_name, link_name) != 0) {
+         mpi_log_error("Unable to create link '%s' to node checkpoint file.", link_name);
+         call_comm_errhandler(aggregator->comm, MPI_ERR_PMEM);
+         return MPI_ERR_PMEM;
+      }
+   }
+   mpi_log_debug("Checkpoint written to node checkpoint file '%s'.", file_name);
+
+   return MPI_SUCCESS;
+}
+
+int read_aggregated_checkpoint(MPI_Win_pmem_aggregator *aggregator, const char *name, int node_version, MPI_Aint size, void *destination, MPI_Win_pmem_copy_pool *pool) {
+   int fd;
+   uint64_t i;
+   char file_name[MPI_PMEM_AGGREGATE_FILE_NAME_LENGTH];
+   void *address;
+   MPI_Win_pmem_aggregate_header header;
+   MPI_Win_pmem_aggregate_entry entry;
+   bool found = false;
+
+   sprintf(file_name, "%s/.%s-%d-node", aggregator->leader_root_path, name, node_version);
+   if ((fd = open(file_name, O_RDONLY)) < 0) {
+      mpi_log_error("Node checkpoint file '%s' doesn't exist.", file_name);
+      call_comm_errhandler(aggregator->comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   if (pread(fd, &header, sizeof(MPI_Win_pmem_aggregate_header), 0) != sizeof(MPI_Win_pmem_aggregate_header)) {
+      header.count = 0;
+   }
+   for (i = 0; i < header.count && !found; i++) {
+      if (pread(fd, &entry, sizeof(MPI_Win_pmem_aggregate_entry), sizeof(MPI_Win_pmem_aggregate_header) + i * sizeof(MPI_Win_pmem_aggregate_entry)) !=
+          sizeof(MPI_Win_pmem_aggregate_entry)) {
+         break;
+      }
+      found = entry.rank == aggregator->rank;
+   }
+   if (!found || entry.size != size) {
+      mpi_log_error("Node checkpoint file '%s' doesn't contain data of process %d of size %lu.", file_name, aggregator->rank, size);
+      close(fd);
+      call_comm_errhandler(aggregator->comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   if (size == 0) {
+      close(fd);
+      return MPI_SUCCESS;
+   }
+
+   address = mmap(NULL, entry.offset + size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (address == MAP_FAILED) {
+      mpi_log_error("Unable to map node checkpoint file '%s' to memory.", file_name);
+      call_comm_errhandler(aggregator->comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   parallel_memcpy(pool, destination, (char*) address + entry.offset, size);
+   munmap(address, entry.offset + size);
+
+   return MPI_SUCCESS;
+}
+
+void remove_aggregated_checkpoint(const char *name, int node_version) {
+   int fd;
+   char file_name[MPI_PMEM_AGGREGATE_FILE_NAME_LENGTH];
+   char target_name[PATH_MAX], directory[PATH_MAX], *separator;
+   struct stat file_status;
+   MPI_Aint header_size = sizeof(MPI_Win_pmem_aggregate_header);
+   MPI_Win_pmem_aggregate_header header;
+   bool last_reference = false;
+
+   sprintf(file_name, "%s/.%s-%d-node", mpi_pmem_root_path, name, node_version);
+   if ((fd = open(file_name, O_RDWR)) >= 0 && flock(fd, LOCK_EX) == 0) {
+      if (pread(fd, &header, header_size, 0) == header_size && header.references > 1) {
+         header.references--;
+         if (pwrite(fd, &header, header_size, 0) == header_size) {
+            fsync(fd);
+         }
+         mpi_log_debug("Node checkpoint file '%s' is still referred to by %lu processes.", file_name, (unsigned long) header.references);
+      } else {
+         last_reference = true;
+      }
+      // File is removed while it is locked, so no other process can release its reference in the meantime.
+      if (last_reference && realpath(file_name, target_name) != NULL) {
+         strcpy(directory, target_name);
+         separator = strrchr(directory, '/');
+         if (separator != NULL) {
+            *separator = '\0';
+         }
+         if (reclaim_file(directory, target_name)) {
+            mpi_log_debug("Node checkpoint file '%s' deleted.", target_name);
+         }
+      }
+   }
+   if (fd >= 0) {
+      close(fd);
+   }
+   // Link of process other than node leader is removed even if node checkpoint file no longer exists.
+   if (lstat(file_name, &file_status) == 0 && S_ISLNK(file_status.st_mode)) {
+      remove(file_name);
+   }
+}
+
+void free_checkpoint_aggregator(MPI_Win_pmem_aggregator *aggregator) {
+   if (aggregator != NULL) {
+      MPI_Comm_free(&aggregator->node_comm);
+      free(aggregator);
+   }
+}
@@ -0,0 +1,122 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_AGGREGATE_H__
+#define __MPI_WIN_PMEM_AGGREGATE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <mpi.h>
+#include "mpi_win_pmem_datatypes.h"
+#include "mpi_win_pmem_parallel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Alignment of data of processes in node checkpoint file.
+#define MPI_PMEM_AGGREGATE_ALIGNMENT 4096
+
+// Header of node checkpoint file. It is followed by entries of all processes running on node and by their data.
+typedef struct {
+   uint64_t count;      // Number of entries (0 until node leader committed the file).
+   uint64_t references; // Number of processes whose checkpoint version refers to the file. Changed under exclusive lock of the file.
+} MPI_Win_pmem_aggregate_header;
+
+// Location of data of one process in node checkpoint file.
+typedef struct {
+   int64_t rank;     // Rank of process in communicator of window.
+   int64_t offset;
+   int64_t size;
+} MPI_Win_pmem_aggregate_entry;
+
+/**
+ * Create aggregator of checkpoints of processes running on the same node. Node checkpoint files are placed in root path of node leader (process with
+ * the lowest rank on node). Collective over communicator of window.
+ *
+ * @param comm        Communicator of window.
+ * @param aggregator  Output variable for aggregator.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int create_checkpoint_aggregator(MPI_Comm comm, MPI_Win_pmem_aggregator **aggregator);
+
+/**
+ * Write window data to node checkpoint file. Every process copies its data at precomputed offset, then node leader makes the whole file durable and commits
+ * its header referenced by all processes of node. Collective over all processes of node.
+ *
+ * @param aggregator    Checkpoint aggregator.
+ * @param name          Name of window.
+ * @param version       Checkpoint version created by this process.
+ * @param prepared      Flag specifying whether this process is ready to write its data. Process which isn't ready still takes part in collective operations, so
+ *                      whole node fails instead of waiting for it.
+ * @param data          Window data.
+ * @param size          Size of window.
+ * @param pool          Pool of threads used to copy data (may be NULL).
+ * @param node_version  Output variable for version in name of node checkpoint file (checkpoint version created by node leader).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int write_aggregated_checkpoint(MPI_Win_pmem_aggregator *aggregator, const char *name, int version, bool prepared, const void *data, MPI_Aint size,
+                                MPI_Win_pmem_copy_pool *pool, int *node_version);
+
+/**
+ * Copy data of calling process from node checkpoint file.
+ *
+ * @param aggregator    Checkpoint aggregator.
+ * @param name          Name of window.
+ * @param node_version  Version in name of node checkpoint file.
+ * @param size          Size of window.
+ * @param destination   Destination memory area.
+ * @param pool          Pool of threads used to copy data (may be NULL).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int read_aggregated_checkpoint(MPI_Win_pmem_aggregator *aggregator, const char *name, int node_version, MPI_Aint size, void *destination, MPI_Win_pmem_copy_pool *pool);
+
+/**
+ * Release reference of calling process to node checkpoint file. Other processes of node refer to the file with symbolic link placed in their root path.
+ * The file is removed by the process which releases the last reference, so it is kept while checkpoint version of any process of node refers to it.
+ *
+ * @param name          Name of window.
+ * @param node_version  Version in name of node checkpoint file.
+ */
+void remove_aggregated_checkpoint(const char *name, int node_version);
+
+/**
+ * Free checkpoint aggregator. Collective over communicator of window.
+ *
+ * @param aggregator  Checkpoint aggregator (may be NULL).
+ */
+void free_checkpoint_aggregator(MPI_Win_pmem_aggregator *aggregator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
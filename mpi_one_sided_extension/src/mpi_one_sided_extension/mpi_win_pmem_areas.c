@@ -0,0 +1,206 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_areas.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <libpmem.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+
+/**
+ * Draw number of index levels in which new memory area is linked.
+ *
+ * @param index  Index of memory areas.
+ *
+ * @returns Number of levels between 1 and MPI_PMEM_AREAS_INDEX_LEVELS.
+ */
+static int random_area_levels(MPI_Win_memory_areas_index *index) {
+   int levels = 1;
+
+   while (levels < MPI_PMEM_AREAS_INDEX_LEVELS && (rand_r(&index->seed) & 3) == 0) {
+      levels++;
+   }
+
+   return levels;
+}
+
+/**
+ * Find the last area placed below specified address on every level of index.
+ *
+ * @param index         Index of memory areas.
+ * @param address       Searched address.
+ * @param predecessors  Output array for found areas (NULL if there is no such area on level, i.e. head of level precedes address).
+ */
+static void find_area_predecessors(const MPI_Win_memory_areas_index *index, const void *address, MPI_Win_memory_areas_list **predecessors) {
+   int level;
+   MPI_Win_memory_areas_list *current_item = NULL, *next_item;
+
+   for (level = index->levels - 1; level >= 0; level--) {
+      next_item = current_item == NULL ? index->head[level] : current_item->index_next[level];
+      while (next_item != NULL && (uintptr_t) next_item->base < (uintptr_t) address) {
+         current_item = next_item;
+         next_item = current_item->index_next[level];
+      }
+      predecessors[level] = current_item;
+   }
+}
+
+int add_memory_area(MPI_Win_pmem win, void *base, MPI_Aint size, MPI_Win_memory_areas_list **area) {
+   int level, levels;
+   MPI_Win_memory_areas_index *index = win.modifiable_values->areas_index;
+   MPI_Win_memory_areas_list *list_item;
+   MPI_Win_memory_areas_list *predecessors[MPI_PMEM_AREAS_INDEX_LEVELS];
+
+   if (index == NULL) {
+      index = calloc(1, sizeof(MPI_Win_memory_areas_index));
+      if (index == NULL) {
+         mpi_log_error("Unable to allocate memory.");
+         call_comm_errhandler(win.comm, MPI_ERR_PMEM_NO_MEM);
+         return MPI_ERR_PMEM_NO_MEM;
+      }
+      index->seed = (unsigned int) (uintptr_t) index;
+      win.modifiable_values->areas_index = index;
+   }
+
+   levels = random_area_levels(index);
+   list_item = malloc(sizeof(MPI_Win_memory_areas_list) + levels * sizeof(MPI_Win_memory_areas_list*));
+   if (list_item == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(win.comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   list_item->base = base;
+   list_item->size = size;
+   list_item->is_pmem = win.is_pmem && pmem_is_pmem(base, size);
+   list_item->id = win.modifiable_values->next_area_id++;
+   list_item->levels = levels;
+
+   // List keeps areas in reverse order of attaching.
+   list_item->previous = NULL;
+   list_item->next = win.modifiable_values->memory_areas;
+   if (list_item->next != NULL) {
+      list_item->next->previous = list_item;
+   }
+   win.modifiable_values->memory_areas = list_item;
+
+   find_area_predecessors(index, base, predecessors);
+   for (level = index->levels; level < levels; level++) {
+      predecessors[level] = NULL;
+   }
+   if (levels > index->levels) {
+      index->levels = levels;
+   }
+   for (level = 0; level < levels; level++) {
+      if (predecessors[level] == NULL) {
+         list_item->index_next[level] = index->head[level];
+         index->head[level] = list_item;
+      } else {
+         list_item->index_next[level] = predecessors[level]->index_next[level];
+         predecessors[level]->index_next[level] = list_item;
+      }
+   }
+
+   if (area != NULL) {
+      *area = list_item;
+   }
+
+   return MPI_SUCCESS;
+}
+
+MPI_Win_memory_areas_list* remove_memory_area(MPI_Win_pmem win, const void *base) {
+   int level;
+   MPI_Win_memory_areas_index *index = win.modifiable_values->areas_index;
+   MPI_Win_memory_areas_list *list_item;
+   MPI_Win_memory_areas_list *predecessors[MPI_PMEM_AREAS_INDEX_LEVELS];
+
+   if (index == NULL || index->levels == 0) {
+      return NULL;
+   }
+   find_area_predecessors(index, base, predecessors);
+   list_item = predecessors[0] == NULL ? index->head[0] : predecessors[0]->index_next[0];
+   if (list_item == NULL || list_item->base != base) {
+      return NULL;
+   }
+
+   // Area with specified base is the first one following predecessors on all levels in which it is linked.
+   for (level = 0; level < list_item->levels; level++) {
+      if (predecessors[level] == NULL) {
+         index->head[level] = list_item->index_next[level];
+      } else {
+         predecessors[level]->index_next[level] = list_item->index_next[level];
+      }
+   }
+   while (index->levels > 0 && index->head[index->levels - 1] == NULL) {
+      index->levels--;
+   }
+
+   if (list_item->previous == NULL) {
+      win.modifiable_values->memory_areas = list_item->next;
+   } else {
+      list_item->previous->next = list_item->next;
+   }
+   if (list_item->next != NULL) {
+      list_item->next->previous = list_item->previous;
+   }
+
+   return list_item;
+}
+
+MPI_Win_memory_areas_list* find_memory_area(MPI_Win_pmem win, const void *address) {
+   MPI_Win_memory_areas_index *index = win.modifiable_values->areas_index;
+   MPI_Win_memory_areas_list *list_item;
+   MPI_Win_memory_areas_list *predecessors[MPI_PMEM_AREAS_INDEX_LEVELS];
+
+   if (index == NULL || index->levels == 0) {
+      return NULL;
+   }
+   find_area_predecessors(index, address, predecessors);
+   list_item = predecessors[0];
+   if (list_item != NULL && (uintptr_t) address < (uintptr_t) list_item->base + list_item->size) {
+      return list_item;
+   }
+
+   return list_item == NULL ? index->head[0] : list_item->index_next[0];
+}
+
+void free_memory_areas(MPI_Win_pmem win) {
+   MPI_Win_memory_areas_list *current_item, *next_item;
+
+   current_item = win.modifiable_values->memory_areas;
+   while (current_item != NULL) {
+      next_item = current_item->next;
+      mpi_log_debug("Freeing memory area metadata base: 0x%lx, size: %lu.", (long int) current_item->base, current_item->size);
+      free(current_item);
+      current_item = next_item;
+   }
+   win.modifiable_values->memory_areas = NULL;
+   free(win.modifiable_values->areas_index);
+   win.modifiable_values->areas_index = NULL;
+}
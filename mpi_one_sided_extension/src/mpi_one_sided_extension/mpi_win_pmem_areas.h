@@ -0,0 +1,94 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_AREAS_H__
+#define __MPI_WIN_PMEM_AREAS_H__
+
+#include <stdbool.h>
+#include <mpi.h>
+#include "mpi_win_pmem_datatypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MPI_PMEM_AREAS_INDEX_LEVELS 16
+
+// Skiplist of memory areas attached to window ordered by their base addresses. Areas are linked in it through their index_next pointers, every level contains
+// about quarter of areas of level below.
+struct MPI_Win_memory_areas_index_structure {
+   int levels;          // Number of levels containing at least one area.
+   unsigned int seed;   // State of generator of random levels of areas.
+   MPI_Win_memory_areas_list *head[MPI_PMEM_AREAS_INDEX_LEVELS];
+};
+
+/**
+ * Add memory area to window. Area is placed at the beginning of list of memory areas and inserted into index of areas.
+ *
+ * @param win   Window object.
+ * @param base  Beginning of memory area.
+ * @param size  Size of memory area.
+ * @param area  Output variable for added area (may be NULL).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int add_memory_area(MPI_Win_pmem win, void *base, MPI_Aint size, MPI_Win_memory_areas_list **area);
+
+/**
+ * Remove memory area with specified base from list of memory areas and index of areas. Memory of removed area has to be freed by caller.
+ *
+ * @param win   Window object.
+ * @param base  Beginning of memory area.
+ *
+ * @returns Removed area or NULL if there is no area with specified base.
+ */
+MPI_Win_memory_areas_list* remove_memory_area(MPI_Win_pmem win, const void *base);
+
+/**
+ * Find memory area containing specified address or, if there is no such area, the first area placed above it. Areas placed above returned one are reached
+ * through index_next[0] pointers.
+ *
+ * @param win      Window object.
+ * @param address  Searched address (NULL to get area with the lowest base).
+ *
+ * @returns Found area or NULL if all areas are placed below address.
+ */
+MPI_Win_memory_areas_list* find_memory_area(MPI_Win_pmem win, const void *address);
+
+/**
+ * Free all memory areas of window together with their index.
+ *
+ * @param win  Window object.
+ */
+void free_memory_areas(MPI_Win_pmem win);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,340 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_chunks.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem_reclaim.h"
+
+#define MPI_PMEM_CHUNK_PATH_LENGTH (MPI_PMEM_MAX_ROOT_PATH + 40) // Additional 40 characters for: "/.chunks/", 16 characters of hash, "-", 10 characters of collision index and terminating zero.
+
+/**
+ * Calculate 64-bit hash of chunk. Chunks with equal hashes are compared byte by byte, so hash doesn't have to be collision resistant.
+ *
+ * @param data  Chunk data.
+ * @param size  Size of chunk.
+ *
+ * @returns Hash of chunk.
+ */
+static uint64_t hash_chunk(const unsigned char *data, uint64_t size) {
+   uint64_t i, word, hash = 0x9e3779b97f4a7c15ULL ^ size;
+
+   for (i = 0; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      memcpy(&word, data + i, sizeof(uint64_t));
+      hash ^= word * 0xff51afd7ed558ccdULL;
+      hash = ((hash << 31) | (hash >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+   }
+   for (; i < size; i++) {
+      hash = (hash ^ data[i]) * 0x100000001b3ULL;
+   }
+   hash ^= hash >> 33;
+   hash *= 0xff51afd7ed558ccdULL;
+   hash ^= hash >> 33;
+
+   return hash;
+}
+
+/**
+ * Open chunk store directory (create it if it doesn't exist) and lock it for exclusive use of calling process.
+ *
+ * @param comm  Communicator used for error handling.
+ * @param lock  Output variable for file descriptor of lock file. Store is unlocked by closing it.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int lock_chunk_store(MPI_Comm comm, int *lock) {
+   char path[MPI_PMEM_CHUNK_PATH_LENGTH];
+
+   sprintf(path, "%s/.chunks", mpi_pmem_root_path);
+   if (mkdir(path, 0777) != 0 && errno != EEXIST) {
+      mpi_log_error("Unable to create chunk store '%s'.", path);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   sprintf(path, "%s/.chunks/.lock", mpi_pmem_root_path);
+   if ((*lock = open(path, O_CREAT | O_RDWR, 0666)) < 0 || flock(*lock, LOCK_EX) != 0) {
+      if (*lock >= 0) {
+         close(*lock);
+      }
+      mpi_log_error("Unable to lock chunk store.");
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Find chunk in chunk store or add it if it isn't stored yet. Reference count of chunk is increased. Chunk store has to be locked.
+ *
+ * @param data       Chunk data.
+ * @param reference  Reference to chunk with hash and size set. Collision index is set by the function.
+ * @param buffer     Buffer of MPI_PMEM_CHUNK_SIZE bytes used to compare chunks.
+ * @param created    Output variable set to true if chunk was added to chunk store.
+ *
+ * @returns True on success, false otherwise.
+ */
+static bool store_chunk(const void *data, MPI_Win_pmem_chunk_reference *reference, void *buffer, bool *created) {
+   char path[MPI_PMEM_CHUNK_PATH_LENGTH];
+   int fd;
+   uint64_t reference_count;
+   struct stat stat_buffer;
+   bool equal;
+
+   *created = false;
+   for (reference->collision = 0; ; reference->collision++) {
+      sprintf(path, "%s/.chunks/%016lx-%u", mpi_pmem_root_path, (unsigned long) reference->hash, reference->collision);
+      fd = open(path, O_RDWR);
+      if (fd < 0 && errno == ENOENT) {
+         // New chunk.
+         if ((fd = open(path, O_CREAT | O_EXCL | O_RDWR, 0666)) < 0) {
+            return false;
+         }
+         reference_count = 1;
+         equal = pwrite(fd, &reference_count, sizeof(uint64_t), 0) == sizeof(uint64_t) &&
+                 pwrite(fd, data, reference->size, sizeof(uint64_t)) == reference->size && fsync(fd) == 0;
+         close(fd);
+         *created = true;
+         return equal;
+      } else if (fd < 0) {
+         return false;
+      }
+
+      // Chunk with equal hash is stored already, check whether it contains the same data.
+      equal = fstat(fd, &stat_buffer) == 0 && (uint64_t) stat_buffer.st_size == sizeof(uint64_t) + reference->size &&
+              pread(fd, buffer, reference->size, sizeof(uint64_t)) == reference->size && memcmp(buffer, data, reference->size) == 0;
+      if (equal) {
+         equal = pread(fd, &reference_count, sizeof(uint64_t), 0) == sizeof(uint64_t);
+         reference_count++;
+         equal = equal && pwrite(fd, &reference_count, sizeof(uint64_t), 0) == sizeof(uint64_t) && fsync(fd) == 0;
+         close(fd);
+         return equal;
+      }
+      close(fd);
+   }
+}
+
+int store_chunks(MPI_Comm comm, const void *data, MPI_Aint size, MPI_Win_pmem_chunk_reference **references, uint64_t *chunks_count) {
+   int result, lock, directory;
+   uint64_t i, new_chunks_count = 0;
+   void *buffer;
+   bool stored = true, created;
+   char path[MPI_PMEM_CHUNK_PATH_LENGTH];
+
+   *chunks_count = (size + MPI_PMEM_CHUNK_SIZE - 1) / MPI_PMEM_CHUNK_SIZE;
+   *references = malloc((*chunks_count > 0 ? *chunks_count : 1) * sizeof(MPI_Win_pmem_chunk_reference));
+   buffer = malloc(MPI_PMEM_CHUNK_SIZE);
+   if (*references == NULL || buffer == NULL) {
+      free(*references);
+      free(buffer);
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+
+   result = lock_chunk_store(comm, &lock);
+   if (result != MPI_SUCCESS) {
+      free(*references);
+      free(buffer);
+      return result;
+   }
+   for (i = 0; stored && i < *chunks_count; i++) {
+      (*references)[i].size = i + 1 < *chunks_count ? MPI_PMEM_CHUNK_SIZE : size - i * MPI_PMEM_CHUNK_SIZE;
+      (*references)[i].hash = hash_chunk((const unsigned char*) data + i * MPI_PMEM_CHUNK_SIZE, (*references)[i].size);
+      stored = store_chunk((const unsigned char*) data + i * MPI_PMEM_CHUNK_SIZE, &(*references)[i], buffer, &created);
+      if (created) {
+         new_chunks_count++;
+      }
+   }
+   if (new_chunks_count > 0) {
+      // Sync also chunk store directory.
+      sprintf(path, "%s/.chunks", mpi_pmem_root_path);
+      directory = open(path, O_RDONLY);
+      fsync(directory);
+      close(directory);
+   }
+   close(lock);
+   free(buffer);
+
+   if (!stored) {
+      // References to already stored chunks are leaked, which wastes space but never loses data.
+      mpi_log_error("Unable to store checkpoint chunk.");
+      free(*references);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   mpi_log_debug("Checkpoint stored as %lu chunks, %lu of them new.", (unsigned long) *chunks_count, (unsigned long) new_chunks_count);
+
+   return MPI_SUCCESS;
+}
+
+MPI_Aint chunked_checkpoint_size(uint64_t chunks_count) {
+   return sizeof(MPI_Win_pmem_chunked_header) + chunks_count * sizeof(MPI_Win_pmem_chunk_reference);
+}
+
+int write_chunked_checkpoint(MPI_Win_pmem_checkpoint_writer *writer, MPI_Aint size, const MPI_Win_pmem_chunk_reference *references, uint64_t chunks_count) {
+   int result;
+   MPI_Win_pmem_chunked_header header;
+
+   header.magic = MPI_PMEM_CHUNKED_CHECKPOINT_MAGIC;
+   header.window_size = size;
+   header.chunk_size = MPI_PMEM_CHUNK_SIZE;
+   header.chunks_count = chunks_count;
+   result = write_checkpoint_data(writer, &header, sizeof(MPI_Win_pmem_chunked_header));
+   CHECK_ERROR_CODE(result);
+
+   return write_checkpoint_data(writer, references, chunks_count * sizeof(MPI_Win_pmem_chunk_reference));
+}
+
+/**
+ * Read header and references to chunks from deduplicated checkpoint file.
+ *
+ * @param comm        Communicator used for error handling.
+ * @param file_name   Name of checkpoint file.
+ * @param header      Output variable for header of checkpoint file.
+ * @param references  Output variable for array of references (must be freed by the caller).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int read_chunked_checkpoint(MPI_Comm comm, const char *file_name, MPI_Win_pmem_chunked_header *header, MPI_Win_pmem_chunk_reference **references) {
+   int fd;
+   bool valid;
+   ssize_t references_size;
+
+   if ((fd = open(file_name, O_RDONLY)) < 0) {
+      mpi_log_error("Checkpoint file '%s' doesn't exist.", file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   *references = NULL;
+   valid = pread(fd, header, sizeof(MPI_Win_pmem_chunked_header), 0) == sizeof(MPI_Win_pmem_chunked_header) && header->magic == MPI_PMEM_CHUNKED_CHECKPOINT_MAGIC &&
+           header->chunk_size > 0 && header->chunks_count == (header->window_size + header->chunk_size - 1) / header->chunk_size;
+   if (valid) {
+      references_size = header->chunks_count * sizeof(MPI_Win_pmem_chunk_reference);
+      *references = malloc(references_size > 0 ? references_size : 1);
+      if (*references == NULL) {
+         close(fd);
+         mpi_log_error("Unable to allocate memory.");
+         call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+         return MPI_ERR_PMEM_NO_MEM;
+      }
+      valid = pread(fd, *references, references_size, sizeof(MPI_Win_pmem_chunked_header)) == references_size;
+   }
+   close(fd);
+
+   if (!valid) {
+      free(*references);
+      mpi_log_error("Checkpoint file '%s' is corrupted.", file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   return MPI_SUCCESS;
+}
+
+int restore_chunked_checkpoint(MPI_Comm comm, const char *file_name, MPI_Aint size, void *destination) {
+   int result, fd = -1;
+   uint64_t i;
+   MPI_Win_pmem_chunked_header header;
+   MPI_Win_pmem_chunk_reference *references;
+   char path[MPI_PMEM_CHUNK_PATH_LENGTH];
+   bool valid;
+
+   result = read_chunked_checkpoint(comm, file_name, &header, &references);
+   CHECK_ERROR_CODE(result);
+   valid = header.window_size == (uint64_t) size;
+   for (i = 0; valid && i < header.chunks_count; i++) {
+      sprintf(path, "%s/.chunks/%016lx-%u", mpi_pmem_root_path, (unsigned long) references[i].hash, references[i].collision);
+      valid = references[i].size == (i + 1 < header.chunks_count ? header.chunk_size : size - i * header.chunk_size) && (fd = open(path, O_RDONLY)) >= 0;
+      if (valid) {
+         valid = pread(fd, (unsigned char*) destination + i * header.chunk_size, references[i].size, sizeof(uint64_t)) == references[i].size;
+         close(fd);
+      }
+   }
+   free(references);
+
+   if (!valid) {
+      mpi_log_error("Checkpoint file '%s' refers to missing or corrupted chunk.", file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   return MPI_SUCCESS;
+}
+
+int release_checkpoint_chunks(MPI_Comm comm, const char *file_name, char format) {
+   int result, lock, fd;
+   uint64_t i, reference_count;
+   MPI_Win_pmem_chunked_header header;
+   MPI_Win_pmem_chunk_reference *references;
+   char path[MPI_PMEM_CHUNK_PATH_LENGTH];
+
+   if (format != MPI_PMEM_CHECKPOINT_CHUNKED) {
+      return MPI_SUCCESS;
+   }
+
+   result = read_chunked_checkpoint(comm, file_name, &header, &references);
+   CHECK_ERROR_CODE(result);
+   result = lock_chunk_store(comm, &lock);
+   if (result != MPI_SUCCESS) {
+      free(references);
+      return result;
+   }
+   for (i = 0; i < header.chunks_count; i++) {
+      sprintf(path, "%s/.chunks/%016lx-%u", mpi_pmem_root_path, (unsigned long) references[i].hash, references[i].collision);
+      if ((fd = open(path, O_RDWR)) < 0) {
+         mpi_log_debug("Chunk '%s' doesn't exist.", path);
+         continue;
+      }
+      if (pread(fd, &reference_count, sizeof(uint64_t), 0) == sizeof(uint64_t) && reference_count > 1) {
+         reference_count--;
+         if (pwrite(fd, &reference_count, sizeof(uint64_t), 0) == sizeof(uint64_t)) {
+            fsync(fd);
+         }
+         close(fd);
+      } else {
+         close(fd);
+         reclaim_file(mpi_pmem_root_path, path);
+      }
+   }
+   close(lock);
+   free(references);
+
+   return MPI_SUCCESS;
+}
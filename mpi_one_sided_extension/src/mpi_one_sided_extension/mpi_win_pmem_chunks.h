@@ -0,0 +1,120 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_CHUNKS_H__
+#define __MPI_WIN_PMEM_CHUNKS_H__
+
+#include <stdint.h>
+#include <mpi.h>
+#include "mpi_win_pmem.h"
+#include "mpi_win_pmem_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MPI_PMEM_CHUNK_SIZE (1024 * 1024)
+#define MPI_PMEM_CHUNKED_CHECKPOINT_MAGIC 0x4b4e4843434d4d50ULL // "PMMCCHNK"
+
+// Header of deduplicated checkpoint file. It is followed by array of references to chunks stored in chunk store (<root>/.chunks).
+typedef struct {
+   uint64_t magic;
+   uint64_t window_size;
+   uint64_t chunk_size;
+   uint64_t chunks_count;
+} MPI_Win_pmem_chunked_header;
+
+// Reference to chunk stored in file <root>/.chunks/<hash>-<collision> which starts with reference count followed by chunk data.
+typedef struct {
+   uint64_t hash;
+   uint32_t collision;  // Index distinguishing different chunks with equal hash.
+   uint32_t size;
+} MPI_Win_pmem_chunk_reference;
+
+/**
+ * Store chunks of memory area in chunk store. Chunks which are already stored have their reference count increased, so only new chunks are written.
+ *
+ * @param comm          Communicator used for error handling.
+ * @param data          Memory area to store.
+ * @param size          Size of memory area.
+ * @param references    Output variable for array of references to stored chunks (must be freed by the caller).
+ * @param chunks_count  Output variable for number of chunks.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int store_chunks(MPI_Comm comm, const void *data, MPI_Aint size, MPI_Win_pmem_chunk_reference **references, uint64_t *chunks_count);
+
+/**
+ * Calculate size of deduplicated checkpoint file.
+ *
+ * @param chunks_count  Number of chunks referenced by checkpoint.
+ *
+ * @returns Size of checkpoint file in bytes.
+ */
+MPI_Aint chunked_checkpoint_size(uint64_t chunks_count);
+
+/**
+ * Write deduplicated checkpoint (list of references to chunks) into opened checkpoint file.
+ *
+ * @param writer        Writer of checkpoint file opened with size returned by chunked_checkpoint_size.
+ * @param size          Size of window.
+ * @param references    References to chunks returned by store_chunks.
+ * @param chunks_count  Number of chunks.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int write_chunked_checkpoint(MPI_Win_pmem_checkpoint_writer *writer, MPI_Aint size, const MPI_Win_pmem_chunk_reference *references, uint64_t chunks_count);
+
+/**
+ * Copy data of deduplicated checkpoint into memory area.
+ *
+ * @param comm         Communicator used for error handling.
+ * @param file_name    Name of checkpoint file.
+ * @param size         Size of memory area.
+ * @param destination  Memory area to copy data into.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int restore_chunked_checkpoint(MPI_Comm comm, const char *file_name, MPI_Aint size, void *destination);
+
+/**
+ * Decrease reference counts of chunks referenced by checkpoint file and remove chunks which aren't referenced anymore. Checkpoint file itself is not removed.
+ *
+ * @param comm       Communicator used for error handling.
+ * @param file_name  Name of checkpoint file.
+ * @param format     Format of checkpoint saved in window's versions metadata file (function does nothing for formats other than MPI_PMEM_CHECKPOINT_CHUNKED).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int release_checkpoint_chunks(MPI_Comm comm, const char *file_name, char format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
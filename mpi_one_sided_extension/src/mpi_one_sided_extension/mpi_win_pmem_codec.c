@@ -0,0 +1,453 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_codec.h"
+#include <stdlib.h>
+#include <string.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem_helper.h"
+
+#define MPI_PMEM_LZ_HASH_LOG 16
+#define MPI_PMEM_LZ_MIN_MATCH 4
+#define MPI_PMEM_LZ_MAX_OFFSET 65535
+#define MPI_PMEM_LZ_LAST_LITERALS 8   // Matches never cover last bytes of data.
+#define MPI_PMEM_LZ_SKIP_TRIGGER 6    // Step between tried positions grows with every 2^6 positions without match.
+
+static uint64_t lz_compress_bound(uint64_t size);
+static uint64_t lz_compress(const void *source, uint64_t size, void *destination, uint64_t capacity);
+static bool lz_decompress(const void *source, uint64_t size, void *destination, uint64_t raw_size);
+
+static const MPI_Win_pmem_codec codecs[] = {
+   { MPI_PMEM_CODEC_NONE, "none", 0, NULL, NULL, NULL },
+   { MPI_PMEM_CODEC_LZ, "lz", 0, lz_compress_bound, lz_compress, lz_decompress },
+   { MPI_PMEM_CODEC_SHUFFLE_LZ, "shuffle_lz", sizeof(double), lz_compress_bound, lz_compress, lz_decompress }
+};
+
+/**
+ * Calculate maximum size of data compressed with LZ codec.
+ *
+ * @param size  Size of data before compression.
+ *
+ * @returns Maximum size of compressed data.
+ */
+static uint64_t lz_compress_bound(uint64_t size) {
+   return size + size / 255 + 16;
+}
+
+/**
+ * Write length which doesn't fit into 4 bits of sequence token as series of bytes (each byte equal to 255 means that next byte follows).
+ *
+ * @param position  Position in output buffer.
+ * @param end       End of output buffer.
+ * @param length    Length reduced by 15.
+ *
+ * @returns Position after written length or NULL if output buffer is too small.
+ */
+static unsigned char *write_length(unsigned char *position, unsigned char *end, uint64_t length) {
+   while (length >= 255) {
+      if (position == end) {
+         return NULL;
+      }
+      *position++ = 255;
+      length -= 255;
+   }
+   if (position == end) {
+      return NULL;
+   }
+   *position++ = (unsigned char) length;
+
+   return position;
+}
+
+/**
+ * Write sequence consisting of literals followed by match (match is omitted if match_length is 0).
+ *
+ * @param position       Position in output buffer.
+ * @param end            End of output buffer.
+ * @param literals       Literal bytes.
+ * @param literals_count Number of literal bytes.
+ * @param offset         Distance between match and its earlier occurrence.
+ * @param match_length   Length of match (0 for last sequence).
+ *
+ * @returns Position after written sequence or NULL if output buffer is too small.
+ */
+static unsigned char *write_sequence(unsigned char *position, unsigned char *end, const unsigned char *literals, uint64_t literals_count, uint64_t offset,
+                                     uint64_t match_length) {
+   unsigned char *token;
+   uint64_t encoded_match_length = match_length > 0 ? match_length - MPI_PMEM_LZ_MIN_MATCH : 0;
+
+   if (position == end) {
+      return NULL;
+   }
+   token = position++;
+   *token = (unsigned char) ((literals_count < 15 ? literals_count : 15) << 4);
+   if (literals_count >= 15 && (position = write_length(position, end, literals_count - 15)) == NULL) {
+      return NULL;
+   }
+   if ((uint64_t) (end - position) < literals_count) {
+      return NULL;
+   }
+   memcpy(position, literals, literals_count);
+   position += literals_count;
+   if (match_length == 0) {
+      return position;
+   }
+
+   if (end - position < 2) {
+      return NULL;
+   }
+   *position++ = (unsigned char) (offset & 0xff);
+   *position++ = (unsigned char) (offset >> 8);
+   *token |= (unsigned char) (encoded_match_length < 15 ? encoded_match_length : 15);
+   if (encoded_match_length >= 15 && (position = write_length(position, end, encoded_match_length - 15)) == NULL) {
+      return NULL;
+   }
+
+   return position;
+}
+
+/**
+ * Compress data with LZ codec. Data is stored as sequences of literals and matches referring to data up to 64KB back (format similar to LZ4 block format).
+ *
+ * @param source       Data to compress.
+ * @param size         Size of data.
+ * @param destination  Output buffer.
+ * @param capacity     Size of output buffer.
+ *
+ * @returns Size of compressed data or 0 if data doesn't fit into output buffer.
+ */
+static uint64_t lz_compress(const void *source, uint64_t size, void *destination, uint64_t capacity) {
+   const unsigned char *input = source;
+   const unsigned char *anchor = input;
+   const unsigned char *match_limit = size > MPI_PMEM_LZ_LAST_LITERALS ? input + size - MPI_PMEM_LZ_LAST_LITERALS : input;
+   unsigned char *output = destination;
+   unsigned char *output_end = output + capacity;
+   uint64_t position, candidate, match_length, misses, *table;
+   uint32_t sequence, hash;
+
+   // Table contains last position (increased by 1) of every hashed 4-byte sequence, 0 means empty slot.
+   table = calloc((size_t) 1 << MPI_PMEM_LZ_HASH_LOG, sizeof(uint64_t));
+   if (table == NULL) {
+      return 0;
+   }
+
+   position = 0;
+   misses = 0;
+   while (input + position + MPI_PMEM_LZ_MIN_MATCH <= match_limit) {
+      memcpy(&sequence, input + position, sizeof(uint32_t));
+      hash = (sequence * 2654435761U) >> (32 - MPI_PMEM_LZ_HASH_LOG);
+      candidate = table[hash];
+      table[hash] = position + 1;
+      if (candidate == 0 || position + 1 - candidate > MPI_PMEM_LZ_MAX_OFFSET || memcmp(input + candidate - 1, input + position, MPI_PMEM_LZ_MIN_MATCH) != 0) {
+         // Skip faster through data which doesn't compress.
+         position += 1 + (misses++ >> MPI_PMEM_LZ_SKIP_TRIGGER);
+         continue;
+      }
+      misses = 0;
+      candidate--;
+
+      match_length = MPI_PMEM_LZ_MIN_MATCH;
+      while (input + position + match_length + sizeof(uint64_t) <= match_limit &&
+             memcmp(input + candidate + match_length, input + position + match_length, sizeof(uint64_t)) == 0) {
+         match_length += sizeof(uint64_t);
+      }
+      while (input + position + match_length < match_limit && input[candidate + match_length] == input[position + match_length]) {
+         match_length++;
+      }
+
+      output = write_sequence(output, output_end, anchor, input + position - anchor, position - candidate, match_length);
+      if (output == NULL) {
+         free(table);
+         return 0;
+      }
+      position += match_length;
+      anchor = input + position;
+   }
+
+   // Remaining bytes are stored as literals.
+   output = write_sequence(output, output_end, anchor, input + size - anchor, 0, 0);
+   free(table);
+   if (output == NULL) {
+      return 0;
+   }
+
+   return output - (unsigned char*) destination;
+}
+
+/**
+ * Read length stored as series of bytes following sequence token.
+ *
+ * @param position  Pointer to position in input buffer (advanced past read length).
+ * @param end       End of input buffer.
+ * @param length    Length to which read value is added.
+ *
+ * @returns True if length was read, false if input is truncated.
+ */
+static bool read_length(const unsigned char **position, const unsigned char *end, uint64_t *length) {
+   unsigned char byte;
+
+   do {
+      if (*position == end) {
+         return false;
+      }
+      byte = *(*position)++;
+      *length += byte;
+   } while (byte == 255);
+
+   return true;
+}
+
+/**
+ * Decompress data compressed with LZ codec.
+ *
+ * @param source       Compressed data.
+ * @param size         Size of compressed data.
+ * @param destination  Output buffer.
+ * @param raw_size     Size of data before compression.
+ *
+ * @returns True if data was decompressed, false if compressed data is corrupted.
+ */
+static bool lz_decompress(const void *source, uint64_t size, void *destination, uint64_t raw_size) {
+   const unsigned char *input = source;
+   const unsigned char *input_end = input + size;
+   unsigned char *output = destination;
+   unsigned char *output_end = output + raw_size;
+   const unsigned char *match;
+   unsigned char token;
+   uint64_t literals_count, match_length, offset, copied;
+
+   while (input < input_end) {
+      token = *input++;
+      literals_count = token >> 4;
+      if (literals_count == 15 && !read_length(&input, input_end, &literals_count)) {
+         return false;
+      }
+      if ((uint64_t) (input_end - input) < literals_count || (uint64_t) (output_end - output) < literals_count) {
+         return false;
+      }
+      memcpy(output, input, literals_count);
+      input += literals_count;
+      output += literals_count;
+      if (input == input_end) {
+         // Last sequence contains only literals.
+         break;
+      }
+
+      if (input_end - input < 2) {
+         return false;
+      }
+      offset = input[0] | ((uint64_t) input[1] << 8);
+      input += 2;
+      match_length = token & 15;
+      if (match_length == 15 && !read_length(&input, input_end, &match_length)) {
+         return false;
+      }
+      match_length += MPI_PMEM_LZ_MIN_MATCH;
+      if (offset == 0 || offset > (uint64_t) (output - (unsigned char*) destination) || (uint64_t) (output_end - output) < match_length) {
+         return false;
+      }
+
+      // Overlapping match repeats last offset bytes, so it is copied in chunks which double with every step.
+      match = output - offset;
+      while (match_length > 0) {
+         copied = match_length < (uint64_t) (output - match) ? match_length : (uint64_t) (output - match);
+         memcpy(output, match, copied);
+         output += copied;
+         match_length -= copied;
+      }
+   }
+
+   return output == output_end;
+}
+
+/**
+ * Group bytes of elements by their position in element (all first bytes, then all second bytes etc.), so similar bytes of floating point numbers are stored next to each other.
+ *
+ * @param source        Data to shuffle.
+ * @param destination   Output buffer.
+ * @param size          Size of data.
+ * @param element_size  Size of single element.
+ */
+static void shuffle_bytes(const unsigned char *source, unsigned char *destination, uint64_t size, int element_size) {
+   uint64_t i, elements_count = size / element_size;
+   int j;
+
+   for (j = 0; j < element_size; j++) {
+      for (i = 0; i < elements_count; i++) {
+         destination[j * elements_count + i] = source[i * element_size + j];
+      }
+   }
+   memcpy(destination + elements_count * element_size, source + elements_count * element_size, size - elements_count * element_size);
+}
+
+/**
+ * Reverse shuffle_bytes.
+ *
+ * @param source        Shuffled data.
+ * @param destination   Output buffer.
+ * @param size          Size of data.
+ * @param element_size  Size of single element.
+ */
+static void unshuffle_bytes(const unsigned char *source, unsigned char *destination, uint64_t size, int element_size) {
+   uint64_t i, elements_count = size / element_size;
+   int j;
+
+   for (j = 0; j < element_size; j++) {
+      for (i = 0; i < elements_count; i++) {
+         destination[i * element_size + j] = source[j * elements_count + i];
+      }
+   }
+   memcpy(destination + elements_count * element_size, source + elements_count * element_size, size - elements_count * element_size);
+}
+
+const MPI_Win_pmem_codec *find_codec_by_name(const char *name) {
+   size_t i;
+
+   for (i = 0; i < sizeof(codecs) / sizeof(MPI_Win_pmem_codec); i++) {
+      if (strcmp(codecs[i].name, name) == 0) {
+         return &codecs[i];
+      }
+   }
+
+   return NULL;
+}
+
+const MPI_Win_pmem_codec *find_codec(char id) {
+   size_t i;
+
+   for (i = 0; i < sizeof(codecs) / sizeof(MPI_Win_pmem_codec); i++) {
+      if (codecs[i].id == id) {
+         return &codecs[i];
+      }
+   }
+
+   return NULL;
+}
+
+int compress_checkpoint(MPI_Comm comm, char codec, const void *data, MPI_Aint size, void **compressed, MPI_Aint *compressed_size) {
+   const MPI_Win_pmem_codec *checkpoint_codec = find_codec(codec);
+   MPI_Win_pmem_compressed_header *header;
+   void *shuffled = NULL;
+   uint64_t capacity, data_size;
+
+   *compressed = NULL;
+   if (checkpoint_codec == NULL || checkpoint_codec->compress == NULL) {
+      return MPI_SUCCESS;
+   }
+
+   capacity = checkpoint_codec->compress_bound(size);
+   header = malloc(sizeof(MPI_Win_pmem_compressed_header) + capacity);
+   if (header != NULL && checkpoint_codec->shuffle_element_size > 0) {
+      shuffled = malloc(size);
+      if (shuffled == NULL) {
+         free(header);
+         header = NULL;
+      }
+   }
+   if (header == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+
+   if (shuffled != NULL) {
+      shuffle_bytes(data, shuffled, size, checkpoint_codec->shuffle_element_size);
+      data = shuffled;
+   }
+   data_size = checkpoint_codec->compress(data, size, header + 1, capacity);
+   free(shuffled);
+
+   // Data which doesn't compress is saved uncompressed.
+   if (data_size == 0 || sizeof(MPI_Win_pmem_compressed_header) + data_size >= (uint64_t) size) {
+      mpi_log_debug("Checkpoint data isn't compressible with codec '%s'.", checkpoint_codec->name);
+      free(header);
+      return MPI_SUCCESS;
+   }
+
+   header->magic = MPI_PMEM_COMPRESSED_CHECKPOINT_MAGIC;
+   header->raw_size = size;
+   header->compressed_size = data_size;
+   *compressed = header;
+   *compressed_size = sizeof(MPI_Win_pmem_compressed_header) + data_size;
+   mpi_log_debug("Checkpoint data compressed with codec '%s' from %lu to %lu bytes.", checkpoint_codec->name, size, *compressed_size);
+
+   return MPI_SUCCESS;
+}
+
+int restore_compressed_checkpoint(MPI_Comm comm, const char *file_name, char codec, MPI_Aint size, void *destination) {
+   int result;
+   const MPI_Win_pmem_codec *checkpoint_codec = find_codec(codec);
+   MPI_Win_pmem_compressed_header *header;
+   off_t file_size;
+   void *shuffled = NULL;
+   bool decompressed;
+
+   if (checkpoint_codec == NULL || checkpoint_codec->decompress == NULL) {
+      mpi_log_error("Checkpoint file '%s' is compressed with unknown codec %d.", file_name, codec);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   if (checkpoint_codec->shuffle_element_size > 0) {
+      shuffled = malloc(size);
+      if (shuffled == NULL) {
+         mpi_log_error("Unable to allocate memory.");
+         call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+         return MPI_ERR_PMEM_NO_MEM;
+      }
+   }
+
+   result = get_file_size(comm, file_name, &file_size);
+   CHECK_ERROR_CODE(result);
+   if ((uint64_t) file_size < sizeof(MPI_Win_pmem_compressed_header)) {
+      mpi_log_error("Checkpoint file '%s' is corrupted.", file_name);
+      free(shuffled);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   result = open_pmem_file(comm, file_name, file_size, (void**) &header);
+   CHECK_ERROR_CODE(result);
+
+   decompressed = header->magic == MPI_PMEM_COMPRESSED_CHECKPOINT_MAGIC && header->raw_size == (uint64_t) size &&
+                  header->compressed_size <= file_size - sizeof(MPI_Win_pmem_compressed_header) &&
+                  checkpoint_codec->decompress(header + 1, header->compressed_size, shuffled != NULL ? shuffled : destination, size);
+   if (decompressed && shuffled != NULL) {
+      unshuffle_bytes(shuffled, destination, size, checkpoint_codec->shuffle_element_size);
+   }
+   free(shuffled);
+   result = unmap_pmem_file(comm, header, file_size);
+   CHECK_ERROR_CODE(result);
+   if (!decompressed) {
+      mpi_log_error("Checkpoint file '%s' is corrupted.", file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   return MPI_SUCCESS;
+}
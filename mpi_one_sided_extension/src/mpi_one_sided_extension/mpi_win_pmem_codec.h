@@ -0,0 +1,109 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_CODEC_H__
+#define __MPI_WIN_PMEM_CODEC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <mpi.h>
+#include "mpi_win_pmem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MPI_PMEM_COMPRESSED_CHECKPOINT_MAGIC 0x504d454d4c5a3031ULL // "PMEMLZ01"
+
+// Header of compressed checkpoint file. It is followed by compressed data.
+typedef struct {
+   uint64_t magic;
+   uint64_t raw_size;         // Size of data before compression.
+   uint64_t compressed_size;  // Size of compressed data following the header.
+} MPI_Win_pmem_compressed_header;
+
+// Checkpoint codec. New codecs are added to the table of codecs in mpi_win_pmem_codec.c.
+typedef struct {
+   char id;                   // Identifier saved in window's versions metadata file.
+   const char *name;          // Value of pmem_checkpoint_codec key.
+   int shuffle_element_size;  // Size of elements whose bytes are grouped before compression (0 if data isn't shuffled).
+   uint64_t (*compress_bound)(uint64_t size);
+   uint64_t (*compress)(const void *source, uint64_t size, void *destination, uint64_t capacity);
+   bool (*decompress)(const void *source, uint64_t size, void *destination, uint64_t raw_size);
+} MPI_Win_pmem_codec;
+
+/**
+ * Find codec with specified name.
+ *
+ * @param name  Name of codec.
+ *
+ * @returns Codec or NULL if there is no codec with such name.
+ */
+const MPI_Win_pmem_codec *find_codec_by_name(const char *name);
+
+/**
+ * Find codec with specified identifier.
+ *
+ * @param id  Identifier of codec.
+ *
+ * @returns Codec or NULL if there is no codec with such identifier.
+ */
+const MPI_Win_pmem_codec *find_codec(char id);
+
+/**
+ * Compress checkpoint data. Compressed data is preceded by MPI_Win_pmem_compressed_header.
+ *
+ * @param comm             Communicator used for error handling.
+ * @param codec            Identifier of codec.
+ * @param data             Data to compress.
+ * @param size             Size of data.
+ * @param compressed       Output variable for compressed checkpoint (must be freed by the caller). Set to NULL if data can't be compressed to smaller size.
+ * @param compressed_size  Output variable for size of compressed checkpoint including header.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int compress_checkpoint(MPI_Comm comm, char codec, const void *data, MPI_Aint size, void **compressed, MPI_Aint *compressed_size);
+
+/**
+ * Decompress checkpoint file into memory area.
+ *
+ * @param comm         Communicator used for error handling.
+ * @param file_name    Name of checkpoint file.
+ * @param codec        Identifier of codec used to compress checkpoint.
+ * @param size         Size of memory area.
+ * @param destination  Memory area to decompress data into.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int restore_compressed_checkpoint(MPI_Comm comm, const char *file_name, char codec, MPI_Aint size, void *destination);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
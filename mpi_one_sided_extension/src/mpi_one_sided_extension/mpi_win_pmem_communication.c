@@ -27,8 +27,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
 #include "mpi_win_pmem.h"
+#include "../common/error_codes.h"
+#include "mpi_win_pmem_dirty.h"
 
 int MPI_Put_pmem(const void *origin_addr, int origin_count, MPI_Datatype origin_datatype, int target_rank, MPI_Aint target_disp, int target_count, MPI_Datatype target_datatype, MPI_Win_pmem win) {
+   int result;
+
+   result = track_dirty_range(win, target_rank, target_disp, target_count, target_datatype);
+   CHECK_ERROR_CODE(result);
+
    return MPI_Put(origin_addr, origin_count, origin_datatype, target_rank, target_disp, target_count, target_datatype, win.win);
 }
 
@@ -38,24 +45,50 @@ int MPI_Get_pmem(void *origin_addr, int origin_count, MPI_Datatype origin_dataty
 
 int MPI_Accumulate_pmem(const void *origin_addr, int origin_count, MPI_Datatype origin_datatype, int target_rank, MPI_Aint target_disp,
                         int target_count, MPI_Datatype target_datatype, MPI_Op op, MPI_Win_pmem win) {
+   int result;
+
+   result = track_dirty_range(win, target_rank, target_disp, target_count, target_datatype);
+   CHECK_ERROR_CODE(result);
+
    return MPI_Accumulate(origin_addr, origin_count, origin_datatype, target_rank, target_disp, target_count, target_datatype, op, win.win);
 }
 
 int MPI_Get_accumulate_pmem(const void *origin_addr, int origin_count, MPI_Datatype origin_datatype, void *result_addr, int result_count, MPI_Datatype result_datatype,
                             int target_rank, MPI_Aint target_disp, int target_count, MPI_Datatype target_datatype, MPI_Op op, MPI_Win_pmem win) {
+   int result;
+
+   // MPI_NO_OP only reads target buffer.
+   result = op == MPI_NO_OP ? MPI_SUCCESS : track_dirty_range(win, target_rank, target_disp, target_count, target_datatype);
+   CHECK_ERROR_CODE(result);
+
    return MPI_Get_accumulate(origin_addr, origin_count, origin_datatype, result_addr, result_count, result_datatype, target_rank, target_disp, target_count, target_datatype, op, win.win);
 }
 
 int MPI_Fetch_and_op_pmem(const void *origin_addr, void *result_addr, MPI_Datatype datatype, int target_rank, MPI_Aint target_disp, MPI_Op op, MPI_Win_pmem win) {
+   int result;
+
+   result = op == MPI_NO_OP ? MPI_SUCCESS : track_dirty_range(win, target_rank, target_disp, 1, datatype);
+   CHECK_ERROR_CODE(result);
+
    return MPI_Fetch_and_op(origin_addr, result_addr, datatype, target_rank, target_disp, op, win.win);
 }
 
 int MPI_Compare_and_swap_pmem(const void *origin_addr, const void *compare_addr, void *result_addr, MPI_Datatype datatype, int target_rank, MPI_Aint target_disp, MPI_Win_pmem win) {
+   int result;
+
+   result = track_dirty_range(win, target_rank, target_disp, 1, datatype);
+   CHECK_ERROR_CODE(result);
+
    return MPI_Compare_and_swap(origin_addr, compare_addr, result_addr, datatype, target_rank, target_disp, win.win);
 }
 
 int MPI_Rput_pmem(const void *origin_addr, int origin_count, MPI_Datatype origin_datatype, int target_rank, MPI_Aint target_disp,
                   int target_count, MPI_Datatype target_datatype, MPI_Win_pmem win, MPI_Request *request) {
+   int result;
+
+   result = track_dirty_range(win, target_rank, target_disp, target_count, target_datatype);
+   CHECK_ERROR_CODE(result);
+
    return MPI_Rput(origin_addr, origin_count, origin_datatype, target_rank, target_disp, target_count, target_datatype, win.win, request);
 }
 
@@ -66,10 +99,20 @@ int MPI_Rget_pmem(void *origin_addr, int origin_count, MPI_Datatype origin_datat
 
 int MPI_Raccumulate_pmem(const void *origin_addr, int origin_count, MPI_Datatype origin_datatype, int target_rank, MPI_Aint target_disp,
                          int target_count, MPI_Datatype target_datatype, MPI_Op op, MPI_Win_pmem win, MPI_Request *request) {
+   int result;
+
+   result = track_dirty_range(win, target_rank, target_disp, target_count, target_datatype);
+   CHECK_ERROR_CODE(result);
+
    return MPI_Raccumulate(origin_addr, origin_count, origin_datatype, target_rank, target_disp, target_count, target_datatype, op, win.win, request);
 }
 
 int MPI_Rget_accumulate_pmem(const void *origin_addr, int origin_count, MPI_Datatype origin_datatype, void *result_addr, int result_count, MPI_Datatype result_datatype,
                              int target_rank, MPI_Aint target_disp, int target_count, MPI_Datatype target_datatype, MPI_Op op, MPI_Win_pmem win, MPI_Request *request) {
+   int result;
+
+   result = op == MPI_NO_OP ? MPI_SUCCESS : track_dirty_range(win, target_rank, target_disp, target_count, target_datatype);
+   CHECK_ERROR_CODE(result);
+
    return MPI_Rget_accumulate(origin_addr, origin_count, origin_datatype, result_addr, result_count, result_datatype, target_rank, target_disp, target_count, target_datatype, op, win.win, request);
 }
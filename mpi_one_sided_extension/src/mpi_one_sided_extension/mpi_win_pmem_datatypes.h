@@ -30,7 +30,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define __MPI_WIN_PMEM_DATATYPES_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
+#include <sys/types.h>
 #include <mpi.h>
 
 #ifdef __cplusplus
@@ -48,14 +50,37 @@ extern "C" {
 #define MPI_PMEM_FLAG_OBJECT_EXISTS 1
 #define MPI_PMEM_FLAG_OBJECT_DELETED 3
 
+// Checkpoint formats saved in window's versions metadata file.
+#define MPI_PMEM_CHECKPOINT_FULL 0
+#define MPI_PMEM_CHECKPOINT_INCREMENTAL 1
+#define MPI_PMEM_CHECKPOINT_EXTENTS 2
+#define MPI_PMEM_CHECKPOINT_CHUNKED 3
+#define MPI_PMEM_CHECKPOINT_AGGREGATED 4
+#define MPI_PMEM_CHECKPOINT_DELTA 5
+#define MPI_PMEM_CHECKPOINT_SLOT 6
+
+// Checkpoint codecs saved in window's versions metadata file.
+#define MPI_PMEM_CODEC_NONE 0
+#define MPI_PMEM_CODEC_LZ 1
+#define MPI_PMEM_CODEC_SHUFFLE_LZ 2
+
 typedef struct MPI_Win_pmem_structure MPI_Win_pmem;
 typedef struct MPI_Win_pmem_modifiable_structure MPI_Win_pmem_modifiable;
 typedef struct MPI_Win_memory_areas_list_structure MPI_Win_memory_areas_list;
+typedef struct MPI_Win_memory_areas_index_structure MPI_Win_memory_areas_index;
 typedef struct MPI_Win_pmem_metadata_structure MPI_Win_pmem_metadata;
 typedef struct MPI_Win_pmem_version_structure MPI_Win_pmem_version;
+typedef struct MPI_Win_pmem_epoch_structure MPI_Win_pmem_epoch;
 typedef struct MPI_Win_pmem_windows_structure MPI_Win_pmem_windows;
 typedef struct MPI_Win_pmem_window_structure MPI_Win_pmem_window;
 typedef struct MPI_Win_pmem_versions_structure MPI_Win_pmem_versions;
+typedef struct MPI_Win_pmem_checkpoint_structure MPI_Win_pmem_checkpoint;
+typedef struct MPI_Win_pmem_copy_pool_structure MPI_Win_pmem_copy_pool;
+typedef struct MPI_Win_pmem_dirty_tracker_structure MPI_Win_pmem_dirty_tracker;
+typedef struct MPI_Win_pmem_throttle_structure MPI_Win_pmem_throttle;
+typedef struct MPI_Win_pmem_aggregator_structure MPI_Win_pmem_aggregator;
+typedef struct MPI_Win_pmem_lazy_restore_structure MPI_Win_pmem_lazy_restore;
+typedef struct MPI_Win_pmem_slot_ring_structure MPI_Win_pmem_slot_ring;
 
 // Structure containing information about window.
 struct MPI_Win_pmem_structure {
@@ -67,6 +92,25 @@ struct MPI_Win_pmem_structure {
    bool is_volatile;
    bool append_checkpoints;
    bool global_checkpoint;
+   bool incremental_checkpoints;    // Save only pages modified since previous checkpoint.
+   int full_checkpoint_interval;    // Every n-th checkpoint in incremental or delta mode is a full one.
+   bool delta_checkpoints;          // Save XOR of window data and previous checkpoint, stored only for runs of changed words.
+   bool async_checkpoints;          // Write checkpoints in background thread.
+   int checkpoint_threads;          // Number of threads copying checkpoint data.
+   char checkpoint_codec;           // Codec used to compress full checkpoints.
+   bool dedup_checkpoints;          // Store full checkpoints as references to chunks in chunk store shared by all versions.
+   bool zero_copy_restore;          // Use checkpoint file as window memory instead of copying it.
+   bool lazy_restore;               // Restore window allocated in RAM from checkpoint on demand (on page faults) instead of copying it at once.
+   bool aggregate_checkpoints;      // Write checkpoints created in MPI_Win_fence_pmem_persist by processes of the same node to one file.
+   int checkpoint_mtbf;             // Mean time between failures in seconds used to schedule checkpoints (0 if every persist call creates checkpoint).
+   int checkpoint_overhead;         // Maximum percentage of run time spent on scheduled checkpoints (0 if not limited).
+   bool track_dirty_ranges;         // Persist only ranges modified by RMA operations in MPI_Win_fence_pmem_persist.
+   int checkpoint_writers;          // Maximum number of processes of the same socket writing global checkpoints concurrently (0 if not limited).
+   int checkpoint_rate;             // Maximum rate of writing checkpoints in background in MB/s (0 if not limited).
+   int stripe_size;                 // Size of stripes of window data distributed over root paths set by MPI_Win_pmem_set_root_paths (0 if not striped).
+   bool map_sync;                   // Map window data with synchronous page faults (MAP_SYNC) if file system supports them.
+   bool prefault;                   // Fault in all pages of window data when window is allocated.
+   int checkpoint_slots;            // Number of preallocated checkpoint files reused round-robin (0 if every checkpoint is written to new file).
    char name[MPI_PMEM_MAX_NAME];
    int mode;
    MPI_Win_pmem_modifiable *modifiable_values;
@@ -79,15 +123,44 @@ struct MPI_Win_pmem_modifiable_structure {
    int last_checkpoint_version;     // Checkpoint version saved last time.
    int next_checkpoint_version;     // Checkpoint version that should be created next time.
    int highest_checkpoint_version;  // Highest checkpoint version of this window that was found in window's versions metadata file. This equals to index of terminating record - 1.
+   int checkpoint_chain_length;     // Number of incremental checkpoints saved since last full checkpoint.
+   uint64_t *page_digests;          // Digests of window pages saved in last checkpoint (used in incremental mode).
+   bool page_digests_valid;
+   void *delta_reference;           // Window data saved in last checkpoint (used in delta mode, NULL if it isn't known).
+   MPI_Win_pmem_checkpoint *pending_checkpoint; // Checkpoint written in background, which wasn't completed yet.
+   MPI_Win_pmem_checkpoint *queued_checkpoint;  // Written checkpoint created in MPI_Win_fence, which is committed by next collective call (NULL if there is none).
+   void *checkpoint_staging_buffer; // Snapshot of window data used by checkpoint written in background.
+   MPI_Win_pmem_copy_pool *copy_pool; // Threads copying checkpoint data (NULL if data is copied by calling thread only).
+   int next_area_id;                // Identifier assigned to next memory area attached to dynamic window.
+   bool restore_on_attach;          // Memory areas attached to dynamic window are filled with data from last checkpoint.
    MPI_Win_memory_areas_list *memory_areas;
+   MPI_Win_memory_areas_index *areas_index; // Memory areas ordered by base address (NULL if no area was added yet).
+   MPI_Win_pmem_version *versions;  // Window's versions metadata file, mapped for the lifetime of window (NULL if it isn't mapped yet).
+   off_t versions_file_size;
+   int global_checkpoint_version;   // Checkpoint version saved by all processes, which isn't deleted until newer one is committed (-1 if there is none).
+   MPI_Win_pmem_epoch *epoch;       // Window's global epoch metadata file, mapped for the lifetime of window (NULL if it isn't mapped yet).
+   double checkpoint_cost;          // Estimated time of creating checkpoint in seconds (0 if it wasn't measured yet).
+   double last_checkpoint_time;     // Time (result of MPI_Wtime) when last checkpoint was created or window was created.
+   MPI_Win_pmem_dirty_tracker *dirty_tracker; // Ranges modified by RMA operations in current epoch (NULL if they aren't tracked).
+   MPI_Win_pmem_throttle *throttle; // Coordinator of checkpoint writes of processes on the same socket (NULL if writes aren't limited).
+   MPI_Win_pmem_aggregator *aggregator; // Aggregator of checkpoints of processes on the same node (NULL if checkpoints aren't aggregated).
+   void *shared_base;               // Data file of shared window mapped by all processes (NULL if window isn't shared).
+   MPI_Aint shared_size;            // Size of mapped data file of shared window.
+   MPI_Aint *shared_segments;       // Offset, size and displacement unit of segment of every process in data file of shared window.
+   MPI_Win_pmem_lazy_restore *lazy_restore; // Restore of window memory on demand (NULL if window was restored at once).
+   MPI_Win_pmem_slot_ring *slot_ring; // Preallocated checkpoint files (NULL if checkpoints aren't written to slots).
 };
 
-// List structure of memory areas attached to window.
+// List structure of memory areas attached to window. Areas are also linked in index ordered by base address (see mpi_win_pmem_areas.h).
 struct MPI_Win_memory_areas_list_structure {
    void *base;
    MPI_Aint size;
    bool is_pmem; // Is this memory real pmem (result of pmem_is_pmem)
+   int id;       // Order in which memory area was attached to window (used to match areas with extents saved in checkpoint).
    MPI_Win_memory_areas_list *next;
+   MPI_Win_memory_areas_list *previous;
+   int levels;   // Number of index levels in which area is linked.
+   MPI_Win_memory_areas_list *index_next[]; // Next area with higher base on every index level.
 };
 
 // Metadata structure about window. Saved in global metadata file.
@@ -95,13 +168,23 @@ struct MPI_Win_pmem_metadata_structure {
    char name[MPI_PMEM_MAX_NAME];
    MPI_Aint size;
    char flags;
+   int stripe_root_path; // Local root path index of process which created striped data file increased by 1 (0 if window isn't striped), placed in padding.
 };
 
 // Metadata structure about single window version. Saved in window's versions metadata file.
 struct MPI_Win_pmem_version_structure {
    int version;
    time_t timestamp;
-   char flags;
+   char flags;          // Flags, format, codec and parent_version share one 8-byte word, which is written with single store to commit record.
+   char format;         // Checkpoint format (full or incremental).
+   char codec;          // Codec used to compress checkpoint.
+   int parent_version;  // Version on which incremental checkpoint is based (-1 for full checkpoint, version in name of node checkpoint file for aggregated one, index of slot file for one saved in slot).
+};
+
+// Globally consistent checkpoint version of window. Saved in window's global epoch metadata file, both fields are written with single 8-byte store.
+struct MPI_Win_pmem_epoch_structure {
+   int version;   // Checkpoint version saved by all processes (-1 if record was invalidated).
+   int epoch;     // Number of global commits (0 if there was none).
 };
 
 // Metadata structure filled by MPI_Win_pmem_list.
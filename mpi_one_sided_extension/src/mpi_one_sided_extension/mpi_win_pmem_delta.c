@@ -0,0 +1,226 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_delta.h"
+#include <stdlib.h>
+#include <string.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem_helper.h"
+
+#define MPI_PMEM_DELTA_WORD_SIZE sizeof(uint64_t)
+#define MPI_PMEM_DELTA_BLOCK_SIZE 256 // Size of blocks compared at once while skipping unchanged data.
+
+/**
+ * XOR two memory areas word by word, so that loop is vectorized by compiler.
+ *
+ * @param destination  Output memory area (may be the same as first).
+ * @param first        First memory area.
+ * @param second       Second memory area.
+ * @param size         Size of memory areas.
+ */
+static void xor_data(unsigned char *destination, const unsigned char *first, const unsigned char *second, uint64_t size) {
+   uint64_t i, first_word, second_word;
+
+   for (i = 0; i + MPI_PMEM_DELTA_WORD_SIZE <= size; i += MPI_PMEM_DELTA_WORD_SIZE) {
+      memcpy(&first_word, first + i, MPI_PMEM_DELTA_WORD_SIZE);
+      memcpy(&second_word, second + i, MPI_PMEM_DELTA_WORD_SIZE);
+      first_word ^= second_word;
+      memcpy(destination + i, &first_word, MPI_PMEM_DELTA_WORD_SIZE);
+   }
+   for (; i < size; i++) {
+      destination[i] = first[i] ^ second[i];
+   }
+}
+
+/**
+ * Check whether word of window differs from previous checkpoint. Last word may be partial.
+ *
+ * @param data       Window data.
+ * @param reference  Data saved in previous checkpoint.
+ * @param size       Size of window.
+ * @param word       Index of word.
+ *
+ * @returns True if word was changed, false otherwise.
+ */
+static inline bool word_changed(const unsigned char *data, const unsigned char *reference, uint64_t size, uint64_t word) {
+   uint64_t offset = word * MPI_PMEM_DELTA_WORD_SIZE;
+
+   return memcmp(data + offset, reference + offset, size - offset < MPI_PMEM_DELTA_WORD_SIZE ? size - offset : MPI_PMEM_DELTA_WORD_SIZE) != 0;
+}
+
+/**
+ * Find runs of changed words. Runs are separated by at least MPI_PMEM_DELTA_RUN_GAP unchanged words.
+ *
+ * @param data       Window data.
+ * @param reference  Data saved in previous checkpoint.
+ * @param size       Size of window.
+ * @param runs       Output array for runs or NULL if runs should only be counted.
+ * @param data_size  Output variable for total size of runs.
+ *
+ * @returns Number of runs.
+ */
+static uint64_t find_changed_runs(const unsigned char *data, const unsigned char *reference, uint64_t size, MPI_Win_pmem_delta_run *runs, uint64_t *data_size) {
+   uint64_t words_count = (size + MPI_PMEM_DELTA_WORD_SIZE - 1) / MPI_PMEM_DELTA_WORD_SIZE;
+   uint64_t word = 0, start, end, runs_count = 0, offset;
+
+   *data_size = 0;
+   while (word < words_count) {
+      // Skip unchanged blocks using memcmp, which compares many bytes at once.
+      offset = word * MPI_PMEM_DELTA_WORD_SIZE;
+      while (offset + MPI_PMEM_DELTA_BLOCK_SIZE <= size && memcmp(data + offset, reference + offset, MPI_PMEM_DELTA_BLOCK_SIZE) == 0) {
+         offset += MPI_PMEM_DELTA_BLOCK_SIZE;
+      }
+      for (word = offset / MPI_PMEM_DELTA_WORD_SIZE; word < words_count && !word_changed(data, reference, size, word); word++) {
+      }
+      if (word == words_count) {
+         break;
+      }
+
+      // Extend run until enough unchanged words follow it.
+      start = word;
+      end = word + 1;
+      for (word = end; word < words_count && word < end + MPI_PMEM_DELTA_RUN_GAP; word++) {
+         if (word_changed(data, reference, size, word)) {
+            end = word + 1;
+         }
+      }
+      offset = end * MPI_PMEM_DELTA_WORD_SIZE < size ? end * MPI_PMEM_DELTA_WORD_SIZE : size;
+      if (runs != NULL) {
+         runs[runs_count].offset = start * MPI_PMEM_DELTA_WORD_SIZE;
+         runs[runs_count].size = offset - start * MPI_PMEM_DELTA_WORD_SIZE;
+      }
+      *data_size += offset - start * MPI_PMEM_DELTA_WORD_SIZE;
+      runs_count++;
+      word = end;
+   }
+
+   return runs_count;
+}
+
+/**
+ * XOR runs of delta into memory area.
+ *
+ * @param destination  Memory area.
+ * @param header       Header of encoded delta followed by runs and their data.
+ */
+static void apply_runs(unsigned char *destination, const MPI_Win_pmem_delta_header *header) {
+   uint64_t i;
+   const MPI_Win_pmem_delta_run *runs = (const MPI_Win_pmem_delta_run*) (header + 1);
+   const unsigned char *run_data = (const unsigned char*) (runs + header->runs_count);
+
+   for (i = 0; i < header->runs_count; i++) {
+      xor_data(destination + runs[i].offset, destination + runs[i].offset, run_data, runs[i].size);
+      run_data += runs[i].size;
+   }
+}
+
+int encode_delta(MPI_Comm comm, const void *data, const void *reference, MPI_Aint size, void **delta, MPI_Aint *delta_size) {
+   MPI_Win_pmem_delta_header *header;
+   MPI_Win_pmem_delta_run *runs;
+   unsigned char *run_data;
+   uint64_t i, runs_count, data_size;
+
+   // Runs are found twice: first to compute size of delta, then to fill it.
+   runs_count = find_changed_runs(data, reference, size, NULL, &data_size);
+   *delta_size = sizeof(MPI_Win_pmem_delta_header) + runs_count * sizeof(MPI_Win_pmem_delta_run) + data_size;
+   *delta = malloc(*delta_size);
+   if (*delta == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+
+   header = *delta;
+   header->magic = MPI_PMEM_DELTA_CHECKPOINT_MAGIC;
+   header->window_size = size;
+   header->runs_count = runs_count;
+   header->data_size = data_size;
+   runs = (MPI_Win_pmem_delta_run*) (header + 1);
+   find_changed_runs(data, reference, size, runs, &data_size);
+   run_data = (unsigned char*) (runs + runs_count);
+   for (i = 0; i < runs_count; i++) {
+      xor_data(run_data, (const unsigned char*) data + runs[i].offset, (const unsigned char*) reference + runs[i].offset, runs[i].size);
+      run_data += runs[i].size;
+   }
+   mpi_log_debug("Delta consists of %lu runs of %lu bytes.", (unsigned long) runs_count, (unsigned long) data_size);
+
+   return MPI_SUCCESS;
+}
+
+void apply_delta(void *destination, const void *delta) {
+   apply_runs(destination, delta);
+}
+
+int apply_delta_checkpoint(MPI_Comm comm, const char *file_name, MPI_Aint size, void *destination) {
+   int result;
+   off_t file_size;
+   void *checkpoint_data;
+   MPI_Win_pmem_delta_header *header;
+   MPI_Win_pmem_delta_run *runs;
+   uint64_t i, data_size, end;
+   bool valid;
+
+   result = get_file_size(comm, file_name, &file_size);
+   CHECK_ERROR_CODE(result);
+   if (file_size < (off_t) sizeof(MPI_Win_pmem_delta_header)) {
+      mpi_log_error("Delta checkpoint file '%s' is corrupted.", file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   result = open_pmem_file(comm, file_name, file_size, &checkpoint_data);
+   CHECK_ERROR_CODE(result);
+
+   // Validate header and runs before modifying destination.
+   header = checkpoint_data;
+   runs = (MPI_Win_pmem_delta_run*) (header + 1);
+   valid = header->magic == MPI_PMEM_DELTA_CHECKPOINT_MAGIC && header->window_size == (uint64_t) size && header->runs_count <= (uint64_t) size &&
+           header->data_size <= (uint64_t) size && (uint64_t) file_size == sizeof(MPI_Win_pmem_delta_header) + header->runs_count * sizeof(MPI_Win_pmem_delta_run) + header->data_size;
+   data_size = 0;
+   end = 0;
+   for (i = 0; valid && i < header->runs_count; i++) {
+      valid = runs[i].offset >= end && runs[i].offset <= (uint64_t) size && runs[i].size <= (uint64_t) size - runs[i].offset;
+      end = runs[i].offset + runs[i].size;
+      data_size += runs[i].size;
+   }
+   if (!valid || data_size != header->data_size) {
+      mpi_log_error("Delta checkpoint file '%s' is corrupted.", file_name);
+      unmap_pmem_file(comm, checkpoint_data, file_size);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   apply_runs(destination, header);
+   mpi_log_debug("Applied %lu runs from delta checkpoint file '%s'.", (unsigned long) header->runs_count, file_name);
+
+   result = unmap_pmem_file(comm, checkpoint_data, file_size);
+   CHECK_ERROR_CODE(result);
+
+   return MPI_SUCCESS;
+}
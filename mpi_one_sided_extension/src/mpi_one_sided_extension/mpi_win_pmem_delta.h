@@ -0,0 +1,95 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_DELTA_H__
+#define __MPI_WIN_PMEM_DELTA_H__
+
+#include <stdint.h>
+#include <mpi.h>
+#include "mpi_win_pmem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MPI_PMEM_DELTA_CHECKPOINT_MAGIC 0x41544C45444D454DULL // "MEMDELTA"
+#define MPI_PMEM_DELTA_RUN_GAP 3   // Minimal number of unchanged 8-byte words separating two runs (shorter gaps are cheaper to store than new run).
+
+// Header of delta checkpoint file. It is followed by array of runs and XOR of data with previous checkpoint version for every run in the same order.
+typedef struct {
+   uint64_t magic;
+   uint64_t window_size;
+   uint64_t runs_count;
+   uint64_t data_size;     // Total size of all runs.
+} MPI_Win_pmem_delta_header;
+
+// Range of window which differs from previous checkpoint version.
+typedef struct {
+   uint64_t offset;
+   uint64_t size;
+} MPI_Win_pmem_delta_run;
+
+/**
+ * Encode difference between window data and data saved in previous checkpoint as XOR of both, stored only for runs of changed words.
+ *
+ * @param comm        Communicator used for error handling.
+ * @param data        Window data.
+ * @param reference   Data saved in previous checkpoint.
+ * @param size        Size of window.
+ * @param delta       Output variable for encoded delta preceded by MPI_Win_pmem_delta_header (must be freed by the caller).
+ * @param delta_size  Output variable for size of encoded delta including header.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int encode_delta(MPI_Comm comm, const void *data, const void *reference, MPI_Aint size, void **delta, MPI_Aint *delta_size);
+
+/**
+ * Apply delta encoded by encode_delta on top of data saved in previous checkpoint.
+ *
+ * @param destination  Memory area containing previous checkpoint version.
+ * @param delta        Encoded delta.
+ */
+void apply_delta(void *destination, const void *delta);
+
+/**
+ * Apply delta saved in delta checkpoint file on top of destination memory area.
+ *
+ * @param comm          Communicator used for error handling.
+ * @param file_name     Name of delta checkpoint file.
+ * @param size          Size of window in bytes.
+ * @param destination   Destination memory area containing previous checkpoint version.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int apply_delta_checkpoint(MPI_Comm comm, const char *file_name, MPI_Aint size, void *destination);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,321 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_dirty.h"
+#include <stdlib.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem_areas.h"
+
+#define MPI_PMEM_DIRTY_RANGES_MIN_CAPACITY 64
+#define MPI_PMEM_DIRTY_RANGES_MAX_COUNT 4096
+
+// Range of target window modified in current epoch. Range is relative to beginning of target window, or is an address in dynamic windows.
+typedef struct {
+   int target;
+   MPI_Aint begin;
+   MPI_Aint end;
+} MPI_Win_pmem_dirty_range;
+
+struct MPI_Win_pmem_dirty_tracker_structure {
+   int comm_size;
+   bool dynamic;
+   int *disp_units;                   // Displacement units of all targets.
+   MPI_Win_pmem_dirty_range *ranges;  // Ranges recorded in current epoch.
+   int count;
+   int capacity;
+};
+
+/**
+ * Compare ranges by target and beginning (used by qsort).
+ *
+ * @param first   First range.
+ * @param second  Second range.
+ *
+ * @returns Negative, zero or positive value if first range should be placed before, at the same position or after second range.
+ */
+static int compare_dirty_ranges(const void *first, const void *second) {
+   const MPI_Win_pmem_dirty_range *first_range = first;
+   const MPI_Win_pmem_dirty_range *second_range = second;
+
+   if (first_range->target != second_range->target) {
+      return first_range->target < second_range->target ? -1 : 1;
+   }
+   if (first_range->begin != second_range->begin) {
+      return first_range->begin < second_range->begin ? -1 : 1;
+   }
+
+   return 0;
+}
+
+/**
+ * Add part of received range which lies in memory areas of window to batch.
+ *
+ * @param win      Window object.
+ * @param begin    Beginning of range (relative to window base or address in dynamic windows).
+ * @param end      End of range.
+ * @param batch    Batch of ranges.
+ *
+ * @returns false if there is not enough memory to extend batch, true otherwise.
+ */
+static bool add_dirty_range_to_batch(MPI_Win_pmem win, MPI_Aint begin, MPI_Aint end, MPI_Win_pmem_persist_batch *batch) {
+   MPI_Win_memory_areas_list *current_item;
+   uintptr_t range_begin, range_end, area_begin, area_end;
+
+   current_item = win.modifiable_values->memory_areas;
+   if (win.modifiable_values->dirty_tracker->dynamic) {
+      range_begin = (uintptr_t) begin;
+      range_end = (uintptr_t) end;
+   } else if (current_item != NULL) {
+      range_begin = (uintptr_t) current_item->base + begin;
+      range_end = (uintptr_t) current_item->base + end;
+   } else {
+      return true;
+   }
+   // Only areas overlapping range are visited, ranges outside of attached memory (e.g. memory detached before fence) are skipped.
+   for (current_item = find_memory_area(win, (void*) range_begin); current_item != NULL && (uintptr_t) current_item->base < range_end;
+        current_item = current_item->index_next[0]) {
+      area_begin = (uintptr_t) current_item->base;
+      area_end = area_begin + current_item->size;
+      if (range_begin < area_end && range_end > area_begin) {
+         area_begin = range_begin > area_begin ? range_begin : area_begin;
+         area_end = range_end < area_end ? range_end : area_end;
+         if (!add_persist_range(batch, (void*) area_begin, area_end - area_begin, current_item->is_pmem)) {
+            return false;
+         }
+      }
+   }
+
+   return true;
+}
+
+/**
+ * Sort recorded ranges and merge overlapping ranges of each target.
+ *
+ * @param tracker  Tracker of dirty ranges.
+ */
+static void merge_dirty_ranges(MPI_Win_pmem_dirty_tracker *tracker) {
+   int i, merged;
+   MPI_Win_pmem_dirty_range *ranges = tracker->ranges;
+
+   if (tracker->count == 0) {
+      return;
+   }
+   qsort(ranges, tracker->count, sizeof(MPI_Win_pmem_dirty_range), compare_dirty_ranges);
+   merged = 0;
+   for (i = 1; i < tracker->count; i++) {
+      if (ranges[i].target == ranges[merged].target && ranges[i].begin <= ranges[merged].end) {
+         if (ranges[i].end > ranges[merged].end) {
+            ranges[merged].end = ranges[i].end;
+         }
+      } else {
+         ranges[++merged] = ranges[i];
+      }
+   }
+   tracker->count = merged + 1;
+}
+
+int create_dirty_tracker(MPI_Win_pmem win, int disp_unit, bool dynamic, MPI_Win_pmem_dirty_tracker **tracker) {
+   int result;
+
+   *tracker = malloc(sizeof(MPI_Win_pmem_dirty_tracker));
+   if (*tracker == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(win.comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   result = MPI_Comm_size(win.comm, &(*tracker)->comm_size);
+   CHECK_ERROR_CODE(result);
+   (*tracker)->dynamic = dynamic;
+   (*tracker)->ranges = NULL;
+   (*tracker)->count = 0;
+   (*tracker)->capacity = 0;
+   (*tracker)->disp_units = malloc((*tracker)->comm_size * sizeof(int));
+   if ((*tracker)->disp_units == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      free(*tracker);
+      *tracker = NULL;
+      call_comm_errhandler(win.comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   // Origin converts displacements to bytes, so it has to know displacement units of all targets.
+   result = MPI_Allgather(&disp_unit, 1, MPI_INT, (*tracker)->disp_units, 1, MPI_INT, win.comm);
+   CHECK_ERROR_CODE(result);
+
+   return MPI_SUCCESS;
+}
+
+int track_dirty_range(MPI_Win_pmem win, int target_rank, MPI_Aint target_disp, int target_count, MPI_Datatype target_datatype) {
+   int result;
+   MPI_Aint lb, extent, true_lb, true_extent, begin, end;
+   MPI_Win_pmem_dirty_range *ranges, *last;
+   MPI_Win_pmem_dirty_tracker *tracker = win.modifiable_values->dirty_tracker;
+
+   if (tracker == NULL || target_rank == MPI_PROC_NULL || target_count <= 0) {
+      return MPI_SUCCESS;
+   }
+
+   result = MPI_Type_get_extent(target_datatype, &lb, &extent);
+   CHECK_ERROR_CODE(result);
+   result = MPI_Type_get_true_extent(target_datatype, &true_lb, &true_extent);
+   CHECK_ERROR_CODE(result);
+   begin = target_disp * tracker->disp_units[target_rank] + true_lb;
+   end = begin + (target_count - 1) * extent + true_extent;
+
+   // Consecutive operations often write adjacent ranges (e.g. elements of halo), so they are merged immediately.
+   if (tracker->count > 0) {
+      last = &tracker->ranges[tracker->count - 1];
+      if (last->target == target_rank && begin <= last->end && end >= last->begin) {
+         last->begin = begin < last->begin ? begin : last->begin;
+         last->end = end > last->end ? end : last->end;
+         return MPI_SUCCESS;
+      }
+   }
+   if (tracker->count == tracker->capacity) {
+      ranges = realloc(tracker->ranges, (tracker->capacity == 0 ? MPI_PMEM_DIRTY_RANGES_MIN_CAPACITY : 2 * tracker->capacity) * sizeof(MPI_Win_pmem_dirty_range));
+      if (ranges == NULL) {
+         mpi_log_error("Unable to allocate memory.");
+         call_win_errhandler(win.win, MPI_ERR_PMEM_NO_MEM);
+         return MPI_ERR_PMEM_NO_MEM;
+      }
+      tracker->ranges = ranges;
+      tracker->capacity = tracker->capacity == 0 ? MPI_PMEM_DIRTY_RANGES_MIN_CAPACITY : 2 * tracker->capacity;
+   }
+   tracker->ranges[tracker->count].target = target_rank;
+   tracker->ranges[tracker->count].begin = begin;
+   tracker->ranges[tracker->count].end = end;
+   tracker->count++;
+
+   return MPI_SUCCESS;
+}
+
+int collect_dirty_ranges(MPI_Win_pmem win, MPI_Win_pmem_persist_batch *batch) {
+   int result, i, received_count;
+   int *counts, *displacements;
+   MPI_Aint *send_buffer = NULL, *receive_buffer = NULL;
+   MPI_Win_pmem_dirty_tracker *tracker = win.modifiable_values->dirty_tracker;
+   MPI_Win_pmem_dirty_range *ranges = tracker->ranges;
+
+   mpi_log_debug("Exchanging dirty ranges.");
+
+   // Merge ranges of each target, so targets receive compact lists.
+   merge_dirty_ranges(tracker);
+
+   // Counts and displacements of sent values are stored in first half of array, received in second.
+   counts = calloc(4 * tracker->comm_size, sizeof(int));
+   send_buffer = malloc((2 * tracker->count + 1) * sizeof(MPI_Aint));
+   if (counts == NULL || send_buffer == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      free(counts);
+      free(send_buffer);
+      call_win_errhandler(win.win, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   displacements = counts + 2 * tracker->comm_size;
+   for (i = 0; i < tracker->count; i++) {
+      counts[ranges[i].target] += 2;
+      send_buffer[2 * i] = ranges[i].begin;
+      send_buffer[2 * i + 1] = ranges[i].end;
+   }
+   tracker->count = 0;
+
+   result = MPI_Alltoall(counts, 1, MPI_INT, counts + tracker->comm_size, 1, MPI_INT, win.comm);
+   if (result != MPI_SUCCESS) {
+      free(counts);
+      free(send_buffer);
+      return result;
+   }
+   received_count = 0;
+   for (i = 0; i < tracker->comm_size; i++) {
+      displacements[i] = i == 0 ? 0 : displacements[i - 1] + counts[i - 1];
+      displacements[tracker->comm_size + i] = received_count;
+      received_count += counts[tracker->comm_size + i];
+   }
+   receive_buffer = malloc((received_count + 1) * sizeof(MPI_Aint));
+   if (receive_buffer == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      free(counts);
+      free(send_buffer);
+      call_win_errhandler(win.win, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   result = MPI_Alltoallv(send_buffer, counts, displacements, MPI_AINT,
+                          receive_buffer, counts + tracker->comm_size, displacements + tracker->comm_size, MPI_AINT, win.comm);
+   free(counts);
+   free(send_buffer);
+   if (result != MPI_SUCCESS) {
+      free(receive_buffer);
+      return result;
+   }
+
+   for (i = 0; i < received_count; i += 2) {
+      if (!add_dirty_range_to_batch(win, receive_buffer[i], receive_buffer[i + 1], batch)) {
+         mpi_log_error("Unable to allocate memory.");
+         free(receive_buffer);
+         call_win_errhandler(win.win, MPI_ERR_PMEM_NO_MEM);
+         return MPI_ERR_PMEM_NO_MEM;
+      }
+   }
+   free(receive_buffer);
+
+   mpi_log_debug("Received %d dirty ranges.", received_count / 2);
+
+   return MPI_SUCCESS;
+}
+
+void compact_dirty_ranges(MPI_Win_pmem win) {
+   int i, merged;
+   MPI_Win_pmem_dirty_tracker *tracker = win.modifiable_values->dirty_tracker;
+
+   if (tracker == NULL) {
+      return;
+   }
+   merge_dirty_ranges(tracker);
+   // Persisting larger range is always correct, so ranges of each target are joined into one if they don't stop growing.
+   if (tracker->count > MPI_PMEM_DIRTY_RANGES_MAX_COUNT) {
+      mpi_log_debug("Joining %d dirty ranges of each target.", tracker->count);
+      merged = 0;
+      for (i = 1; i < tracker->count; i++) {
+         if (tracker->ranges[i].target == tracker->ranges[merged].target) {
+            tracker->ranges[merged].end = tracker->ranges[i].end;
+         } else {
+            tracker->ranges[++merged] = tracker->ranges[i];
+         }
+      }
+      tracker->count = merged + 1;
+   }
+}
+
+void free_dirty_tracker(MPI_Win_pmem_dirty_tracker *tracker) {
+   if (tracker != NULL) {
+      free(tracker->disp_units);
+      free(tracker->ranges);
+      free(tracker);
+   }
+}
@@ -0,0 +1,97 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_DIRTY_H__
+#define __MPI_WIN_PMEM_DIRTY_H__
+
+#include <stdbool.h>
+#include <mpi.h>
+#include "mpi_win_pmem_datatypes.h"
+#include "mpi_win_pmem_persist.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create tracker of ranges modified by RMA operations issued by this process. Collective over window's communicator.
+ *
+ * @param win        Window object.
+ * @param disp_unit  Displacement unit used by this process as target (1 for dynamic windows).
+ * @param dynamic    Flag specifying whether window is dynamic (target displacements are addresses).
+ * @param tracker    Pointer to created tracker.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int create_dirty_tracker(MPI_Win_pmem win, int disp_unit, bool dynamic, MPI_Win_pmem_dirty_tracker **tracker);
+
+/**
+ * Record range of target window modified by RMA operation. Does nothing if window doesn't track dirty ranges.
+ *
+ * @param win              Window object.
+ * @param target_rank      Rank of target.
+ * @param target_disp      Displacement from start of target window.
+ * @param target_count     Number of entries in target buffer.
+ * @param target_datatype  Datatype of each entry in target buffer.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int track_dirty_range(MPI_Win_pmem win, int target_rank, MPI_Aint target_disp, int target_count, MPI_Datatype target_datatype);
+
+/**
+ * Send ranges recorded in current epoch to their targets and add ranges of this process' window modified by other processes to batch. Recorded ranges are
+ * cleared. Collective over window's communicator, has to be called after epoch is completed.
+ *
+ * @param win    Window object.
+ * @param batch  Batch of ranges to which modified ranges of local window are added.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int collect_dirty_ranges(MPI_Win_pmem win, MPI_Win_pmem_persist_batch *batch);
+
+/**
+ * Merge ranges recorded in epochs completed without exchanging them (e.g. fences which skipped persist, PSCW and passive target epochs), so they don't
+ * accumulate until next MPI_Win_fence_pmem_persist. Ranges of each target are joined into one when there are too many of them. Does nothing if window doesn't
+ * track dirty ranges.
+ *
+ * @param win  Window object.
+ */
+void compact_dirty_ranges(MPI_Win_pmem win);
+
+/**
+ * Free memory used by tracker.
+ *
+ * @param tracker  Tracker of dirty ranges (may be NULL).
+ */
+void free_dirty_tracker(MPI_Win_pmem_dirty_tracker *tracker);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,132 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_extents.h"
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+
+MPI_Aint extents_checkpoint_size(const MPI_Win_memory_areas_list *memory_areas) {
+   MPI_Aint size = sizeof(MPI_Win_pmem_extents_header);
+   const MPI_Win_memory_areas_list *current_item;
+
+   for (current_item = memory_areas; current_item != NULL; current_item = current_item->next) {
+      size += sizeof(MPI_Win_pmem_extent) + current_item->size;
+   }
+
+   return size;
+}
+
+int write_extents_checkpoint(MPI_Win_pmem_checkpoint_writer *writer, const MPI_Win_memory_areas_list *memory_areas) {
+   int result;
+   MPI_Win_pmem_extents_header header;
+   MPI_Win_pmem_extent *extents;
+   const MPI_Win_memory_areas_list *current_item;
+   uint64_t i, offset;
+
+   header.magic = MPI_PMEM_EXTENTS_CHECKPOINT_MAGIC;
+   header.extents_count = 0;
+   for (current_item = memory_areas; current_item != NULL; current_item = current_item->next) {
+      header.extents_count++;
+   }
+   extents = malloc((header.extents_count > 0 ? header.extents_count : 1) * sizeof(MPI_Win_pmem_extent));
+   if (extents == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(writer->comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+
+   // Build manifest.
+   offset = sizeof(MPI_Win_pmem_extents_header) + header.extents_count * sizeof(MPI_Win_pmem_extent);
+   for (i = 0, current_item = memory_areas; current_item != NULL; i++, current_item = current_item->next) {
+      extents[i].area_id = current_item->id;
+      extents[i].size = current_item->size;
+      extents[i].offset = offset;
+      offset += current_item->size;
+   }
+
+   // Write header, manifest and contents of all memory areas in one pass.
+   result = write_checkpoint_data(writer, &header, sizeof(MPI_Win_pmem_extents_header));
+   if (result == MPI_SUCCESS) {
+      result = write_checkpoint_data(writer, extents, header.extents_count * sizeof(MPI_Win_pmem_extent));
+   }
+   free(extents);
+   CHECK_ERROR_CODE(result);
+   for (current_item = memory_areas; current_item != NULL; current_item = current_item->next) {
+      result = write_checkpoint_data(writer, current_item->base, current_item->size);
+      CHECK_ERROR_CODE(result);
+   }
+
+   return MPI_SUCCESS;
+}
+
+int restore_extent(MPI_Comm comm, const char *file_name, int area_id, void *base, MPI_Aint size) {
+   int fd;
+   MPI_Win_pmem_extents_header header;
+   MPI_Win_pmem_extent extent;
+   uint64_t i;
+   bool valid;
+
+   if ((fd = open(file_name, O_RDONLY)) < 0) {
+      mpi_log_error("Checkpoint file '%s' doesn't exist.", file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   valid = pread(fd, &header, sizeof(MPI_Win_pmem_extents_header), 0) == sizeof(MPI_Win_pmem_extents_header) && header.magic == MPI_PMEM_EXTENTS_CHECKPOINT_MAGIC;
+   for (i = 0; valid && i < header.extents_count; i++) {
+      valid = pread(fd, &extent, sizeof(MPI_Win_pmem_extent), sizeof(MPI_Win_pmem_extents_header) + i * sizeof(MPI_Win_pmem_extent)) == sizeof(MPI_Win_pmem_extent);
+      if (valid && extent.area_id == (uint64_t) area_id) {
+         if (extent.size != (uint64_t) size) {
+            mpi_log_error("Memory area %d size is %lu, while size saved in checkpoint file '%s' is %lu.", area_id, (unsigned long) size, file_name, (unsigned long) extent.size);
+            close(fd);
+            call_comm_errhandler(comm, MPI_ERR_SIZE);
+            return MPI_ERR_SIZE;
+         }
+         valid = pread(fd, base, size, extent.offset) == size;
+         break;
+      }
+   }
+   close(fd);
+
+   if (!valid) {
+      mpi_log_error("Checkpoint file '%s' is corrupted.", file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   if (i == header.extents_count) {
+      mpi_log_debug("Memory area %d not found in checkpoint file '%s'.", area_id, file_name);
+   } else {
+      mpi_log_debug("Memory area %d restored from checkpoint file '%s'.", area_id, file_name);
+   }
+
+   return MPI_SUCCESS;
+}
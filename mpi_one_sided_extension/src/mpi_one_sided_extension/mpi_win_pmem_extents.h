@@ -0,0 +1,92 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_EXTENTS_H__
+#define __MPI_WIN_PMEM_EXTENTS_H__
+
+#include <stdint.h>
+#include <mpi.h>
+#include "mpi_win_pmem.h"
+#include "mpi_win_pmem_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MPI_PMEM_EXTENTS_CHECKPOINT_MAGIC 0x5354584543454D50ULL // "PMECEXTS"
+
+// Header of checkpoint file of dynamic window. It is followed by manifest (array of extents) and concatenated contents of memory areas.
+typedef struct {
+   uint64_t magic;
+   uint64_t extents_count;
+} MPI_Win_pmem_extents_header;
+
+// Description of single memory area saved in checkpoint file of dynamic window.
+typedef struct {
+   uint64_t area_id;
+   uint64_t size;
+   uint64_t offset;  // Offset of memory area contents from the beginning of checkpoint file.
+} MPI_Win_pmem_extent;
+
+/**
+ * Calculate size of checkpoint file of all memory areas attached to dynamic window.
+ *
+ * @param memory_areas  List of memory areas attached to window.
+ *
+ * @returns Size of checkpoint file in bytes.
+ */
+MPI_Aint extents_checkpoint_size(const MPI_Win_memory_areas_list *memory_areas);
+
+/**
+ * Write checkpoint of all memory areas attached to dynamic window into opened checkpoint file.
+ *
+ * @param writer        Writer of checkpoint file opened with size returned by extents_checkpoint_size.
+ * @param memory_areas  List of memory areas attached to window.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int write_extents_checkpoint(MPI_Win_pmem_checkpoint_writer *writer, const MPI_Win_memory_areas_list *memory_areas);
+
+/**
+ * Copy contents of memory area with specified identifier from checkpoint file of dynamic window. Memory area which is not present in checkpoint is left unchanged.
+ *
+ * @param comm       Communicator used for error handling.
+ * @param file_name  Name of checkpoint file.
+ * @param area_id    Identifier of memory area.
+ * @param base       Starting address of memory area.
+ * @param size       Size of memory area.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int restore_extent(MPI_Comm comm, const char *file_name, int area_id, void *base, MPI_Aint size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
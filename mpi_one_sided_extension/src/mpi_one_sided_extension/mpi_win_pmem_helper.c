@@ -27,17 +27,44 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
 #include "mpi_win_pmem_helper.h"
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <linux/fs.h>
 #include <libpmem.h>
 #include "../common/error_codes.h"
 #include "../common/logger.h"
+#include "../common/util.h"
 #include "mpi_win_pmem.h"
+#include "mpi_win_pmem_incremental.h"
+#include "mpi_win_pmem_extents.h"
+#include "mpi_win_pmem_writer.h"
+#include "mpi_win_pmem_parallel.h"
+#include "mpi_win_pmem_codec.h"
+#include "mpi_win_pmem_chunks.h"
+#include "mpi_win_pmem_index.h"
+#include "mpi_win_pmem_persist.h"
+#include "mpi_win_pmem_throttle.h"
+#include "mpi_win_pmem_aggregate.h"
+#include "mpi_win_pmem_delta.h"
+#include "mpi_win_pmem_slots.h"
+#include "mpi_win_pmem_reclaim.h"
+#include "mpi_win_pmem_numa.h"
+#include "mpi_win_pmem_lazy.h"
+
+// Flags of synchronous page faults, which may be missing in older system headers.
+#ifndef MAP_SHARED_VALIDATE
+#define MAP_SHARED_VALIDATE 0x03
+#endif
+#ifndef MAP_SYNC
+#define MAP_SYNC 0x80000
+#endif
 
 int open_pmem_file(MPI_Comm comm, const char *file_name, MPI_Aint size, void **address) {
    int fd;
@@ -45,7 +72,7 @@ int open_pmem_file(MPI_Comm comm, const char *file_name, MPI_Aint size, void **a
    // Open file.
    if ((fd = open(file_name, O_CREAT | O_RDWR, 0666)) < 0) {
       mpi_log_error("Unable to open file '%s'.", file_name);
-      MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
       return MPI_ERR_PMEM;
    }
 
@@ -53,7 +80,7 @@ int open_pmem_file(MPI_Comm comm, const char *file_name, MPI_Aint size, void **a
    if (posix_fallocate(fd, 0, size) != 0) {
       mpi_log_error("Unable to allocate disk space for file '%s'.", file_name);
       close(fd);
-      MPI_Comm_call_errhandler(comm, MPI_ERR_NO_SPACE);
+      call_comm_errhandler(comm, MPI_ERR_NO_SPACE);
       return MPI_ERR_NO_SPACE;
    }
 
@@ -61,7 +88,7 @@ int open_pmem_file(MPI_Comm comm, const char *file_name, MPI_Aint size, void **a
    if ((*address = pmem_map(fd)) == NULL) {
       mpi_log_error("Unable to map file '%s' to memory.", file_name);
       close(fd);
-      MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
       return MPI_ERR_PMEM;
    }
    close(fd);
@@ -69,15 +96,76 @@ int open_pmem_file(MPI_Comm comm, const char *file_name, MPI_Aint size, void **a
    return MPI_SUCCESS;
 }
 
+int map_window_file(MPI_Comm comm, const char *file_name, MPI_Aint size, bool map_sync, void **address) {
+   int fd;
+   char *reserved, *aligned, *mapped;
+   size_t reserved_size, mapped_size;
+   uintptr_t page_size = (uintptr_t) sysconf(_SC_PAGESIZE);
+
+   if ((fd = open(file_name, O_CREAT | O_RDWR, 0666)) < 0) {
+      mpi_log_error("Unable to open file '%s'.", file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   if (posix_fallocate(fd, 0, size) != 0) {
+      mpi_log_error("Unable to allocate disk space for file '%s'.", file_name);
+      close(fd);
+      call_comm_errhandler(comm, MPI_ERR_NO_SPACE);
+      return MPI_ERR_NO_SPACE;
+   }
+
+   // Reserve address range larger by huge page, so mapping can be placed at aligned address within it.
+   mapped_size = ((uintptr_t) size + page_size - 1) & ~(page_size - 1);
+   reserved_size = size < MPI_PMEM_HUGE_PAGE_SIZE ? mapped_size : mapped_size + MPI_PMEM_HUGE_PAGE_SIZE;
+   reserved = mmap(NULL, reserved_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+   if (reserved == MAP_FAILED) {
+      mpi_log_error("Unable to reserve address space for file '%s'.", file_name);
+      close(fd);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   aligned = reserved;
+   if (size >= MPI_PMEM_HUGE_PAGE_SIZE) {
+      aligned = (char*) (((uintptr_t) reserved + MPI_PMEM_HUGE_PAGE_SIZE - 1) & ~((uintptr_t) MPI_PMEM_HUGE_PAGE_SIZE - 1));
+   }
+
+   mapped = MAP_FAILED;
+   if (map_sync) {
+      mapped = mmap(aligned, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED_VALIDATE | MAP_SYNC | MAP_FIXED, fd, 0);
+      if (mapped == MAP_FAILED) {
+         mpi_log_debug("Synchronous page faults aren't supported for file '%s'.", file_name);
+      }
+   }
+   if (mapped == MAP_FAILED) {
+      mapped = mmap(aligned, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+   }
+   close(fd);
+   if (mapped == MAP_FAILED) {
+      mpi_log_error("Unable to map file '%s' to memory.", file_name);
+      munmap(reserved, reserved_size);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   // Release parts of reserved range around mapping.
+   if (aligned > reserved) {
+      munmap(reserved, aligned - reserved);
+   }
+   if (reserved + reserved_size > aligned + mapped_size) {
+      munmap(aligned + mapped_size, reserved + reserved_size - (aligned + mapped_size));
+   }
+   *address = aligned;
+
+   return MPI_SUCCESS;
+}
+
 int persist_pmem_file(MPI_Comm comm, void *address, MPI_Aint size) {
    if (pmem_is_pmem(address, size)) {
-      //pmem_persist(address, size);
-      pmem_msync(address, size);
-      pmem_drain();
+      pmem_persist(address, size);
    } else {
       if (pmem_msync(address, size) != 0) {
          mpi_log_error("Unable to msync memory area base: 0x%lx, size: %lu.", (long int) address, size);
-         MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM);
+         call_comm_errhandler(comm, MPI_ERR_PMEM);
          return MPI_ERR_PMEM;
       }
    }
@@ -91,7 +179,7 @@ int unmap_pmem_file(MPI_Comm comm, void *address, MPI_Aint size) {
    result = munmap(address, size);
    if (result != 0) {
       mpi_log_error("Unable to unmap memory area base: 0x%lx, size: %lu.", (long int) address, size);
-      MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
       return MPI_ERR_PMEM;
    }
 
@@ -114,7 +202,7 @@ int get_file_size(MPI_Comm comm, const char *file_name, off_t *size) {
    result = stat(file_name, &file_status);
    if (result != 0) {
       mpi_log_error("Unable to check file size of file '%s'.", file_name);
-      MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
       return MPI_ERR_PMEM;
    }
    *size = file_status.st_size;
@@ -142,7 +230,7 @@ int open_versions_metadata_file(MPI_Comm comm, const char *window_name, MPI_Win_
    file_name = malloc((strlen(mpi_pmem_root_path) + strlen(window_name) + 3) * sizeof(char)); // Additional 3 characters for: "/." and terminating zero.
    if (file_name == NULL) {
       mpi_log_error("Unable to allocate memory.");
-      MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
       return MPI_ERR_PMEM_NO_MEM;
    }
    sprintf(file_name, "%s/.%s", mpi_pmem_root_path, window_name);
@@ -155,29 +243,213 @@ int open_versions_metadata_file(MPI_Comm comm, const char *window_name, MPI_Win_
    return MPI_SUCCESS;
 }
 
+int open_window_versions(MPI_Win_pmem win, MPI_Win_pmem_version **versions) {
+   int result;
+
+   if (win.modifiable_values->versions == NULL) {
+      result = open_versions_metadata_file(win.comm, win.name, &win.modifiable_values->versions, &win.modifiable_values->versions_file_size);
+      CHECK_ERROR_CODE(result);
+   }
+   *versions = win.modifiable_values->versions;
+
+   return MPI_SUCCESS;
+}
+
+int reserve_window_versions(MPI_Win_pmem win, int count, MPI_Win_pmem_version **versions) {
+   int result;
+   char *file_name;
+   off_t file_size;
+
+   result = open_window_versions(win, versions);
+   CHECK_ERROR_CODE(result);
+   file_size = count * sizeof(MPI_Win_pmem_version);
+   if (file_size <= win.modifiable_values->versions_file_size) {
+      return MPI_SUCCESS;
+   }
+   if (file_size < 2 * win.modifiable_values->versions_file_size) {
+      file_size = 2 * win.modifiable_values->versions_file_size;
+   }
+
+   // Records added at the end of file are filled with zeros, so they are terminating records.
+   file_name = malloc((strlen(mpi_pmem_root_path) + strlen(win.name) + 3) * sizeof(char)); // Additional 3 characters for: "/." and terminating zero.
+   if (file_name == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(win.comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   sprintf(file_name, "%s/.%s", mpi_pmem_root_path, win.name);
+   result = close_window_versions(win);
+   CHECK_ERROR_CODE(result);
+   result = open_pmem_file(win.comm, file_name, file_size, (void**) &win.modifiable_values->versions);
+   CHECK_ERROR_CODE(result);
+   win.modifiable_values->versions_file_size = file_size;
+   free(file_name);
+   *versions = win.modifiable_values->versions;
+
+   return MPI_SUCCESS;
+}
+
+int close_window_versions(MPI_Win_pmem win) {
+   int result;
+
+   if (win.modifiable_values->versions != NULL) {
+      result = unmap_pmem_file(win.comm, win.modifiable_values->versions, win.modifiable_values->versions_file_size);
+      CHECK_ERROR_CODE(result);
+      win.modifiable_values->versions = NULL;
+   }
+   if (win.modifiable_values->epoch != NULL) {
+      result = unmap_pmem_file(win.comm, win.modifiable_values->epoch, sizeof(MPI_Win_pmem_epoch));
+      CHECK_ERROR_CODE(result);
+      win.modifiable_values->epoch = NULL;
+   }
+
+   return MPI_SUCCESS;
+}
+
+// Global epoch record has to fit in single aligned 8-byte word, which is written with one failure-atomic store.
+typedef char MPI_Win_pmem_epoch_word_check[sizeof(MPI_Win_pmem_epoch) == sizeof(uint64_t) ? 1 : -1];
+
+int open_window_epoch(MPI_Win_pmem win, MPI_Win_pmem_epoch **epoch) {
+   int result;
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 9]; // Additional 9 characters for: "/.", "-global" and terminating zero.
+
+   if (win.modifiable_values->epoch == NULL) {
+      // New file is filled with zeros, which is a record without any global commit.
+      sprintf(file_name, "%s/.%s-global", mpi_pmem_root_path, win.name);
+      result = open_pmem_file(win.comm, file_name, sizeof(MPI_Win_pmem_epoch), (void**) &win.modifiable_values->epoch);
+      CHECK_ERROR_CODE(result);
+   }
+   *epoch = win.modifiable_values->epoch;
+
+   return MPI_SUCCESS;
+}
+
+int store_global_epoch(MPI_Comm comm, MPI_Win_pmem_epoch *record, int version, int epoch) {
+   MPI_Win_pmem_epoch committed;
+   uint64_t word;
+
+   committed.version = version;
+   committed.epoch = epoch;
+   memcpy(&word, &committed, sizeof(uint64_t));
+   __atomic_store_n((uint64_t*) record, word, __ATOMIC_RELEASE);
+
+   return persist_pmem_file(comm, record, sizeof(MPI_Win_pmem_epoch));
+}
+
+int read_global_checkpoint_version(MPI_Comm comm, const char *window_name, int *version) {
+   int result;
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 9]; // Additional 9 characters for: "/.", "-global" and terminating zero.
+   MPI_Win_pmem_epoch *epoch;
+
+   *version = -1;
+   sprintf(file_name, "%s/.%s-global", mpi_pmem_root_path, window_name);
+   if (check_if_file_exist(file_name)) {
+      result = open_pmem_file(comm, file_name, sizeof(MPI_Win_pmem_epoch), (void**) &epoch);
+      CHECK_ERROR_CODE(result);
+      if (epoch->epoch > 0) {
+         *version = epoch->version;
+      }
+      result = unmap_pmem_file(comm, epoch, sizeof(MPI_Win_pmem_epoch));
+      CHECK_ERROR_CODE(result);
+   }
+
+   return MPI_SUCCESS;
+}
+
+int invalidate_global_checkpoint_version(MPI_Comm comm, const char *window_name, int version) {
+   int result;
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 9]; // Additional 9 characters for: "/.", "-global" and terminating zero.
+   MPI_Win_pmem_epoch *epoch;
+
+   sprintf(file_name, "%s/.%s-global", mpi_pmem_root_path, window_name);
+   if (check_if_file_exist(file_name)) {
+      result = open_pmem_file(comm, file_name, sizeof(MPI_Win_pmem_epoch), (void**) &epoch);
+      CHECK_ERROR_CODE(result);
+      if (epoch->epoch > 0 && epoch->version == version) {
+         mpi_log_debug("Invalidating global epoch %d of window '%s'.", epoch->epoch, window_name);
+         result = store_global_epoch(comm, epoch, -1, epoch->epoch);
+         CHECK_ERROR_CODE(result);
+      }
+      result = unmap_pmem_file(comm, epoch, sizeof(MPI_Win_pmem_epoch));
+      CHECK_ERROR_CODE(result);
+   }
+
+   return MPI_SUCCESS;
+}
+
 int delete_old_checkpoints(MPI_Comm comm, const char *name, MPI_Win_pmem_version *versions) {
-   int result, i;
+   int result, i, count, deleted_count;
+   int *deleted;
    char *file_name;
+   bool is_pmem;
+   MPI_Win_pmem_persist_batch batch;
 
    // Additional 14 characters for: "/.", "-", 10 characters for checkpoint number (length of maximum 4 byte integer number written in decimal form is 10 characters) and terminating zero.
    file_name = malloc((strlen(mpi_pmem_root_path) + strlen(name) + 14) * sizeof(char));
    if (file_name == NULL) {
       mpi_log_error("Unable to allocate memory.");
-      MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+
+   // Global epoch record is removed first, so it never points to deleted version.
+   sprintf(file_name, "%s/.%s-global", mpi_pmem_root_path, name);
+   remove(file_name);
+
+   for (count = 0; versions[count].flags != MPI_PMEM_FLAG_NO_OBJECT; count++);
+   deleted = malloc((count + 1) * sizeof(int));
+   if (deleted == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      free(file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
       return MPI_ERR_PMEM_NO_MEM;
    }
 
-   // Delete all previously created checkpoints.
-   for (i = 0; versions[i].flags != MPI_PMEM_FLAG_NO_OBJECT; i++) {
+   // Mark all previously created checkpoints as deleted, flags are persisted together before any checkpoint file is removed.
+   init_persist_batch(&batch);
+   is_pmem = pmem_is_pmem(versions, sizeof(MPI_Win_pmem_version));
+   deleted_count = 0;
+   for (i = 0; i < count; i++) {
       if (versions[i].flags == MPI_PMEM_FLAG_OBJECT_EXISTS) {
          versions[i].flags = MPI_PMEM_FLAG_OBJECT_DELETED;
-         result = persist_pmem_file(comm, &versions[i].flags, sizeof(char));
-         CHECK_ERROR_CODE(result);
-         sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, name, versions[i].version);
-         remove(file_name);
+         deleted[deleted_count++] = i;
+         if (!add_persist_range(&batch, &versions[i].flags, sizeof(char), is_pmem)) {
+            mpi_log_error("Unable to allocate memory.");
+            free_persist_batch(&batch);
+            free(deleted);
+            free(file_name);
+            call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+            return MPI_ERR_PMEM_NO_MEM;
+         }
       }
    }
+   if (!persist_batch(&batch)) {
+      mpi_log_error("Unable to persist deleted flags of checkpoints of window '%s'.", name);
+      free_persist_batch(&batch);
+      free(deleted);
+      free(file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   free_persist_batch(&batch);
+
+   // Delete checkpoint files.
+   for (i = 0; i < deleted_count; i++) {
+      sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, name, versions[deleted[i]].version);
+      if (versions[deleted[i]].format == MPI_PMEM_CHECKPOINT_AGGREGATED) {
+         remove_aggregated_checkpoint(name, versions[deleted[i]].parent_version);
+         continue;
+      }
+      if (versions[deleted[i]].format == MPI_PMEM_CHECKPOINT_SLOT) {
+         continue;
+      }
+      release_checkpoint_chunks(comm, file_name, versions[deleted[i]].format);
+      reclaim_file(mpi_pmem_root_path, file_name);
+   }
+   free(deleted);
    free(file_name);
+   // Slot files are removed all at once, including slots which don't contain any version.
+   remove_checkpoint_slots(comm, name);
 
    // Set 0th record to terminating record.
    versions[0].version = 0;
@@ -197,11 +469,30 @@ int set_default_window_metadata(MPI_Win_pmem *win, MPI_Comm comm) {
    win->is_volatile = false;
    win->append_checkpoints = false;
    win->global_checkpoint = false;
+   win->incremental_checkpoints = false;
+   win->full_checkpoint_interval = MPI_PMEM_DEFAULT_FULL_CHECKPOINT_INTERVAL;
+   win->delta_checkpoints = false;
+   win->async_checkpoints = false;
+   win->checkpoint_threads = MPI_PMEM_DEFAULT_CHECKPOINT_THREADS;
+   win->checkpoint_codec = MPI_PMEM_CODEC_NONE;
+   win->dedup_checkpoints = false;
+   win->zero_copy_restore = false;
+   win->lazy_restore = false;
+   win->aggregate_checkpoints = false;
+   win->checkpoint_mtbf = 0;
+   win->checkpoint_overhead = 0;
+   win->track_dirty_ranges = false;
+   win->checkpoint_writers = 0;
+   win->checkpoint_rate = 0;
+   win->stripe_size = 0;
+   win->map_sync = false;
+   win->prefault = false;
+   win->checkpoint_slots = 0;
    win->mode = MPI_PMEM_MODE_EXPAND;
    win->modifiable_values = malloc(sizeof(MPI_Win_pmem_modifiable));
    if (win->modifiable_values == NULL) {
       mpi_log_error("Unable to allocate memory.");
-      MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
       return MPI_ERR_PMEM_NO_MEM;
    }
    win->modifiable_values->transactional = false;
@@ -209,7 +500,32 @@ int set_default_window_metadata(MPI_Win_pmem *win, MPI_Comm comm) {
    win->modifiable_values->last_checkpoint_version = 0;
    win->modifiable_values->next_checkpoint_version = 0;
    win->modifiable_values->highest_checkpoint_version = 0;
+   win->modifiable_values->checkpoint_chain_length = 0;
+   win->modifiable_values->page_digests = NULL;
+   win->modifiable_values->page_digests_valid = false;
+   win->modifiable_values->delta_reference = NULL;
+   win->modifiable_values->pending_checkpoint = NULL;
+   win->modifiable_values->queued_checkpoint = NULL;
+   win->modifiable_values->checkpoint_staging_buffer = NULL;
+   win->modifiable_values->copy_pool = NULL;
+   win->modifiable_values->next_area_id = 0;
+   win->modifiable_values->restore_on_attach = false;
    win->modifiable_values->memory_areas = NULL;
+   win->modifiable_values->areas_index = NULL;
+   win->modifiable_values->versions = NULL;
+   win->modifiable_values->versions_file_size = 0;
+   win->modifiable_values->global_checkpoint_version = -1;
+   win->modifiable_values->epoch = NULL;
+   win->modifiable_values->checkpoint_cost = 0.0;
+   win->modifiable_values->last_checkpoint_time = MPI_Wtime();
+   win->modifiable_values->dirty_tracker = NULL;
+   win->modifiable_values->throttle = NULL;
+   win->modifiable_values->aggregator = NULL;
+   win->modifiable_values->shared_base = NULL;
+   win->modifiable_values->shared_size = 0;
+   win->modifiable_values->shared_segments = NULL;
+   win->modifiable_values->lazy_restore = NULL;
+   win->modifiable_values->slot_ring = NULL;
 
    return MPI_SUCCESS;
 }
@@ -247,7 +563,7 @@ int parse_mpi_info_name(MPI_Comm comm, MPI_Info info, char *result) {
    CHECK_ERROR_CODE(error);
    if (!flag || value_length > MPI_PMEM_MAX_NAME - 1) {
       mpi_log_error("pmem_name not defined or too long.");
-      MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM_NAME);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NAME);
       return MPI_ERR_PMEM_NAME;
    }
    error = MPI_Info_get(info, "pmem_name", MPI_PMEM_MAX_NAME, result, &flag);
@@ -267,7 +583,7 @@ int parse_mpi_info_mode(MPI_Comm comm, MPI_Info info, int *result) {
    CHECK_ERROR_CODE(error);
    if (!flag) {
       mpi_log_error("pmem_mode not defined.");
-      MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM_MODE);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_MODE);
       return MPI_ERR_PMEM_MODE;
    }
    if (strcmp(value, "expand") == 0) {
@@ -276,7 +592,7 @@ int parse_mpi_info_mode(MPI_Comm comm, MPI_Info info, int *result) {
       *result = MPI_PMEM_MODE_CHECKPOINT;
    } else {
       mpi_log_error("Undefined value '%s' for key pmem_mode.", value);
-      MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM_MODE);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_MODE);
       return MPI_ERR_PMEM_MODE;
    }
 
@@ -300,7 +616,7 @@ int parse_mpi_info_checkpoint_version(MPI_Comm comm, MPI_Info info, int *result)
    value = malloc((value_length + 1) * sizeof(char));
    if (value == NULL) {
       mpi_log_error("Unable to allocate memory.");
-      MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
       return MPI_ERR_PMEM_NO_MEM;
    }
    error = MPI_Info_get(info, "pmem_checkpoint_version", value_length + 1, value, &flag);
@@ -313,37 +629,138 @@ int parse_mpi_info_checkpoint_version(MPI_Comm comm, MPI_Info info, int *result)
    return MPI_SUCCESS;
 }
 
+int parse_mpi_info_int(MPI_Comm comm, MPI_Info info, const char *key, int default_value, int *result) {
+   int error, flag;
+   int value_length;
+   char *value;
+
+   error = MPI_Info_get_valuelen(info, key, &value_length, &flag);
+   CHECK_ERROR_CODE(error);
+   if (!flag) {
+      *result = default_value;
+      mpi_log_debug("%s: %d", key, *result);
+      return MPI_SUCCESS;
+   }
+   value = malloc((value_length + 1) * sizeof(char));
+   if (value == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   error = MPI_Info_get(info, key, value_length + 1, value, &flag);
+   CHECK_ERROR_CODE(error);
+   *result = atoi(value);
+   free(value);
+
+   mpi_log_debug("%s: %d", key, *result);
+
+   return MPI_SUCCESS;
+}
+
+int parse_mpi_info_checkpoint_threads(MPI_Comm comm, MPI_Info info, int *threads) {
+   int result;
+
+   result = parse_mpi_info_int(comm, info, "pmem_checkpoint_threads", MPI_PMEM_DEFAULT_CHECKPOINT_THREADS, threads);
+   CHECK_ERROR_CODE(result);
+   if (*threads < 1) {
+      mpi_log_error("Invalid value %d for key pmem_checkpoint_threads.", *threads);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_ARG);
+      return MPI_ERR_PMEM_ARG;
+   }
+
+   return MPI_SUCCESS;
+}
+
+int parse_mpi_info_checkpoint_schedule(MPI_Comm comm, MPI_Info info, int *mtbf, int *overhead) {
+   int result;
+
+   result = parse_mpi_info_int(comm, info, "pmem_checkpoint_mtbf", 0, mtbf);
+   CHECK_ERROR_CODE(result);
+   if (*mtbf < 0) {
+      mpi_log_error("Invalid value %d for key pmem_checkpoint_mtbf.", *mtbf);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_ARG);
+      return MPI_ERR_PMEM_ARG;
+   }
+   result = parse_mpi_info_int(comm, info, "pmem_checkpoint_overhead", 0, overhead);
+   CHECK_ERROR_CODE(result);
+   if (*overhead < 0 || *overhead > 100) {
+      mpi_log_error("Invalid value %d for key pmem_checkpoint_overhead.", *overhead);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_ARG);
+      return MPI_ERR_PMEM_ARG;
+   }
+
+   return MPI_SUCCESS;
+}
+
+int parse_mpi_info_checkpoint_throttle(MPI_Comm comm, MPI_Info info, int *writers, int *rate) {
+   int result;
+
+   result = parse_mpi_info_int(comm, info, "pmem_checkpoint_writers", 0, writers);
+   CHECK_ERROR_CODE(result);
+   if (*writers < 0) {
+      mpi_log_error("Invalid value %d for key pmem_checkpoint_writers.", *writers);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_ARG);
+      return MPI_ERR_PMEM_ARG;
+   }
+   result = parse_mpi_info_int(comm, info, "pmem_checkpoint_rate", 0, rate);
+   CHECK_ERROR_CODE(result);
+   if (*rate < 0) {
+      mpi_log_error("Invalid value %d for key pmem_checkpoint_rate.", *rate);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_ARG);
+      return MPI_ERR_PMEM_ARG;
+   }
+
+   return MPI_SUCCESS;
+}
+
+int parse_mpi_info_checkpoint_codec(MPI_Comm comm, MPI_Info info, char *codec) {
+   int error, flag;
+   int value_length = 15; // Values longer than 15 characters aren't names of any codec.
+   char value[16];
+   const MPI_Win_pmem_codec *checkpoint_codec;
+
+   error = MPI_Info_get(info, "pmem_checkpoint_codec", value_length, value, &flag);
+   CHECK_ERROR_CODE(error);
+   if (!flag) {
+      *codec = MPI_PMEM_CODEC_NONE;
+      mpi_log_debug("pmem_checkpoint_codec: none");
+      return MPI_SUCCESS;
+   }
+   checkpoint_codec = find_codec_by_name(value);
+   if (checkpoint_codec == NULL) {
+      mpi_log_error("Undefined value '%s' for key pmem_checkpoint_codec.", value);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_ARG);
+      return MPI_ERR_PMEM_ARG;
+   }
+   *codec = checkpoint_codec->id;
+
+   mpi_log_debug("pmem_checkpoint_codec: %s", value);
+
+   return MPI_SUCCESS;
+}
+
 int check_if_window_exists_and_its_size(MPI_Win_pmem *win, MPI_Aint size, bool *exists) {
    int result, i;
-   char metadata_file_name[MPI_PMEM_MAX_ROOT_PATH + 9]; // 9 == length of "/.windows"
-   off_t metadata_file_size;
-   MPI_Win_pmem_metadata *windows;
+   MPI_Win_pmem_windows_index index;
 
    // Open global metadata file.
-   sprintf(metadata_file_name, "%s/.windows", mpi_pmem_root_path);
-   result = get_file_size(win->comm, metadata_file_name, &metadata_file_size);
-   CHECK_ERROR_CODE(result);
-   result = open_pmem_file(win->comm, metadata_file_name, metadata_file_size, (void**) &windows);
+   result = open_windows_index(win->comm, &index);
    CHECK_ERROR_CODE(result);
    *exists = false;
 
    // Find window and it's size.
-   for (i = 0; windows[i].flags != MPI_PMEM_FLAG_NO_OBJECT; i++) {
-      if (strcmp(windows[i].name, win->name) == 0) {
-         if (windows[i].flags == MPI_PMEM_FLAG_OBJECT_EXISTS) {
-            *exists = true;
-            if (win->mode == MPI_PMEM_MODE_CHECKPOINT) {
-               if (size != windows[i].size) {
-                  mpi_log_error("Requested windows size %d is different than saved size %d.", size, windows[i].size);
-                  MPI_Comm_call_errhandler(win->comm, MPI_ERR_SIZE);
-                  return MPI_ERR_SIZE;
-               }
-            }
+   i = find_window_record(&index, win->name);
+   if (i >= 0 && index.windows[i].flags == MPI_PMEM_FLAG_OBJECT_EXISTS) {
+      *exists = true;
+      if (win->mode == MPI_PMEM_MODE_CHECKPOINT) {
+         if (size != index.windows[i].size) {
+            mpi_log_error("Requested windows size %d is different than saved size %d.", size, index.windows[i].size);
+            call_comm_errhandler(win->comm, MPI_ERR_SIZE);
+            return MPI_ERR_SIZE;
          }
-         break;
       }
    }
-   result = unmap_pmem_file(win->comm, windows, metadata_file_size);
+   result = close_windows_index(win->comm, &index);
    CHECK_ERROR_CODE(result);
 
    return MPI_SUCCESS;
@@ -351,10 +768,7 @@ int check_if_window_exists_and_its_size(MPI_Win_pmem *win, MPI_Aint size, bool *
 
 int create_window_metadata_file(MPI_Comm comm, const char *file_name, MPI_Win_pmem_version **versions, const char *window_name, MPI_Aint window_size) {
    int result, i;
-   bool found;
-   char windows_file_name[MPI_PMEM_MAX_ROOT_PATH + 9]; // 9 == length of "/.windows"
-   MPI_Win_pmem_metadata *windows;
-   off_t file_size;
+   MPI_Win_pmem_windows_index index;
 
    mpi_log_debug("Creating metadata file '%s'.", file_name);
 
@@ -368,53 +782,26 @@ int create_window_metadata_file(MPI_Comm comm, const char *file_name, MPI_Win_pm
    CHECK_ERROR_CODE(result);
 
    // Open global metadata file.
-   sprintf(windows_file_name, "%s/.windows", mpi_pmem_root_path);
-   result = get_file_size(comm, windows_file_name, &file_size);
-   CHECK_ERROR_CODE(result);
-   result = open_pmem_file(comm, windows_file_name, file_size, (void**) &windows);
-   CHECK_ERROR_CODE(result);
-   found = false;
-
-   // Update window's metadata if it existed previously.
-   for (i = 0; windows[i].flags != MPI_PMEM_FLAG_NO_OBJECT; i++) {
-      if (strcmp(window_name, windows[i].name) == 0) {
-         // Update size
-         windows[i].size = window_size;
-         result = persist_pmem_file(comm, &windows[i].size, sizeof(MPI_Aint));
-         CHECK_ERROR_CODE(result);
-         // Set flag to indicate that window exists.
-         windows[i].flags = MPI_PMEM_FLAG_OBJECT_EXISTS;
-         result = persist_pmem_file(comm, &windows[i].flags, sizeof(char));
-         CHECK_ERROR_CODE(result);
-         found = true;
-         break;
-      }
-   }
-   result = unmap_pmem_file(comm, windows, file_size);
+   result = open_windows_index(comm, &index);
    CHECK_ERROR_CODE(result);
 
-   // Add new record to global metadata file if window with this name is created for the first time.
-   if (!found) {
-      file_size = (i + 2) * sizeof(MPI_Win_pmem_metadata);
-      result = open_pmem_file(comm, windows_file_name, file_size, (void**) &windows);
-      CHECK_ERROR_CODE(result);
-      // Create new terminating record.
-      windows[i + 1].size = 0;
-      windows[i + 1].flags = MPI_PMEM_FLAG_NO_OBJECT;
-      result = persist_pmem_file(comm, &windows[i + 1], sizeof(MPI_Win_pmem_metadata));
-      CHECK_ERROR_CODE(result);
-      // Update window's metadata in previous terminating record.
-      strcpy(windows[i].name, window_name);
-      windows[i].size = window_size;
-      result = persist_pmem_file(comm, &windows[i], sizeof(MPI_Win_pmem_metadata));
+   i = find_window_record(&index, window_name);
+   if (i >= 0) {
+      // Update window's metadata if it existed previously.
+      index.windows[i].size = window_size;
+      result = persist_pmem_file(comm, &index.windows[i].size, sizeof(MPI_Aint));
       CHECK_ERROR_CODE(result);
       // Set flag to indicate that window exists.
-      windows[i].flags = MPI_PMEM_FLAG_OBJECT_EXISTS;
-      result = persist_pmem_file(comm, &windows[i].flags, sizeof(bool));
+      index.windows[i].flags = MPI_PMEM_FLAG_OBJECT_EXISTS;
+      result = persist_pmem_file(comm, &index.windows[i].flags, sizeof(char));
       CHECK_ERROR_CODE(result);
-      result = unmap_pmem_file(comm, windows, file_size);
+   } else {
+      // Add new record to global metadata file if window with this name is created for the first time.
+      result = append_window_record(comm, &index, window_name, window_size, &i);
       CHECK_ERROR_CODE(result);
    }
+   result = close_windows_index(comm, &index);
+   CHECK_ERROR_CODE(result);
 
    mpi_log_debug("Metadata file '%s' created.", file_name);
 
@@ -423,39 +810,38 @@ int create_window_metadata_file(MPI_Comm comm, const char *file_name, MPI_Win_pm
 
 int update_window_size_in_metadata_file(MPI_Win_pmem *win, MPI_Aint size) {
    int result, i;
-   off_t metadata_file_size;
-   MPI_Win_pmem_metadata *windows;
+   MPI_Win_pmem_windows_index index;
 
-   result = open_windows_metadata_file(win->comm, &windows, &metadata_file_size);
+   result = open_windows_index(win->comm, &index);
    CHECK_ERROR_CODE(result);
-   for (i = 0; windows[i].flags != MPI_PMEM_FLAG_NO_OBJECT; i++) {
-      if (strcmp(windows[i].name, win->name) == 0) {
-         if (windows[i].flags != MPI_PMEM_FLAG_OBJECT_EXISTS) {
-            mpi_log_error("Window with name '%s' has been deleted.", win->name);
-            MPI_Comm_call_errhandler(win->comm, MPI_ERR_PMEM_NAME);
-            return MPI_ERR_PMEM_NAME;
-         }
-         // No need for flag modification as all previous checkpoints will already be deleted and if anything fails, on restart, window will have to be created again in expand mode.
-         windows[i].size = size;
-         result = persist_pmem_file(win->comm, &windows[i].size, sizeof(MPI_Aint));
-         CHECK_ERROR_CODE(result);
-         result = unmap_pmem_file(win->comm, windows, metadata_file_size);
-         CHECK_ERROR_CODE(result);
-         return MPI_SUCCESS;
+   i = find_window_record(&index, win->name);
+   if (i >= 0) {
+      if (index.windows[i].flags != MPI_PMEM_FLAG_OBJECT_EXISTS) {
+         mpi_log_error("Window with name '%s' has been deleted.", win->name);
+         call_comm_errhandler(win->comm, MPI_ERR_PMEM_NAME);
+         return MPI_ERR_PMEM_NAME;
       }
+      // No need for flag modification as all previous checkpoints will already be deleted and if anything fails, on restart, window will have to be created again in expand mode.
+      index.windows[i].size = size;
+      result = persist_pmem_file(win->comm, &index.windows[i].size, sizeof(MPI_Aint));
+      CHECK_ERROR_CODE(result);
+      result = close_windows_index(win->comm, &index);
+      CHECK_ERROR_CODE(result);
+      return MPI_SUCCESS;
    }
-   result = unmap_pmem_file(win->comm, windows, metadata_file_size);
+   result = close_windows_index(win->comm, &index);
    CHECK_ERROR_CODE(result);
 
    mpi_log_error("Window with name '%s' doesn't exist.", win->name);
-   MPI_Comm_call_errhandler(win->comm, MPI_ERR_PMEM_NAME);
+   call_comm_errhandler(win->comm, MPI_ERR_PMEM_NAME);
    return MPI_ERR_PMEM_NAME;
 }
 
 int set_checkpoint_versions(MPI_Win_pmem *win, MPI_Win_pmem_version *versions) {
-   int i;
+   int result, i, global_version, global_epoch;
    int last_checkpoint_on_all_processes;
    char version_available, version_available_on_all_processes;
+   MPI_Win_pmem_epoch *epoch;
 
    if (win->mode == MPI_PMEM_MODE_CHECKPOINT) {
       if (win->modifiable_values->last_checkpoint_version == -1) { // Last checkpoint version is not set and should be set to highest.
@@ -466,17 +852,46 @@ int set_checkpoint_versions(MPI_Win_pmem *win, MPI_Win_pmem_version *versions) {
             }
          }
 
-         // If window is globally consistent find latest consistent version in all processes.
+         // If window is globally consistent use version committed by all processes or find latest consistent version in all processes if there is none.
+         // Crash during global commit can leave some processes with previous epoch. Version of the latest epoch was written by all processes before any of
+         // them stored it, so processes agree on it and the ones left behind roll their records forward.
          if (win->global_checkpoint) {
+            result = open_window_epoch(*win, &epoch);
+            CHECK_ERROR_CODE(result);
+            result = MPI_Allreduce(&epoch->epoch, &global_epoch, 1, MPI_INT, MPI_MAX, win->comm);
+            CHECK_ERROR_CODE(result);
+            global_version = epoch->epoch == global_epoch && global_epoch > 0 ? epoch->version : -1;
+            result = MPI_Allreduce(MPI_IN_PLACE, &global_version, 1, MPI_INT, MPI_MAX, win->comm);
+            CHECK_ERROR_CODE(result);
+         }
+         if (win->global_checkpoint && global_version != -1) {
+            version_available = global_version < i && versions[global_version].flags == MPI_PMEM_FLAG_OBJECT_EXISTS ? 1 : 0;
+            result = MPI_Allreduce(&version_available, &version_available_on_all_processes, 1, MPI_CHAR, MPI_MIN, win->comm);
+            CHECK_ERROR_CODE(result);
+            if (version_available_on_all_processes == 0) {
+               mpi_log_error("Globally committed checkpoint version %d of window '%s' doesn't exist in all processes.", global_version, win->name);
+               call_comm_errhandler(win->comm, MPI_ERR_PMEM_CKPT_VER);
+               return MPI_ERR_PMEM_CKPT_VER;
+            }
+            if (epoch->epoch != global_epoch || epoch->version != global_version) {
+               mpi_log_debug("Rolling global epoch record forward to epoch %d.", global_epoch);
+               result = store_global_epoch(win->comm, epoch, global_version, global_epoch);
+               CHECK_ERROR_CODE(result);
+            }
+            mpi_log_debug("Restoring globally committed checkpoint version %d.", global_version);
+            win->modifiable_values->last_checkpoint_version = global_version;
+            win->modifiable_values->global_checkpoint_version = global_version;
+         } else if (win->global_checkpoint) {
             MPI_Allreduce(&win->modifiable_values->last_checkpoint_version, &last_checkpoint_on_all_processes, 1, MPI_INT, MPI_MIN, win->comm);
-            version_available = versions[last_checkpoint_on_all_processes].flags == MPI_PMEM_FLAG_OBJECT_EXISTS ? 1 : 0;
+            version_available = last_checkpoint_on_all_processes >= 0 && versions[last_checkpoint_on_all_processes].flags == MPI_PMEM_FLAG_OBJECT_EXISTS ? 1 : 0;
             MPI_Allreduce(&version_available, &version_available_on_all_processes, 1, MPI_CHAR, MPI_MIN, win->comm);
             if (version_available_on_all_processes == 0) {
                mpi_log_error("One of processes doesn't have checkpoint version %d.", last_checkpoint_on_all_processes);
-               MPI_Comm_call_errhandler(win->comm, MPI_ERR_PMEM);
+               call_comm_errhandler(win->comm, MPI_ERR_PMEM);
                return MPI_ERR_PMEM;
             }
             win->modifiable_values->last_checkpoint_version = last_checkpoint_on_all_processes;
+            win->modifiable_values->global_checkpoint_version = last_checkpoint_on_all_processes;
          }
          win->modifiable_values->next_checkpoint_version = win->modifiable_values->last_checkpoint_version + 1;
       } else {
@@ -488,7 +903,7 @@ int set_checkpoint_versions(MPI_Win_pmem *win, MPI_Win_pmem_version *versions) {
          if (win->modifiable_values->last_checkpoint_version < 0 || win->modifiable_values->last_checkpoint_version >= i ||
              versions[win->modifiable_values->last_checkpoint_version].flags != MPI_PMEM_FLAG_OBJECT_EXISTS) {
             mpi_log_error("Version %d of window '%s' doesn't exist.", win->modifiable_values->last_checkpoint_version, win->name);
-            MPI_Comm_call_errhandler(win->comm, MPI_ERR_PMEM_CKPT_VER);
+            call_comm_errhandler(win->comm, MPI_ERR_PMEM_CKPT_VER);
             return MPI_ERR_PMEM_CKPT_VER;
          }
          win->modifiable_values->next_checkpoint_version = win->append_checkpoints ? i : win->modifiable_values->last_checkpoint_version + 1;
@@ -504,135 +919,897 @@ int set_checkpoint_versions(MPI_Win_pmem *win, MPI_Win_pmem_version *versions) {
    return MPI_SUCCESS;
 }
 
-int copy_data_from_checkpoint(MPI_Win_pmem win, MPI_Aint size, void *destination) {
+int update_window_stripes_in_metadata_file(MPI_Win_pmem *win) {
+   int result, i, stripe_root_path;
+   MPI_Win_pmem_windows_index index;
+
+   stripe_root_path = win->stripe_size > 0 ? mpi_pmem_root_path_index + 1 : 0;
+   result = open_windows_index(win->comm, &index);
+   CHECK_ERROR_CODE(result);
+   i = find_window_record(&index, win->name);
+   if (i >= 0 && index.windows[i].stripe_root_path != stripe_root_path) {
+      // Parts of data file striped by previous run aren't used anymore (window isn't striped or local root path has changed).
+      if (index.windows[i].stripe_root_path > 0) {
+         result = remove_striped_pmem_file(win->comm, win->name, index.windows[i].stripe_root_path - 1);
+         if (result != MPI_SUCCESS) {
+            close_windows_index(win->comm, &index);
+            return result;
+         }
+      }
+      index.windows[i].stripe_root_path = stripe_root_path;
+      result = persist_pmem_file(win->comm, &index.windows[i].stripe_root_path, sizeof(int));
+      if (result != MPI_SUCCESS) {
+         close_windows_index(win->comm, &index);
+         return result;
+      }
+   }
+   result = close_windows_index(win->comm, &index);
+   CHECK_ERROR_CODE(result);
+
+   return MPI_SUCCESS;
+}
+
+int load_window_metadata(MPI_Win_pmem *win, MPI_Aint size) {
+   int result;
+   char *file_name;
+   MPI_Win_pmem_version *versions;
+   off_t versions_file_size;
+   bool window_exists;
+
+   file_name = malloc((strlen(mpi_pmem_root_path) + strlen(win->name) + 3) * sizeof(char)); // Additional 3 characters for: "/." and terminating zero.
+   if (file_name == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(win->comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+
+   // Check if window already exists in metadata and create it if not.
+   result = check_if_window_exists_and_its_size(win, size, &window_exists);
+   CHECK_ERROR_CODE(result);
+   sprintf(file_name, "%s/.%s", mpi_pmem_root_path, win->name);
+   if (window_exists) {
+      result = get_file_size(win->comm, file_name, &versions_file_size);
+      CHECK_ERROR_CODE(result);
+      result = open_pmem_file(win->comm, file_name, versions_file_size, (void**) &versions);
+      CHECK_ERROR_CODE(result);
+      // Cleanup old window's versions when expanding window.
+      if (win->mode == MPI_PMEM_MODE_EXPAND) {
+         result = delete_old_checkpoints(win->comm, win->name, versions);
+         CHECK_ERROR_CODE(result);
+         result = update_window_size_in_metadata_file(win, size);
+         CHECK_ERROR_CODE(result);
+      }
+   } else {
+      if (win->mode == MPI_PMEM_MODE_CHECKPOINT) {
+         mpi_log_error("Window with name '%s' doesn't exist.", win->name);
+         call_comm_errhandler(win->comm, MPI_ERR_PMEM_NAME);
+         return MPI_ERR_PMEM_NAME;
+      }
+      result = create_window_metadata_file(win->comm, file_name, &versions, win->name, size);
+      CHECK_ERROR_CODE(result);
+      versions_file_size = sizeof(MPI_Win_pmem_version);
+   }
+   // Layout of data file is saved, so its parts can be deleted after restart.
+   result = update_window_stripes_in_metadata_file(win);
+   CHECK_ERROR_CODE(result);
+   result = set_checkpoint_versions(win, versions);
+   CHECK_ERROR_CODE(result);
+   // Versions metadata file stays mapped, so checkpoints don't have to map it again.
+   win->modifiable_values->versions = versions;
+   win->modifiable_values->versions_file_size = versions_file_size;
+   free(file_name);
+
+   return MPI_SUCCESS;
+}
+
+int restore_memory_area(MPI_Win_pmem win, MPI_Win_memory_areas_list *memory_area) {
    int result;
    char *file_name;
-   void *checkpoint_data;
 
    // Additional 14 characters for: "/.", "-", 10 characters for checkpoint number (length of maximum 4 byte integer number written in decimal form is 10 characters) and terminating zero.
    file_name = malloc((strlen(mpi_pmem_root_path) + strlen(win.name) + 14) * sizeof(char));
    if (file_name == NULL) {
       mpi_log_error("Unable to allocate memory.");
-      MPI_Comm_call_errhandler(win.comm, MPI_ERR_PMEM_NO_MEM);
+      call_win_errhandler(win.win, MPI_ERR_PMEM_NO_MEM);
       return MPI_ERR_PMEM_NO_MEM;
    }
    sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, win.name, win.modifiable_values->last_checkpoint_version);
-   if (check_if_file_exist(file_name)) {
+   result = restore_extent(win.comm, file_name, memory_area->id, memory_area->base, memory_area->size);
+   CHECK_ERROR_CODE(result);
+   free(file_name);
+
+   return MPI_SUCCESS;
+}
+
+int copy_data_from_checkpoint(MPI_Win_pmem win, MPI_Aint size, void *destination) {
+   int result, versions_count = 0;
+   char *file_name;
+   void *checkpoint_data;
+   MPI_Win_pmem_version *versions;
+
+   // Additional 14 characters for: "/.", "-", 10 characters for checkpoint number (length of maximum 4 byte integer number written in decimal form is 10 characters) and terminating zero.
+   file_name = malloc((strlen(mpi_pmem_root_path) + strlen(win.name) + 14) * sizeof(char));
+   if (file_name == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(win.comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   // Incremental checkpoints have to be rebuilt from last full checkpoint, compressed ones have to be decoded and deduplicated ones gathered from chunk store, so check checkpoint format in window's versions metadata file.
+   sprintf(file_name, "%s/.%s", mpi_pmem_root_path, win.name);
+   versions = NULL;
+   if (win.modifiable_values->versions != NULL || check_if_file_exist(file_name)) {
+      result = open_window_versions(win, &versions);
+      CHECK_ERROR_CODE(result);
+      for (versions_count = 0; versions[versions_count].flags != MPI_PMEM_FLAG_NO_OBJECT; versions_count++) {
+      }
+      // Aggregated checkpoint is stored in node checkpoint file of node leader.
+      if (win.modifiable_values->last_checkpoint_version < versions_count &&
+          versions[win.modifiable_values->last_checkpoint_version].format == MPI_PMEM_CHECKPOINT_AGGREGATED) {
+         free(file_name);
+         if (win.modifiable_values->aggregator == NULL) {
+            mpi_log_error("Checkpoint version %d is aggregated per node, window has to be created with pmem_checkpoint_aggregate.", win.modifiable_values->last_checkpoint_version);
+            call_comm_errhandler(win.comm, MPI_ERR_PMEM);
+            return MPI_ERR_PMEM;
+         }
+         win.modifiable_values->checkpoint_chain_length = 0;
+         return read_aggregated_checkpoint(win.modifiable_values->aggregator, win.name, versions[win.modifiable_values->last_checkpoint_version].parent_version, size, destination,
+                                           win.modifiable_values->copy_pool);
+      }
+      if (win.modifiable_values->last_checkpoint_version >= versions_count ||
+          (versions[win.modifiable_values->last_checkpoint_version].format == MPI_PMEM_CHECKPOINT_FULL &&
+           versions[win.modifiable_values->last_checkpoint_version].codec == MPI_PMEM_CODEC_NONE)) {
+         versions = NULL;
+      }
+   }
+
+   if (versions != NULL) {
+      result = restore_checkpoint_chain(win.comm, win.name, versions, versions_count, win.modifiable_values->last_checkpoint_version, size, destination, win.modifiable_values->copy_pool,
+                                        &win.modifiable_values->checkpoint_chain_length);
+      CHECK_ERROR_CODE(result);
+   } else {
+      sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, win.name, win.modifiable_values->last_checkpoint_version);
+      if (!check_if_file_exist(file_name)) {
+         mpi_log_error("Checkpoint file '%s' doesn't exist.", file_name);
+         call_comm_errhandler(win.comm, MPI_ERR_PMEM);
+         return MPI_ERR_PMEM;
+      }
       result = open_pmem_file(win.comm, file_name, size, &checkpoint_data);
       CHECK_ERROR_CODE(result);
-      memcpy(destination, checkpoint_data, size);
+      parallel_memcpy(win.modifiable_values->copy_pool, destination, checkpoint_data, size);
       result = unmap_pmem_file(win.comm, checkpoint_data, size);
       CHECK_ERROR_CODE(result);
-   } else {
+      win.modifiable_values->checkpoint_chain_length = 0;
+   }
+   free(file_name);
+
+   return MPI_SUCCESS;
+}
+
+int map_checkpoint_as_window(MPI_Win_pmem win, MPI_Aint size, void **address, bool *mapped) {
+   int result, checkpoint_fd, data_fd;
+   char *file_name;
+   MPI_Win_pmem_version *versions;
+   int version = win.modifiable_values->last_checkpoint_version;
+
+   *mapped = false;
+   if (version < 0) {
+      return MPI_SUCCESS;
+   }
+
+   // Check whether checkpoint file contains plain copy of window.
+   result = open_window_versions(win, &versions);
+   CHECK_ERROR_CODE(result);
+   *mapped = (off_t) ((version + 1) * sizeof(MPI_Win_pmem_version)) < win.modifiable_values->versions_file_size && versions[version].flags == MPI_PMEM_FLAG_OBJECT_EXISTS &&
+             versions[version].format == MPI_PMEM_CHECKPOINT_FULL && versions[version].codec == MPI_PMEM_CODEC_NONE;
+   if (!*mapped) {
+      mpi_log_debug("Checkpoint version %d of window '%s' can't be mapped, it will be copied.", version, win.name);
+      return MPI_SUCCESS;
+   }
+
+   // Additional 14 characters for: "/.", "-", 10 characters for checkpoint number (length of maximum 4 byte integer number written in decimal form is 10 characters) and terminating zero.
+   file_name = malloc((strlen(mpi_pmem_root_path) + strlen(win.name) + 14) * sizeof(char));
+   if (file_name == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(win.comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, win.name, version);
+   if ((checkpoint_fd = open(file_name, O_RDONLY)) < 0) {
       mpi_log_error("Checkpoint file '%s' doesn't exist.", file_name);
-      MPI_Comm_call_errhandler(win.comm, MPI_ERR_PMEM);
+      free(file_name);
+      call_comm_errhandler(win.comm, MPI_ERR_PMEM);
       return MPI_ERR_PMEM;
    }
+
+   // Share blocks of checkpoint file with window's data file, so writes to window don't modify checkpoint.
+   sprintf(file_name, "%s/%s", mpi_pmem_root_path, win.name);
+   if ((data_fd = open(file_name, O_CREAT | O_RDWR, 0666)) >= 0 && ioctl(data_fd, FICLONE, checkpoint_fd) == 0) {
+      close(data_fd);
+      close(checkpoint_fd);
+      mpi_log_debug("Checkpoint version %d of window '%s' cloned into data file.", version, win.name);
+      result = open_pmem_file(win.comm, file_name, size, address);
+      free(file_name);
+      return result;
+   }
+   if (data_fd >= 0) {
+      close(data_fd);
+   }
    free(file_name);
 
+   // Map checkpoint file privately, so pages are copied only when they are modified.
+   *address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, checkpoint_fd, 0);
+   close(checkpoint_fd);
+   if (*address == MAP_FAILED) {
+      mpi_log_error("Unable to map checkpoint version %d of window '%s' to memory.", version, win.name);
+      call_comm_errhandler(win.comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   mpi_log_debug("Checkpoint version %d of window '%s' mapped privately.", version, win.name);
+
    return MPI_SUCCESS;
 }
 
-int create_checkpoint(MPI_Win_pmem win, bool fence) {
+// Flags, format, codec and parent version of version record have to share single aligned 8-byte word, which is committed with one failure-atomic store.
+typedef char MPI_Win_pmem_version_commit_word_check[(offsetof(MPI_Win_pmem_version, flags) % sizeof(uint64_t) == 0 &&
+                                                     offsetof(MPI_Win_pmem_version, parent_version) + sizeof(int) <= offsetof(MPI_Win_pmem_version, flags) + sizeof(uint64_t)) ? 1 : -1];
+
+/**
+ * Commit record in window's versions metadata file: flags, format, codec and parent version are written with single 8-byte store and persisted. Other fields
+ * of record have to be persisted before, crash leaves record either committed entirely or in previous state.
+ *
+ * @param comm            Communicator used for error handling.
+ * @param record          Record to commit.
+ * @param flags           New flags of record.
+ * @param format          New format of checkpoint.
+ * @param codec           New codec of checkpoint.
+ * @param parent_version  New parent version of checkpoint.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int commit_version_record(MPI_Comm comm, MPI_Win_pmem_version *record, char flags, char format, char codec, int parent_version) {
+   MPI_Win_pmem_version committed;
+   uint64_t word;
+   uint64_t *destination = (uint64_t*) ((char*) record + offsetof(MPI_Win_pmem_version, flags));
+
+   memcpy(&committed, record, sizeof(MPI_Win_pmem_version));
+   committed.flags = flags;
+   committed.format = format;
+   committed.codec = codec;
+   committed.parent_version = parent_version;
+   memcpy(&word, (char*) &committed + offsetof(MPI_Win_pmem_version, flags), sizeof(uint64_t));
+   __atomic_store_n(destination, word, __ATOMIC_RELEASE);
+
+   return persist_pmem_file(comm, destination, sizeof(uint64_t));
+}
+
+/**
+ * Prepare new checkpoint: update checkpoint version variables and find pages which have to be saved.
+ *
+ * @param win        Window object.
+ * @param fence      Flag specifying whether function is called from MPI_Win_fence.
+ * @param checkpoint Output variable for prepared checkpoint. Must be freed by finish_checkpoint.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int prepare_checkpoint(MPI_Win_pmem win, bool fence, MPI_Win_pmem_checkpoint **checkpoint) {
    int result;
-   char *file_name;
-   FILE *checkpoint_file;
-   int root_file_descriptor;
+   MPI_Win_pmem_checkpoint *new_checkpoint;
    MPI_Win_pmem_version *versions;
-   off_t versions_file_size;
-   int next_checkpoint_version, last_checkpoint_version, highest_checkpoint_version;
-   bool creating_new_version = false;
 
-   if (win.is_pmem && !win.is_volatile && win.modifiable_values->transactional) {
-      // Update checkpoint version variables.
-      next_checkpoint_version = win.modifiable_values->next_checkpoint_version++;
-      if (next_checkpoint_version > win.modifiable_values->highest_checkpoint_version) {
-         win.modifiable_values->highest_checkpoint_version = next_checkpoint_version;
-         creating_new_version = true;
+   new_checkpoint = malloc(sizeof(MPI_Win_pmem_checkpoint));
+   if (new_checkpoint == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_win_errhandler(win.win, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   new_checkpoint->win = win;
+   new_checkpoint->fence = fence;
+   new_checkpoint->incremental = false;
+   new_checkpoint->delta = false;
+   // Checkpoint of dynamic window contains all attached memory areas.
+   new_checkpoint->extents = !win.created_via_allocate;
+   new_checkpoint->data = new_checkpoint->extents ? NULL : win.modifiable_values->memory_areas->base;
+   new_checkpoint->size = new_checkpoint->extents ? 0 : win.modifiable_values->memory_areas->size;
+   new_checkpoint->packed = false;
+   // Node checkpoint file is written by all processes of node together, so only checkpoints created by all processes are aggregated.
+   new_checkpoint->aggregated = fence && win.modifiable_values->aggregator != NULL;
+   new_checkpoint->slot = -1;
+   new_checkpoint->pages = NULL;
+   new_checkpoint->pages_count = 0;
+   new_checkpoint->delta_data = NULL;
+   new_checkpoint->delta_size = 0;
+   new_checkpoint->page_digests = NULL;
+   new_checkpoint->thread_started = false;
+   new_checkpoint->result = MPI_SUCCESS;
+   new_checkpoint->result_reported = false;
+
+   // Update checkpoint version variables.
+   new_checkpoint->version = win.modifiable_values->next_checkpoint_version++;
+   new_checkpoint->creating_new_version = false;
+   if (new_checkpoint->version > win.modifiable_values->highest_checkpoint_version) {
+      win.modifiable_values->highest_checkpoint_version = new_checkpoint->version;
+      new_checkpoint->creating_new_version = true;
+   }
+   new_checkpoint->last_version = win.modifiable_values->last_checkpoint_version;
+   win.modifiable_values->last_checkpoint_version = new_checkpoint->version;
+   new_checkpoint->highest_version = win.modifiable_values->highest_checkpoint_version;
+   // Make room for new version in metadata file. Metadata file may be remapped, so it isn't done by background thread while calling thread uses it.
+   result = reserve_window_versions(win, new_checkpoint->highest_version + 2, &versions);
+   CHECK_ERROR_CODE(result);
+
+   // Find pages modified since last checkpoint. Every full_checkpoint_interval-th checkpoint is a full one to limit length of chains which have to be applied on restore.
+   if (win.incremental_checkpoints) {
+      new_checkpoint->incremental = win.modifiable_values->page_digests_valid && new_checkpoint->last_version != -1 &&
+                                    win.modifiable_values->checkpoint_chain_length + 1 < win.full_checkpoint_interval;
+      if (new_checkpoint->incremental) {
+         // Previous checkpoint could have been deleted in the meantime.
+         result = open_window_versions(win, &versions);
+         CHECK_ERROR_CODE(result);
+         new_checkpoint->incremental = versions[new_checkpoint->last_version].flags == MPI_PMEM_FLAG_OBJECT_EXISTS;
+      }
+      new_checkpoint->page_digests = malloc((((uint64_t) new_checkpoint->size + MPI_PMEM_CHECKPOINT_PAGE_SIZE - 1) / MPI_PMEM_CHECKPOINT_PAGE_SIZE + 1) * sizeof(uint64_t));
+      if (new_checkpoint->page_digests == NULL) {
+         mpi_log_error("Unable to allocate memory.");
+         call_win_errhandler(win.win, MPI_ERR_PMEM_NO_MEM);
+         return MPI_ERR_PMEM_NO_MEM;
       }
-      last_checkpoint_version = win.modifiable_values->last_checkpoint_version;
-      win.modifiable_values->last_checkpoint_version = next_checkpoint_version;
-      highest_checkpoint_version = win.modifiable_values->highest_checkpoint_version;
+      result = find_modified_pages(win.comm, new_checkpoint->data, new_checkpoint->size, new_checkpoint->incremental ? win.modifiable_values->page_digests : NULL,
+                                   new_checkpoint->page_digests, new_checkpoint->incremental ? &new_checkpoint->pages : NULL, &new_checkpoint->pages_count);
+      CHECK_ERROR_CODE(result);
+      // Digests describe last checkpoint only after it is successfully written.
+      win.modifiable_values->page_digests_valid = false;
+   }
+
+   // Encode changes since last checkpoint, chains of deltas are limited the same way as chains of incremental checkpoints.
+   if (win.delta_checkpoints && !new_checkpoint->extents) {
+      new_checkpoint->delta = win.modifiable_values->delta_reference != NULL && new_checkpoint->last_version != -1 &&
+                              win.modifiable_values->checkpoint_chain_length + 1 < win.full_checkpoint_interval;
+      if (new_checkpoint->delta) {
+         result = open_window_versions(win, &versions);
+         CHECK_ERROR_CODE(result);
+         new_checkpoint->delta = versions[new_checkpoint->last_version].flags == MPI_PMEM_FLAG_OBJECT_EXISTS;
+      }
+      if (new_checkpoint->delta) {
+         result = encode_delta(win.comm, new_checkpoint->data, win.modifiable_values->delta_reference, new_checkpoint->size, &new_checkpoint->delta_data,
+                               &new_checkpoint->delta_size);
+         CHECK_ERROR_CODE(result);
+      }
+   }
+
+   *checkpoint = new_checkpoint;
 
-      // Open checkpoint and metadata files.
+   return MPI_SUCCESS;
+}
+
+/**
+ * Invalidate version overwritten by new checkpoint: global epoch record referring to it, its record in window's versions metadata file, checkpoints depending
+ * on it and chunks referenced by its checkpoint file.
+ *
+ * @param checkpoint Checkpoint overwriting existing version.
+ * @param versions   Mapped window's versions metadata file.
+ * @param file_name  Name of checkpoint file of overwritten version.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int release_overwritten_version(MPI_Win_pmem_checkpoint *checkpoint, MPI_Win_pmem_version *versions, const char *file_name) {
+   int result;
+   MPI_Win_pmem_epoch *epoch;
+   MPI_Win_pmem win = checkpoint->win;
+
+   // Globally committed version (or its base) is overwritten, so global epoch record is invalid until next global commit.
+   if (win.modifiable_values->global_checkpoint_version != -1 &&
+       checkpoint_depends_on(versions, win.modifiable_values->global_checkpoint_version, checkpoint->version)) {
+      result = open_window_epoch(win, &epoch);
+      CHECK_ERROR_CODE(result);
+      result = store_global_epoch(win.comm, epoch, -1, epoch->epoch);
+      CHECK_ERROR_CODE(result);
+      win.modifiable_values->global_checkpoint_version = -1;
+   }
+   versions[checkpoint->version].flags = MPI_PMEM_FLAG_OBJECT_DELETED;
+   result = persist_pmem_file(win.comm, &versions[checkpoint->version].flags, sizeof(char));
+   CHECK_ERROR_CODE(result);
+   // Incremental checkpoints based on overwritten version can't be restored anymore.
+   result = delete_dependent_checkpoints(win, versions, checkpoint->highest_version + 1, checkpoint->version);
+   CHECK_ERROR_CODE(result);
+   // Chunks of overwritten version have to be released before its checkpoint file is truncated.
+   if (check_if_file_exist(file_name)) {
+      result = release_checkpoint_chunks(win.comm, file_name, versions[checkpoint->version].format);
+      CHECK_ERROR_CODE(result);
+   }
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Write checkpoint data file and commit new version in window's versions metadata file. Function may be called from background thread.
+ *
+ * @param checkpoint Checkpoint to write.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int write_checkpoint(MPI_Win_pmem_checkpoint *checkpoint) {
+   int result, prepared_result, node_version = -1;
+   char *file_name = NULL;
+   MPI_Win_pmem_checkpoint_writer writer;
+   MPI_Aint checkpoint_file_size;
+   void *compressed_data = NULL;
+   MPI_Win_pmem_chunk_reference *chunks = NULL;
+   uint64_t chunks_count;
+   MPI_Win_pmem_version *versions;
+   MPI_Win_pmem win = checkpoint->win;
+
+   // Window whose memory wasn't restored contains zeros, which must not replace any checkpoint.
+   result = check_lazy_restore(win);
+   if (result != MPI_SUCCESS && !checkpoint->aggregated) {
+      return result;
+   }
+
+   // Full checkpoints are compressed or stored in chunk store before checkpoint file is created, because size of checkpoint file has to be known in advance.
+   checkpoint->codec = MPI_PMEM_CODEC_NONE;
+   checkpoint->chunked = !checkpoint->extents && !checkpoint->incremental && !checkpoint->delta && win.dedup_checkpoints;
+   if (checkpoint->chunked) {
+      result = store_chunks(win.comm, checkpoint->data, checkpoint->size, &chunks, &chunks_count);
+      CHECK_ERROR_CODE(result);
+   } else if (!checkpoint->extents && !checkpoint->incremental && !checkpoint->delta && win.checkpoint_codec != MPI_PMEM_CODEC_NONE) {
+      result = compress_checkpoint(win.comm, win.checkpoint_codec, checkpoint->data, checkpoint->size, &compressed_data, &checkpoint_file_size);
+      CHECK_ERROR_CODE(result);
+      if (compressed_data != NULL) {
+         checkpoint->codec = win.checkpoint_codec;
+      }
+   }
+
+   // Room for new version was made in metadata file by prepare_checkpoint.
+   if (result == MPI_SUCCESS) {
+      result = open_window_versions(win, &versions);
+   }
+   if (result == MPI_SUCCESS) {
       // Additional 14 characters for: "/.", "-", 10 characters for checkpoint number (length of maximum 4 byte integer number written in decimal form is 10 characters) and terminating zero.
       file_name = malloc((strlen(mpi_pmem_root_path) + strlen(win.name) + 14) * sizeof(char));
       if (file_name == NULL) {
          mpi_log_error("Unable to allocate memory.");
-         MPI_Win_call_errhandler(win.win, MPI_ERR_PMEM_NO_MEM);
-         return MPI_ERR_PMEM_NO_MEM;
+         call_win_errhandler(win.win, MPI_ERR_PMEM_NO_MEM);
+         result = MPI_ERR_PMEM_NO_MEM;
       }
-      sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, win.name, next_checkpoint_version);
-      mpi_log_debug("Creating checkpoint in file '%s'.", file_name);
-      checkpoint_file = fopen(file_name, "wb");
-      if (checkpoint_file == NULL) {
-         mpi_log_error("Unable to open checkpoint file '%s'.", file_name);
-         MPI_Win_call_errhandler(win.win, MPI_ERR_PMEM);
-         return MPI_ERR_PMEM;
+   }
+   // Set checkpoint version flag to deleted in window's versions file if new checkpoint is overwriting the old one.
+   if (result == MPI_SUCCESS) {
+      sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, win.name, checkpoint->version);
+      if (!checkpoint->creating_new_version) {
+         result = release_overwritten_version(checkpoint, versions, file_name);
       }
-      sprintf(file_name, "%s/.%s", mpi_pmem_root_path, win.name);
-      versions_file_size = (highest_checkpoint_version + 2) * sizeof(MPI_Win_pmem_version);
-      result = open_pmem_file(win.comm, file_name, versions_file_size, (void**) &versions);
-      CHECK_ERROR_CODE(result);
+   }
+   // Node checkpoint file is written by all processes of node together, so process which failed to prepare aggregated checkpoint still takes part in
+   // writing it and whole node fails.
+   if (result != MPI_SUCCESS && !checkpoint->aggregated) {
+      free(file_name);
+      free(compressed_data);
+      free(chunks);
+      return result;
+   }
 
-      // Set checkpoint version flag to deleted in window's versions file if new checkpoint is overwriting the old one.
-      if (!creating_new_version) {
-         versions[next_checkpoint_version].flags = MPI_PMEM_FLAG_OBJECT_DELETED;
-         result = persist_pmem_file(win.comm, &versions[next_checkpoint_version].flags, sizeof(char));
-         CHECK_ERROR_CODE(result);
-      }
+   // Plain full checkpoint is written to free preallocated slot file, so no file is created or removed.
+   if (win.modifiable_values->slot_ring != NULL && !checkpoint->aggregated && !checkpoint->extents && !checkpoint->incremental && !checkpoint->delta && !checkpoint->chunked &&
+       compressed_data == NULL) {
+      checkpoint->slot = find_free_checkpoint_slot(win.modifiable_values->slot_ring, versions, checkpoint->highest_version + 1);
+   }
 
-      // Copy data to checkpoint file.
-      fwrite(win.modifiable_values->memory_areas->base, 1, win.modifiable_values->memory_areas->size, checkpoint_file);
-      fflush(checkpoint_file);
-      fsync(fileno(checkpoint_file));
-      fclose(checkpoint_file);
-      // Sync also directory containing checkpoints.
-      root_file_descriptor = open(mpi_pmem_root_path, O_RDWR);
-      fsync(root_file_descriptor);
-      close(root_file_descriptor);
-
-      // Update checkpoint version in window's versions metadata file.
-      if (creating_new_version) {
-         // Create new terminating record.
-         versions[highest_checkpoint_version + 1].version = 0;
-         versions[highest_checkpoint_version + 1].timestamp = 0;
-         versions[highest_checkpoint_version + 1].flags = MPI_PMEM_FLAG_NO_OBJECT;
-         result = persist_pmem_file(win.comm, &versions[highest_checkpoint_version], sizeof(MPI_Win_pmem_version));
+   // Copy data to checkpoint file (or to node checkpoint file shared by processes of the same node).
+   if (checkpoint->aggregated) {
+      // Overwritten version could have been saved in checkpoint file of this process.
+      if (result == MPI_SUCCESS && check_if_file_exist(file_name)) {
+         reclaim_file(mpi_pmem_root_path, file_name);
+      }
+      prepared_result = result;
+      result = write_aggregated_checkpoint(win.modifiable_values->aggregator, win.name, checkpoint->version, prepared_result == MPI_SUCCESS, checkpoint->data,
+                                           checkpoint->size, win.modifiable_values->copy_pool, &node_version);
+      if (prepared_result != MPI_SUCCESS || result != MPI_SUCCESS) {
+         free(file_name);
+         return prepared_result != MPI_SUCCESS ? prepared_result : result;
+      }
+   } else {
+      if (checkpoint->extents) {
+         checkpoint_file_size = extents_checkpoint_size(win.modifiable_values->memory_areas);
+      } else if (checkpoint->incremental) {
+         checkpoint_file_size = incremental_checkpoint_size(checkpoint->size, checkpoint->pages, checkpoint->pages_count);
+      } else if (checkpoint->delta) {
+         checkpoint_file_size = checkpoint->delta_size;
+      } else if (checkpoint->chunked) {
+         checkpoint_file_size = chunked_checkpoint_size(chunks_count);
+      } else if (compressed_data == NULL) {
+         checkpoint_file_size = checkpoint->size;
+      }
+      if (checkpoint->slot >= 0) {
+         // Overwritten version could have been saved in its own checkpoint file.
+         if (!checkpoint->creating_new_version && check_if_file_exist(file_name)) {
+            reclaim_file(mpi_pmem_root_path, file_name);
+         }
+         mpi_log_debug("Creating checkpoint in slot %d.", checkpoint->slot);
+         open_slot_writer(win.modifiable_values->slot_ring, checkpoint->slot, win.comm, win.modifiable_values->copy_pool, &writer);
+      } else {
+         mpi_log_debug("Creating checkpoint in file '%s'.", file_name);
+         result = open_checkpoint_writer(win.comm, file_name, checkpoint_file_size, win.modifiable_values->copy_pool, &writer);
          CHECK_ERROR_CODE(result);
       }
-      // Update checkpoint version metadata in window's versions metadata file.
-      versions[next_checkpoint_version].version = next_checkpoint_version;
-      versions[next_checkpoint_version].timestamp = time(NULL);
-      result = persist_pmem_file(win.comm, &versions[next_checkpoint_version], sizeof(MPI_Win_pmem_version));
+      // Checkpoint written in background shouldn't take I/O bandwidth needed by computation.
+      if (win.async_checkpoints && win.checkpoint_rate > 0) {
+         limit_checkpoint_writer_rate(&writer, win.checkpoint_rate * 1048576.0);
+      }
+      if (checkpoint->extents) {
+         result = write_extents_checkpoint(&writer, win.modifiable_values->memory_areas);
+      } else if (checkpoint->incremental) {
+         result = write_incremental_checkpoint(&writer, checkpoint->data, checkpoint->size, checkpoint->pages, checkpoint->pages_count, checkpoint->packed);
+      } else if (checkpoint->delta) {
+         result = write_checkpoint_data(&writer, checkpoint->delta_data, checkpoint->delta_size);
+      } else if (checkpoint->chunked) {
+         result = write_chunked_checkpoint(&writer, checkpoint->size, chunks, chunks_count);
+      } else if (compressed_data != NULL) {
+         result = write_checkpoint_data(&writer, compressed_data, checkpoint_file_size);
+      } else {
+         result = write_checkpoint_data(&writer, checkpoint->data, checkpoint->size);
+      }
+      free(compressed_data);
+      free(chunks);
+      if (result != MPI_SUCCESS) {
+         close_checkpoint_writer(&writer);
+         return result;
+      }
+      result = close_checkpoint_writer(&writer);
       CHECK_ERROR_CODE(result);
-      // Set flag indicating that new checkpoint version exists.
-      versions[next_checkpoint_version].flags = MPI_PMEM_FLAG_OBJECT_EXISTS;
-      result = persist_pmem_file(win.comm, &versions[next_checkpoint_version].flags, sizeof(char));
+   }
+
+   // Update checkpoint version metadata in window's versions metadata file. Record isn't valid until it is committed, so it is persisted together with
+   // new terminating record (which directly follows it).
+   versions[checkpoint->version].version = checkpoint->version;
+   versions[checkpoint->version].timestamp = time(NULL);
+   if (checkpoint->creating_new_version) {
+      versions[checkpoint->highest_version + 1].version = 0;
+      versions[checkpoint->highest_version + 1].timestamp = 0;
+      versions[checkpoint->highest_version + 1].flags = MPI_PMEM_FLAG_NO_OBJECT;
+      versions[checkpoint->highest_version + 1].format = MPI_PMEM_CHECKPOINT_FULL;
+      versions[checkpoint->highest_version + 1].codec = MPI_PMEM_CODEC_NONE;
+      versions[checkpoint->highest_version + 1].parent_version = -1;
+   }
+   result = persist_pmem_file(win.comm, &versions[checkpoint->version], (checkpoint->creating_new_version ? 2 : 1) * sizeof(MPI_Win_pmem_version));
+   CHECK_ERROR_CODE(result);
+   // Set flag indicating that new checkpoint version exists.
+   result = commit_version_record(win.comm, &versions[checkpoint->version], MPI_PMEM_FLAG_OBJECT_EXISTS,
+                                  checkpoint->extents ? MPI_PMEM_CHECKPOINT_EXTENTS : checkpoint->incremental ? MPI_PMEM_CHECKPOINT_INCREMENTAL :
+                                  checkpoint->delta ? MPI_PMEM_CHECKPOINT_DELTA : checkpoint->chunked ? MPI_PMEM_CHECKPOINT_CHUNKED : checkpoint->aggregated ? MPI_PMEM_CHECKPOINT_AGGREGATED :
+                                  checkpoint->slot >= 0 ? MPI_PMEM_CHECKPOINT_SLOT : MPI_PMEM_CHECKPOINT_FULL,
+                                  checkpoint->codec, checkpoint->incremental || checkpoint->delta ? checkpoint->last_version : checkpoint->aggregated ? node_version :
+                                  checkpoint->slot >= 0 ? checkpoint->slot : -1);
+   CHECK_ERROR_CODE(result);
+   free(file_name);
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Commit checkpoint globally: after every process made its checkpoint durable, single reduction checks that all of them succeeded and each process saves
+ * checkpoint version in its global epoch record. Restart reads this record instead of searching for version existing in all processes.
+ *
+ * @param checkpoint Written checkpoint.
+ * @param committed  Output variable specifying whether checkpoint was committed by all processes.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int commit_global_checkpoint(MPI_Win_pmem_checkpoint *checkpoint, bool *committed) {
+   int result;
+   char written, written_by_all_processes;
+   MPI_Win_pmem_epoch *epoch;
+   MPI_Win_pmem win = checkpoint->win;
+
+   written = checkpoint->result == MPI_SUCCESS ? 1 : 0;
+   result = MPI_Allreduce(&written, &written_by_all_processes, 1, MPI_CHAR, MPI_MIN, win.comm);
+   CHECK_ERROR_CODE(result);
+   *committed = written_by_all_processes == 1;
+   if (!*committed) {
+      mpi_log_debug("Checkpoint version %d wasn't written by all processes.", checkpoint->version);
+      return MPI_SUCCESS;
+   }
+
+   result = open_window_epoch(win, &epoch);
+   CHECK_ERROR_CODE(result);
+   result = store_global_epoch(win.comm, epoch, checkpoint->version, epoch->epoch + 1);
+   CHECK_ERROR_CODE(result);
+   win.modifiable_values->global_checkpoint_version = checkpoint->version;
+   mpi_log_debug("Checkpoint version %d committed globally in epoch %d.", checkpoint->version, epoch->epoch);
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Remember digests of pages and data saved in written checkpoint, so next checkpoint can be based on it.
+ *
+ * @param checkpoint Written checkpoint.
+ */
+static void update_checkpoint_references(MPI_Win_pmem_checkpoint *checkpoint) {
+   MPI_Win_pmem win = checkpoint->win;
+
+   if (checkpoint->result == MPI_SUCCESS && win.incremental_checkpoints) {
+      free(win.modifiable_values->page_digests);
+      win.modifiable_values->page_digests = checkpoint->page_digests;
+      win.modifiable_values->page_digests_valid = true;
+      win.modifiable_values->checkpoint_chain_length = checkpoint->incremental ? win.modifiable_values->checkpoint_chain_length + 1 : 0;
+   } else {
+      free(checkpoint->page_digests);
+   }
+   // Data saved in checkpoint becomes reference for next delta, it is unknown if checkpoint failed.
+   if (win.delta_checkpoints && checkpoint->data != NULL) {
+      if (checkpoint->result == MPI_SUCCESS && win.modifiable_values->delta_reference == NULL) {
+         win.modifiable_values->delta_reference = malloc(checkpoint->size);
+      }
+      if (checkpoint->result != MPI_SUCCESS || win.modifiable_values->delta_reference == NULL) {
+         free(win.modifiable_values->delta_reference);
+         win.modifiable_values->delta_reference = NULL;
+      } else if (checkpoint->delta) {
+         apply_delta(win.modifiable_values->delta_reference, checkpoint->delta_data);
+      } else {
+         parallel_memcpy(win.modifiable_values->copy_pool, win.modifiable_values->delta_reference, checkpoint->data, checkpoint->size);
+      }
+      win.modifiable_values->checkpoint_chain_length = checkpoint->result == MPI_SUCCESS && checkpoint->delta ? win.modifiable_values->checkpoint_chain_length + 1 : 0;
+   }
+}
+
+/**
+ * Complete checkpoint whose references were already updated: commit it globally and delete previous checkpoint versions if not specified not to do so.
+ * Checkpoint object is freed.
+ *
+ * @param checkpoint Written checkpoint.
+ * @param barrier    Flag specifying whether all processes should be synchronized before deleting old checkpoint versions.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int complete_checkpoint(MPI_Win_pmem_checkpoint *checkpoint, bool barrier) {
+   int result = MPI_SUCCESS;
+   int previous_global_version;
+   bool global_commit, committed = false;
+   MPI_Win_pmem_version *versions;
+   MPI_Win_pmem win = checkpoint->win;
+
+   // Checkpoint created in MPI_Win_fence of globally consistent window is committed by all processes together.
+   global_commit = barrier && checkpoint->fence && win.global_checkpoint;
+   previous_global_version = win.modifiable_values->global_checkpoint_version;
+   if (global_commit) {
+      result = commit_global_checkpoint(checkpoint, &committed);
       CHECK_ERROR_CODE(result);
+   }
 
-      // Delete last checkpoint if not specified not to do so.
-      if (!win.modifiable_values->keep_all_checkpoints) {
-         if (fence) {
-            MPI_Barrier(win.comm);
-         }
-         if (last_checkpoint_version != -1) {
-            // Set flag indicating that checkpoint version is deleted.
-            versions[last_checkpoint_version].flags = MPI_PMEM_FLAG_OBJECT_DELETED;
-            result = persist_pmem_file(win.comm, &versions[last_checkpoint_version].flags, sizeof(char));
+   // Delete last checkpoint if not specified not to do so. Incremental and delta checkpoints need previous versions, so they are deleted only after next full checkpoint.
+   // Checkpoint of globally consistent window replaces previous versions only after all processes stored its global epoch, so process which crashed
+   // before storing it can still restore previous version.
+   if (!win.modifiable_values->keep_all_checkpoints) {
+      if (barrier) {
+         MPI_Barrier(win.comm);
+      }
+      if (checkpoint->result == MPI_SUCCESS && checkpoint->last_version != -1 && !checkpoint->incremental && !checkpoint->delta && (!global_commit || committed)) {
+         result = open_window_versions(win, &versions);
+         CHECK_ERROR_CODE(result);
+         result = delete_checkpoint_chain(win, versions, checkpoint->highest_version + 1, checkpoint->last_version);
+         CHECK_ERROR_CODE(result);
+         // Previously committed version could have been kept while checkpoints outside of MPI_Win_fence were created.
+         if (committed && previous_global_version != -1 && previous_global_version != checkpoint->last_version) {
+            result = delete_checkpoint_chain(win, versions, checkpoint->highest_version + 1, previous_global_version);
             CHECK_ERROR_CODE(result);
-            // Delete checkpoint data file.
-            sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, win.name, last_checkpoint_version);
-            if (remove(file_name) != 0) {
-               mpi_log_error("Unable to delete file '%s'.", file_name);
-               MPI_Win_call_errhandler(win.win, MPI_ERR_PMEM);
-               return MPI_ERR_PMEM;
-            }
          }
       }
-      result = unmap_pmem_file(win.comm, versions, versions_file_size);
+      // Queued checkpoint could have been replaced by checkpoints created outside of MPI_Win_fence, which kept it until now.
+      if (barrier && checkpoint->version != win.modifiable_values->last_checkpoint_version && !committed) {
+         result = open_window_versions(win, &versions);
+         CHECK_ERROR_CODE(result);
+         result = delete_checkpoint_chain(win, versions, win.modifiable_values->highest_checkpoint_version + 1, checkpoint->version);
+         CHECK_ERROR_CODE(result);
+      }
+   }
+
+   if (checkpoint->result != MPI_SUCCESS && !checkpoint->result_reported) {
+      result = checkpoint->result;
+   }
+   free(checkpoint->pages);
+   free(checkpoint->delta_data);
+   free(checkpoint);
+
+   return result;
+}
+
+/**
+ * Finish written checkpoint: remember digests of saved pages and delete previous checkpoint versions if not specified not to do so. Checkpoint object is freed.
+ *
+ * @param checkpoint Written checkpoint.
+ * @param barrier    Flag specifying whether all processes should be synchronized before deleting old checkpoint versions.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int finish_checkpoint(MPI_Win_pmem_checkpoint *checkpoint, bool barrier) {
+   update_checkpoint_references(checkpoint);
+
+   return complete_checkpoint(checkpoint, barrier);
+}
+
+/**
+ * Write checkpoint after processes on the same socket, which are before this process in the queue, finished writing theirs. Only checkpoints created by all
+ * processes in MPI_Win_fence_pmem_persist are throttled. Function may be called from background thread.
+ *
+ * @param checkpoint Checkpoint to write.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int write_checkpoint_throttled(MPI_Win_pmem_checkpoint *checkpoint) {
+   int result, token_result;
+   MPI_Win_pmem_throttle *throttle = checkpoint->win.modifiable_values->throttle;
+
+   // Aggregated checkpoint synchronizes processes of node, so they can't wait for each other's tokens.
+   if (throttle == NULL || !checkpoint->fence || checkpoint->aggregated) {
+      return write_checkpoint(checkpoint);
+   }
+
+   // Token is passed even if it wasn't received or checkpoint failed, otherwise following processes would wait forever.
+   result = acquire_write_token(throttle);
+   if (result == MPI_SUCCESS) {
+      result = write_checkpoint(checkpoint);
+   }
+   token_result = release_write_token(throttle);
+
+   return result != MPI_SUCCESS ? result : token_result;
+}
+
+/**
+ * Body of background thread writing checkpoint.
+ *
+ * @param argument Checkpoint to write.
+ *
+ * @returns NULL.
+ */
+static void *write_checkpoint_in_background(void *argument) {
+   MPI_Win_pmem_checkpoint *checkpoint = argument;
+
+   // Error handlers of application may not be thread safe, so error is reported by thread which joins this one.
+   defer_errhandlers(true);
+   checkpoint->result = write_checkpoint_throttled(checkpoint);
+
+   return NULL;
+}
+
+/**
+ * Take snapshot of window data and start writing checkpoint in background thread.
+ *
+ * @param checkpoint Prepared checkpoint.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int start_checkpoint_in_background(MPI_Win_pmem_checkpoint *checkpoint) {
+   MPI_Win_pmem win = checkpoint->win;
+
+   // Computation may modify window as soon as this function returns, so checkpoint is written from a copy of data (only modified pages for incremental checkpoint).
+   // Encoded delta already is a copy of changed data.
+   if (!checkpoint->delta) {
+      if (win.modifiable_values->checkpoint_staging_buffer == NULL) {
+         win.modifiable_values->checkpoint_staging_buffer = malloc(checkpoint->size);
+         if (win.modifiable_values->checkpoint_staging_buffer == NULL) {
+            mpi_log_error("Unable to allocate memory.");
+            call_win_errhandler(win.win, MPI_ERR_PMEM_NO_MEM);
+            return MPI_ERR_PMEM_NO_MEM;
+         }
+      }
+      if (checkpoint->incremental) {
+         pack_modified_pages(win.modifiable_values->checkpoint_staging_buffer, checkpoint->data, checkpoint->size, checkpoint->pages, checkpoint->pages_count);
+         checkpoint->packed = true;
+      } else {
+         parallel_memcpy(win.modifiable_values->copy_pool, win.modifiable_values->checkpoint_staging_buffer, checkpoint->data, checkpoint->size);
+      }
+      checkpoint->data = win.modifiable_values->checkpoint_staging_buffer;
+   }
+
+   win.modifiable_values->pending_checkpoint = checkpoint;
+   if (pthread_create(&checkpoint->thread, NULL, write_checkpoint_in_background, checkpoint) != 0) {
+      mpi_log_debug("Unable to create checkpoint thread, writing checkpoint synchronously.");
+      checkpoint->result = write_checkpoint_throttled(checkpoint);
+   } else {
+      checkpoint->thread_started = true;
+   }
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Wait for background thread writing checkpoint (if it is running) and call error handler of window if writing checkpoint failed.
+ *
+ * @param checkpoint Pending checkpoint.
+ */
+static void join_checkpoint_thread(MPI_Win_pmem_checkpoint *checkpoint) {
+   if (checkpoint->thread_started) {
+      pthread_join(checkpoint->thread, NULL);
+      checkpoint->thread_started = false;
+      if (checkpoint->result != MPI_SUCCESS) {
+         call_win_errhandler(checkpoint->win.win, checkpoint->result);
+      }
+   }
+}
+
+int wait_for_pending_checkpoint(MPI_Win_pmem win) {
+   MPI_Win_pmem_checkpoint *checkpoint = win.modifiable_values->pending_checkpoint;
+
+   if (checkpoint == NULL) {
+      return MPI_SUCCESS;
+   }
+   join_checkpoint_thread(checkpoint);
+   // Deleting old versions of checkpoint created in MPI_Win_fence requires synchronization of all processes.
+   if (!checkpoint->fence) {
+      return complete_pending_checkpoint(win, false);
+   }
+   checkpoint->result_reported = true;
+
+   return checkpoint->result;
+}
+
+/**
+ * Wait for pending checkpoint created in MPI_Win_fence and queue its completion until next collective call. Next checkpoint can be based on it right away.
+ *
+ * @param win Window object.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int queue_pending_checkpoint(MPI_Win_pmem win) {
+   MPI_Win_pmem_checkpoint *checkpoint = win.modifiable_values->pending_checkpoint;
+
+   join_checkpoint_thread(checkpoint);
+   update_checkpoint_references(checkpoint);
+   win.modifiable_values->pending_checkpoint = NULL;
+   win.modifiable_values->queued_checkpoint = checkpoint;
+   if (checkpoint->result != MPI_SUCCESS && !checkpoint->result_reported) {
+      checkpoint->result_reported = true;
+      return checkpoint->result;
+   }
+
+   return MPI_SUCCESS;
+}
+
+int complete_pending_checkpoint(MPI_Win_pmem win, bool barrier) {
+   int result = MPI_SUCCESS, queued_result = MPI_SUCCESS;
+   MPI_Win_pmem_checkpoint *checkpoint = win.modifiable_values->pending_checkpoint;
+   MPI_Win_pmem_checkpoint *queued = win.modifiable_values->queued_checkpoint;
+
+   // Queued checkpoint is older than pending one. Only checkpoints created in MPI_Win_fence synchronize processes, so every process makes the same collective calls.
+   if (barrier && queued != NULL) {
+      win.modifiable_values->queued_checkpoint = NULL;
+      queued_result = complete_checkpoint(queued, true);
+   }
+   if (checkpoint != NULL) {
+      join_checkpoint_thread(checkpoint);
+      win.modifiable_values->pending_checkpoint = NULL;
+      result = finish_checkpoint(checkpoint, barrier && checkpoint->fence);
+   }
+
+   return queued_result != MPI_SUCCESS ? queued_result : result;
+}
+
+int create_checkpoint(MPI_Win_pmem win, bool fence) {
+   int result;
+   MPI_Win_pmem_checkpoint *checkpoint = NULL, *pending;
+
+   if (win.is_pmem && !win.is_volatile && win.modifiable_values->transactional) {
+      // Only one checkpoint can be written in background, so previous one has to be completed first. Checkpoint created in MPI_Win_fence is committed by all
+      // processes together, so call which isn't collective (e.g. MPI_Win_wait_pmem_persist) only waits for it and queues its completion.
+      pending = win.modifiable_values->pending_checkpoint;
+      if (!fence && pending != NULL && pending->fence) {
+         result = queue_pending_checkpoint(win);
+      } else {
+         result = complete_pending_checkpoint(win, fence);
+      }
       CHECK_ERROR_CODE(result);
-      free(file_name);
+
+      result = prepare_checkpoint(win, fence, &checkpoint);
+      CHECK_ERROR_CODE(result);
+      // Memory areas attached from now on belong to new checkpoint version.
+      win.modifiable_values->restore_on_attach = false;
+      if (win.async_checkpoints) {
+         result = start_checkpoint_in_background(checkpoint);
+         CHECK_ERROR_CODE(result);
+      } else {
+         checkpoint->result = write_checkpoint_throttled(checkpoint);
+         result = finish_checkpoint(checkpoint, fence);
+         CHECK_ERROR_CODE(result);
+      }
    }
 
    return MPI_SUCCESS;
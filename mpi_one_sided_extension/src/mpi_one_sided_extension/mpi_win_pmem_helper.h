@@ -30,6 +30,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define __MPI_WIN_PMEM_HELPER_H__
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
 #include <sys/stat.h>
 #include <mpi.h>
 #include "mpi_win_pmem.h"
@@ -38,6 +40,37 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 extern "C" {
 #endif
 
+#define MPI_PMEM_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Description of single checkpoint passed between its preparation, writing and completion.
+struct MPI_Win_pmem_checkpoint_structure {
+   MPI_Win_pmem win;
+   bool fence;                   // Checkpoint was created in MPI_Win_fence.
+   int version;                  // Version of this checkpoint.
+   int last_version;             // Version of previous checkpoint (-1 if there is none).
+   int highest_version;          // Highest checkpoint version including this checkpoint.
+   bool creating_new_version;    // Checkpoint is appended to window's versions metadata file instead of overwriting existing version.
+   bool incremental;
+   bool delta;                   // Checkpoint contains XOR of window data and previous version.
+   bool extents;                 // Checkpoint contains all memory areas attached to dynamic window.
+   bool chunked;                 // Checkpoint data is stored in chunk store.
+   bool aggregated;              // Checkpoint data is written to node checkpoint file shared by processes of the same node.
+   int slot;                     // Preallocated slot file containing checkpoint data (-1 if checkpoint has its own file).
+   const void *data;             // Window data or its snapshot.
+   MPI_Aint size;                // Size of window.
+   bool packed;                  // Data contains only modified pages stored one after another.
+   char codec;                   // Codec used to compress checkpoint (MPI_PMEM_CODEC_NONE if data isn't compressible).
+   uint64_t *pages;              // Indices of modified pages (incremental checkpoint only).
+   uint64_t pages_count;
+   void *delta_data;             // Encoded delta (delta checkpoint only).
+   MPI_Aint delta_size;
+   uint64_t *page_digests;       // Digests of window pages saved in this checkpoint.
+   pthread_t thread;
+   bool thread_started;
+   int result;                   // Result of writing checkpoint.
+   bool result_reported;
+};
+
 /**
  * Open file in pmem and map it into memory. Save address of mapped memory into address. Use unmap_pmem_file to free memory region mapped by this function.
  *
@@ -50,6 +83,20 @@ extern "C" {
  */
 int open_pmem_file(MPI_Comm comm, const char *file_name, MPI_Aint size, void **address);
 
+/**
+ * Open data file of window in pmem and map it at address aligned to huge page size, so huge DAX pages can be used for windows of at least that size. Unlike
+ * open_pmem_file, only size bytes of file are mapped. Use unmap_pmem_file to free memory region mapped by this function.
+ *
+ * @param comm       Communicator used for error handling.
+ * @param file_name  File name to open.
+ * @param size       Size of the file to open.
+ * @param map_sync   Flag specifying whether synchronous page faults (MAP_SYNC) should be requested. If file system doesn't support them, file is mapped without.
+ * @param address    Output variable for memory address of mapped file.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int map_window_file(MPI_Comm comm, const char *file_name, MPI_Aint size, bool map_sync, void **address);
+
 /**
  * Force any changes to be stored durably in persistent memory (call either pmem_persist or pmem_msync depending whether specified memory area consists of persistent memory.
  *
@@ -114,9 +161,84 @@ int open_windows_metadata_file(MPI_Comm comm, MPI_Win_pmem_metadata **windows, o
  */
 int open_versions_metadata_file(MPI_Comm comm, const char *window_name, MPI_Win_pmem_version **versions, off_t *size);
 
+/**
+ * Get window's versions metadata file. File is mapped on first use and stays mapped until close_window_versions is called.
+ *
+ * @param win       Window object.
+ * @param versions  Output variable for address of memory mapped area of window's versions metadata file.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int open_window_versions(MPI_Win_pmem win, MPI_Win_pmem_version **versions);
+
+/**
+ * Make sure that window's versions metadata file can hold specified number of records. File is enlarged at least twice, so it is remapped only
+ * logarithmic number of times.
+ *
+ * @param win       Window object.
+ * @param count     Required number of records (including terminating record).
+ * @param versions  Output variable for address of memory mapped area of window's versions metadata file (previous address is invalid if file was enlarged).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int reserve_window_versions(MPI_Win_pmem win, int count, MPI_Win_pmem_version **versions);
+
+/**
+ * Unmap window's versions metadata file mapped by open_window_versions and global epoch metadata file mapped by open_window_epoch.
+ *
+ * @param win  Window object.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int close_window_versions(MPI_Win_pmem win);
+
+/**
+ * Get window's global epoch metadata file. File is created and mapped on first use and stays mapped until close_window_versions is called.
+ *
+ * @param win    Window object.
+ * @param epoch  Output variable for address of memory mapped global epoch record.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int open_window_epoch(MPI_Win_pmem win, MPI_Win_pmem_epoch **epoch);
+
+/**
+ * Write global epoch record with single 8-byte store and persist it.
+ *
+ * @param comm     Communicator used for error handling.
+ * @param record   Global epoch record.
+ * @param version  New globally consistent checkpoint version (-1 to invalidate record).
+ * @param epoch    New number of global commits.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int store_global_epoch(MPI_Comm comm, MPI_Win_pmem_epoch *record, int version, int epoch);
+
+/**
+ * Read globally consistent checkpoint version from window's global epoch metadata file.
+ *
+ * @param comm         Communicator used for error handling.
+ * @param window_name  Name of window.
+ * @param version      Output variable for checkpoint version (-1 if no version was committed globally or record was invalidated).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int read_global_checkpoint_version(MPI_Comm comm, const char *window_name, int *version);
+
+/**
+ * Invalidate window's global epoch record if it points to specified checkpoint version, which is going to be deleted.
+ *
+ * @param comm         Communicator used for error handling.
+ * @param window_name  Name of window.
+ * @param version      Deleted checkpoint version.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int invalidate_global_checkpoint_version(MPI_Comm comm, const char *window_name, int version);
+
 /**
  * Delete all checkpoints (set flag in metadata file and remove data file) created previously for window with specified name and set first (at index 0) record in metadata file to terminating record
- * indicating end of versions metadata file.
+ * indicating end of versions metadata file. Window's global epoch metadata file is removed.
  *
  * @param comm       Communicator used for error handling.
  * @param name       Name of window.
@@ -180,6 +302,65 @@ int parse_mpi_info_mode(MPI_Comm comm, MPI_Info info, int *result);
  */
 int parse_mpi_info_checkpoint_version(MPI_Comm comm, MPI_Info info, int *result);
 
+/**
+ * Parse MPI_Info parameter of type int with specified key.
+ *
+ * @param comm          Communicator used for error handling.
+ * @param info          MPI_Info object to parse.
+ * @param key           Key of MPI_Info parameter.
+ * @param default_value Value returned if parameter is not set.
+ * @param result        Output variable for parsed value.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int parse_mpi_info_int(MPI_Comm comm, MPI_Info info, const char *key, int default_value, int *result);
+
+/**
+ * Parse MPI_Info parameter with key "pmem_checkpoint_threads".
+ *
+ * @param comm     Communicator used for error handling.
+ * @param info     MPI_Info object to parse.
+ * @param threads  Output variable for number of threads copying checkpoint data.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int parse_mpi_info_checkpoint_threads(MPI_Comm comm, MPI_Info info, int *threads);
+
+/**
+ * Parse MPI_Info parameter with key "pmem_checkpoint_codec".
+ *
+ * @param comm   Communicator used for error handling.
+ * @param info   MPI_Info object to parse.
+ * @param codec  Output variable for identifier of codec.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int parse_mpi_info_checkpoint_codec(MPI_Comm comm, MPI_Info info, char *codec);
+
+/**
+ * Parse MPI_Info parameters with keys "pmem_checkpoint_mtbf" and "pmem_checkpoint_overhead" used to schedule checkpoints.
+ *
+ * @param comm      Communicator used for error handling.
+ * @param info      MPI_Info object to parse.
+ * @param mtbf      Output variable for mean time between failures in seconds (0 if checkpoints aren't scheduled).
+ * @param overhead  Output variable for maximum percentage of run time spent on checkpoints (0 if not limited).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int parse_mpi_info_checkpoint_schedule(MPI_Comm comm, MPI_Info info, int *mtbf, int *overhead);
+
+/**
+ * Parse MPI_Info parameters with keys "pmem_checkpoint_writers" and "pmem_checkpoint_rate" used to limit checkpoint I/O.
+ *
+ * @param comm     Communicator used for error handling.
+ * @param info     MPI_Info object to parse.
+ * @param writers  Output variable for maximum number of processes of the same socket writing checkpoints concurrently (0 if not limited).
+ * @param rate     Output variable for maximum rate of writing checkpoints in background in MB/s (0 if not limited).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int parse_mpi_info_checkpoint_throttle(MPI_Comm comm, MPI_Info info, int *writers, int *rate);
+
 /**
  * Check if specified window was created previously. If window mode is set to checkpoint also check it's size.
  *
@@ -214,6 +395,16 @@ int create_window_metadata_file(MPI_Comm comm, const char *file_name, MPI_Win_pm
  */
 int update_window_size_in_metadata_file(MPI_Win_pmem *win, MPI_Aint size);
 
+/**
+ * Save in global metadata file whether window's data file is striped and root path of process which created it. Parts of data file created by previous run
+ * with different layout are deleted.
+ *
+ * @param win  Window to be updated in global metadata file.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int update_window_stripes_in_metadata_file(MPI_Win_pmem *win);
+
 /**
  * Set checkpoint versions (last, next, highest) in MPI_Win_pmem object depending on window parameters and information in window's versions metadata file.
  *
@@ -225,7 +416,28 @@ int update_window_size_in_metadata_file(MPI_Win_pmem *win, MPI_Aint size);
 int set_checkpoint_versions(MPI_Win_pmem *win, MPI_Win_pmem_version *versions);
 
 /**
- * Copy data from previously created checkpoint (specified by last_checkpoint_version) into destination area.
+ * Check if window exists in global metadata file, create window's versions metadata file if needed and set checkpoint versions in window object.
+ * All previous checkpoints are deleted if window is opened in expand mode.
+ *
+ * @param win  Window object with parsed name and mode.
+ * @param size Size of the window (0 for dynamic windows).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int load_window_metadata(MPI_Win_pmem *win, MPI_Aint size);
+
+/**
+ * Copy contents of memory area attached to dynamic window from last checkpoint (specified by last_checkpoint_version).
+ *
+ * @param win           Window object containing metadata about checkpoint to use.
+ * @param memory_area   Attached memory area.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int restore_memory_area(MPI_Win_pmem win, MPI_Win_memory_areas_list *memory_area);
+
+/**
+ * Copy data from previously created checkpoint (specified by last_checkpoint_version) into destination area. Incremental checkpoints are rebuilt from last full checkpoint they are based on.
  *
  * @param win           Window object containing metadata about checkpoint to use.
  * @param size          Size of checkpoint in bytes.
@@ -234,7 +446,22 @@ int set_checkpoint_versions(MPI_Win_pmem *win, MPI_Win_pmem_version *versions);
 int copy_data_from_checkpoint(MPI_Win_pmem win, MPI_Aint size, void *destination);
 
 /**
- * Create new checkpoint version of provided window.
+ * Use previously created checkpoint (specified by last_checkpoint_version) as window memory without copying it. Checkpoint file is cloned into window's
+ * data file if file system supports reflinks, otherwise it is mapped privately (pages are copied on first write). Only uncompressed full checkpoints can be used
+ * this way.
+ *
+ * @param win      Window object containing metadata about checkpoint to use.
+ * @param size     Size of checkpoint in bytes.
+ * @param address  Output variable for address of window memory. Use unmap_pmem_file to free it.
+ * @param mapped   Output variable set to false if checkpoint can't be mapped and has to be copied with copy_data_from_checkpoint.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int map_checkpoint_as_window(MPI_Win_pmem win, MPI_Aint size, void **address, bool *mapped);
+
+/**
+ * Create new checkpoint version of provided window. If window uses asynchronous checkpoints, function only takes snapshot of window data and checkpoint is written in background.
+ * Previous asynchronous checkpoint is completed before new one is started.
  *
  * @param win     Window object.
  * @param fence   Flag specifying whether function is called from MPI_Win_fence.
@@ -243,6 +470,27 @@ int copy_data_from_checkpoint(MPI_Win_pmem win, MPI_Aint size, void *destination
  */
 int create_checkpoint(MPI_Win_pmem win, bool fence);
 
+/**
+ * Wait until checkpoint written in background is stored durably. Previous checkpoint versions are deleted immediately only if checkpoint wasn't created in MPI_Win_fence,
+ * otherwise they are deleted during next collective call (next checkpoint or MPI_Win_free_pmem).
+ *
+ * @param win  Window object.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int wait_for_pending_checkpoint(MPI_Win_pmem win);
+
+/**
+ * Wait for checkpoint written in background and delete checkpoint versions which are no longer needed. Checkpoint created in MPI_Win_fence, whose completion
+ * was queued by call which isn't collective, is completed too if processes are synchronized.
+ *
+ * @param win     Window object.
+ * @param barrier Flag specifying whether all processes should be synchronized before deleting old checkpoint versions of checkpoints created in MPI_Win_fence.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int complete_pending_checkpoint(MPI_Win_pmem win, bool barrier);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,429 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_incremental.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem_helper.h"
+#include "mpi_win_pmem_parallel.h"
+#include "mpi_win_pmem_codec.h"
+#include "mpi_win_pmem_chunks.h"
+#include "mpi_win_pmem_aggregate.h"
+#include "mpi_win_pmem_delta.h"
+#include "mpi_win_pmem_slots.h"
+#include "mpi_win_pmem_reclaim.h"
+
+static inline uint64_t rotate_left(uint64_t value, int bits) {
+   return (value << bits) | (value >> (64 - bits));
+}
+
+/**
+ * Check whether checkpoint format stores only changes made since its parent version.
+ *
+ * @param format  Checkpoint format.
+ *
+ * @returns True for incremental and delta checkpoints, false otherwise.
+ */
+static inline bool is_chained_format(char format) {
+   return format == MPI_PMEM_CHECKPOINT_INCREMENTAL || format == MPI_PMEM_CHECKPOINT_DELTA;
+}
+
+/**
+ * Calculate 64-bit digest of memory area. Four independent lanes are used so that consecutive multiplications don't depend on each other.
+ *
+ * @param data Starting address of memory area.
+ * @param size Size of memory area.
+ *
+ * @returns Digest of memory area.
+ */
+static uint64_t calculate_digest(const unsigned char *data, size_t size) {
+   const uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+   const uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+   uint64_t lanes[4] = { prime1 + prime2, prime2, 0, -prime1 };
+   uint64_t word, digest;
+   size_t i, j;
+
+   for (i = 0; i + 4 * sizeof(uint64_t) <= size; i += 4 * sizeof(uint64_t)) {
+      for (j = 0; j < 4; j++) {
+         memcpy(&word, data + i + j * sizeof(uint64_t), sizeof(uint64_t));
+         lanes[j] = rotate_left(lanes[j] + word * prime2, 31) * prime1;
+      }
+   }
+   // Remaining bytes are present only in last page of window which size is not a multiple of page size.
+   for (; i < size; i += sizeof(uint64_t)) {
+      word = 0;
+      memcpy(&word, data + i, size - i < sizeof(uint64_t) ? size - i : sizeof(uint64_t));
+      lanes[0] = rotate_left(lanes[0] ^ (word * prime2), 27) * prime1;
+   }
+
+   digest = rotate_left(lanes[0], 1) + rotate_left(lanes[1], 7) + rotate_left(lanes[2], 12) + rotate_left(lanes[3], 18) + size;
+   digest ^= digest >> 33;
+   digest *= prime2;
+   digest ^= digest >> 29;
+
+   return digest;
+}
+
+/**
+ * Create name of checkpoint file of specified window version.
+ *
+ * @param comm       Communicator used for error handling.
+ * @param name       Window's name.
+ * @param version    Checkpoint version.
+ * @param file_name  Output variable for file name. Must be freed by the caller.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int get_checkpoint_file_name(MPI_Comm comm, const char *name, int version, char **file_name) {
+   // Additional 14 characters for: "/.", "-", 10 characters for checkpoint number (length of maximum 4 byte integer number written in decimal form is 10 characters) and terminating zero.
+   *file_name = malloc((strlen(mpi_pmem_root_path) + strlen(name) + 14) * sizeof(char));
+   if (*file_name == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   sprintf(*file_name, "%s/.%s-%d", mpi_pmem_root_path, name, version);
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Mark checkpoint version as deleted in window's versions metadata file and remove its data file.
+ *
+ * @param win        Window object.
+ * @param versions   Memory address of mapped window's versions metadata file.
+ * @param version    Checkpoint version to delete.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int delete_checkpoint(MPI_Win_pmem win, MPI_Win_pmem_version *versions, int version) {
+   int result;
+   char *file_name;
+
+   // Set flag indicating that checkpoint version is deleted.
+   versions[version].flags = MPI_PMEM_FLAG_OBJECT_DELETED;
+   result = persist_pmem_file(win.comm, &versions[version].flags, sizeof(char));
+   CHECK_ERROR_CODE(result);
+   // Node checkpoint file of aggregated checkpoint is deleted by the last process of node which refers to it.
+   if (versions[version].format == MPI_PMEM_CHECKPOINT_AGGREGATED) {
+      remove_aggregated_checkpoint(win.name, versions[version].parent_version);
+      mpi_log_debug("Checkpoint version %d of window '%s' deleted.", version, win.name);
+      return MPI_SUCCESS;
+   }
+   // Slot file is reused by next checkpoints.
+   if (versions[version].format == MPI_PMEM_CHECKPOINT_SLOT) {
+      mpi_log_debug("Checkpoint version %d of window '%s' deleted, slot %d released.", version, win.name, versions[version].parent_version);
+      return MPI_SUCCESS;
+   }
+   // Delete checkpoint data file.
+   result = get_checkpoint_file_name(win.comm, win.name, version, &file_name);
+   CHECK_ERROR_CODE(result);
+   result = release_checkpoint_chunks(win.comm, file_name, versions[version].format);
+   CHECK_ERROR_CODE(result);
+   if (!reclaim_file(mpi_pmem_root_path, file_name)) {
+      mpi_log_error("Unable to delete file '%s'.", file_name);
+      free(file_name);
+      call_win_errhandler(win.win, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   mpi_log_debug("Checkpoint version %d of window '%s' deleted.", version, win.name);
+   free(file_name);
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Apply pages saved in incremental checkpoint file on top of destination memory area.
+ *
+ * @param comm          Communicator used for error handling.
+ * @param file_name     Name of incremental checkpoint file.
+ * @param size          Size of window in bytes.
+ * @param destination   Destination memory area containing previous checkpoint version.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int apply_incremental_checkpoint(MPI_Comm comm, const char *file_name, MPI_Aint size, void *destination) {
+   int result;
+   off_t file_size;
+   void *checkpoint_data;
+   MPI_Win_pmem_incremental_header *header;
+   uint64_t *pages;
+   unsigned char *page_data;
+   uint64_t i, data_size, offset, page_size;
+   bool valid;
+
+   result = get_file_size(comm, file_name, &file_size);
+   CHECK_ERROR_CODE(result);
+   if (file_size < (off_t) sizeof(MPI_Win_pmem_incremental_header)) {
+      mpi_log_error("Incremental checkpoint file '%s' is corrupted.", file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   result = open_pmem_file(comm, file_name, file_size, &checkpoint_data);
+   CHECK_ERROR_CODE(result);
+
+   // Validate header and page map before modifying destination.
+   header = checkpoint_data;
+   pages = (uint64_t*) (header + 1);
+   valid = header->magic == MPI_PMEM_INCREMENTAL_CHECKPOINT_MAGIC && header->window_size == (uint64_t) size && header->page_size == MPI_PMEM_CHECKPOINT_PAGE_SIZE &&
+           header->pages_count <= ((uint64_t) size + MPI_PMEM_CHECKPOINT_PAGE_SIZE - 1) / MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+   data_size = 0;
+   for (i = 0; valid && i < header->pages_count; i++) {
+      offset = pages[i] * MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+      valid = offset < (uint64_t) size && (i == 0 || pages[i] > pages[i - 1]);
+      data_size += offset + MPI_PMEM_CHECKPOINT_PAGE_SIZE > (uint64_t) size ? size - offset : MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+   }
+   if (!valid || (uint64_t) file_size != sizeof(MPI_Win_pmem_incremental_header) + header->pages_count * sizeof(uint64_t) + data_size) {
+      mpi_log_error("Incremental checkpoint file '%s' is corrupted.", file_name);
+      unmap_pmem_file(comm, checkpoint_data, file_size);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   // Copy saved pages.
+   page_data = (unsigned char*) (pages + header->pages_count);
+   for (i = 0; i < header->pages_count; i++) {
+      offset = pages[i] * MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+      page_size = offset + MPI_PMEM_CHECKPOINT_PAGE_SIZE > (uint64_t) size ? size - offset : MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+      memcpy((unsigned char*) destination + offset, page_data, page_size);
+      page_data += page_size;
+   }
+   mpi_log_debug("Applied %lu pages from incremental checkpoint file '%s'.", (unsigned long) header->pages_count, file_name);
+
+   result = unmap_pmem_file(comm, checkpoint_data, file_size);
+   CHECK_ERROR_CODE(result);
+
+   return MPI_SUCCESS;
+}
+
+int find_modified_pages(MPI_Comm comm, const void *base, MPI_Aint size, const uint64_t *old_digests, uint64_t *new_digests, uint64_t **pages, uint64_t *pages_count) {
+   uint64_t i, all_pages_count, offset;
+
+   all_pages_count = ((uint64_t) size + MPI_PMEM_CHECKPOINT_PAGE_SIZE - 1) / MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+   if (pages != NULL) {
+      *pages = malloc((all_pages_count > 0 ? all_pages_count : 1) * sizeof(uint64_t));
+      if (*pages == NULL) {
+         mpi_log_error("Unable to allocate memory.");
+         call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+         return MPI_ERR_PMEM_NO_MEM;
+      }
+      *pages_count = 0;
+   }
+
+   for (i = 0; i < all_pages_count; i++) {
+      offset = i * MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+      new_digests[i] = calculate_digest((const unsigned char*) base + offset, offset + MPI_PMEM_CHECKPOINT_PAGE_SIZE > (uint64_t) size ? size - offset : MPI_PMEM_CHECKPOINT_PAGE_SIZE);
+      if (pages != NULL && (old_digests == NULL || old_digests[i] != new_digests[i])) {
+         (*pages)[(*pages_count)++] = i;
+      }
+   }
+
+   if (pages != NULL) {
+      mpi_log_debug("%lu of %lu pages modified.", (unsigned long) *pages_count, (unsigned long) all_pages_count);
+   }
+
+   return MPI_SUCCESS;
+}
+
+void pack_modified_pages(void *destination, const void *base, MPI_Aint size, const uint64_t *pages, uint64_t pages_count) {
+   uint64_t i, offset, page_size;
+   unsigned char *position = destination;
+
+   for (i = 0; i < pages_count; i++) {
+      offset = pages[i] * MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+      page_size = offset + MPI_PMEM_CHECKPOINT_PAGE_SIZE > (uint64_t) size ? size - offset : MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+      memcpy(position, (const unsigned char*) base + offset, page_size);
+      position += page_size;
+   }
+}
+
+MPI_Aint incremental_checkpoint_size(MPI_Aint size, const uint64_t *pages, uint64_t pages_count) {
+   uint64_t data_size = pages_count * MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+
+   // Only last page of the window can be partial.
+   if (pages_count > 0 && (pages[pages_count - 1] + 1) * MPI_PMEM_CHECKPOINT_PAGE_SIZE > (uint64_t) size) {
+      data_size -= (pages[pages_count - 1] + 1) * MPI_PMEM_CHECKPOINT_PAGE_SIZE - size;
+   }
+
+   return sizeof(MPI_Win_pmem_incremental_header) + pages_count * sizeof(uint64_t) + data_size;
+}
+
+int write_incremental_checkpoint(MPI_Win_pmem_checkpoint_writer *writer, const void *base, MPI_Aint size, const uint64_t *pages, uint64_t pages_count, bool packed) {
+   int result;
+   MPI_Win_pmem_incremental_header header;
+   uint64_t i, first, start, end;
+
+   header.magic = MPI_PMEM_INCREMENTAL_CHECKPOINT_MAGIC;
+   header.window_size = size;
+   header.page_size = MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+   header.pages_count = pages_count;
+   result = write_checkpoint_data(writer, &header, sizeof(MPI_Win_pmem_incremental_header));
+   CHECK_ERROR_CODE(result);
+   result = write_checkpoint_data(writer, pages, pages_count * sizeof(uint64_t));
+   CHECK_ERROR_CODE(result);
+
+   if (packed) {
+      // Packed pages fill the rest of the file.
+      return write_checkpoint_data(writer, base, writer->size - writer->offset);
+   }
+
+   // Write contents of pages, merging consecutive pages into single write.
+   for (i = 0; i < pages_count; i++) {
+      first = i;
+      while (i + 1 < pages_count && pages[i + 1] == pages[i] + 1) {
+         i++;
+      }
+      start = pages[first] * MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+      end = (pages[i] + 1) * MPI_PMEM_CHECKPOINT_PAGE_SIZE;
+      if (end > (uint64_t) size) {
+         end = size;
+      }
+      result = write_checkpoint_data(writer, (const unsigned char*) base + start, end - start);
+      CHECK_ERROR_CODE(result);
+   }
+
+   return MPI_SUCCESS;
+}
+
+int restore_checkpoint_chain(MPI_Comm comm, const char *name, MPI_Win_pmem_version *versions, int versions_count, int version, MPI_Aint size, void *destination, MPI_Win_pmem_copy_pool *pool, int *chain_length) {
+   int result, parent_version;
+   char *file_name;
+   void *checkpoint_data;
+
+   // Checkpoint saved in slot is read from slot file.
+   if (version >= 0 && version < versions_count && versions[version].format == MPI_PMEM_CHECKPOINT_SLOT) {
+      result = get_slot_file_name(comm, name, versions[version].parent_version, &file_name);
+   } else {
+      result = get_checkpoint_file_name(comm, name, version, &file_name);
+   }
+   CHECK_ERROR_CODE(result);
+   if (version < 0 || version >= versions_count || versions[version].flags != MPI_PMEM_FLAG_OBJECT_EXISTS || !check_if_file_exist(file_name)) {
+      mpi_log_error("Checkpoint file '%s' doesn't exist.", file_name);
+      free(file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   if (is_chained_format(versions[version].format)) {
+      // Incremental and delta checkpoints are always based on lower versions, so recursion always ends with full checkpoint.
+      parent_version = versions[version].parent_version;
+      if (parent_version < 0 || parent_version >= version) {
+         mpi_log_error("Checkpoint version %d of window '%s' has invalid base version %d.", version, name, parent_version);
+         free(file_name);
+         call_comm_errhandler(comm, MPI_ERR_PMEM);
+         return MPI_ERR_PMEM;
+      }
+      result = restore_checkpoint_chain(comm, name, versions, versions_count, parent_version, size, destination, pool, chain_length);
+      CHECK_ERROR_CODE(result);
+      if (versions[version].format == MPI_PMEM_CHECKPOINT_DELTA) {
+         result = apply_delta_checkpoint(comm, file_name, size, destination);
+      } else {
+         result = apply_incremental_checkpoint(comm, file_name, size, destination);
+      }
+      CHECK_ERROR_CODE(result);
+      (*chain_length)++;
+   } else if (versions[version].format == MPI_PMEM_CHECKPOINT_CHUNKED) {
+      result = restore_chunked_checkpoint(comm, file_name, size, destination);
+      CHECK_ERROR_CODE(result);
+      *chain_length = 0;
+   } else if (versions[version].codec != MPI_PMEM_CODEC_NONE) {
+      result = restore_compressed_checkpoint(comm, file_name, versions[version].codec, size, destination);
+      CHECK_ERROR_CODE(result);
+      *chain_length = 0;
+   } else {
+      result = open_pmem_file(comm, file_name, size, &checkpoint_data);
+      CHECK_ERROR_CODE(result);
+      parallel_memcpy(pool, destination, checkpoint_data, size);
+      result = unmap_pmem_file(comm, checkpoint_data, size);
+      CHECK_ERROR_CODE(result);
+      *chain_length = 0;
+   }
+   free(file_name);
+
+   return MPI_SUCCESS;
+}
+
+bool checkpoint_depends_on(MPI_Win_pmem_version *versions, int version, int base) {
+   while (version > base && is_chained_format(versions[version].format)) {
+      if (versions[version].parent_version >= version) {
+         return false;
+      }
+      version = versions[version].parent_version;
+   }
+
+   return version == base;
+}
+
+int delete_checkpoint_chain(MPI_Win_pmem win, MPI_Win_pmem_version *versions, int versions_count, int version) {
+   int result, i, parent_version;
+
+   while (version >= 0 && version < versions_count) {
+      // Globally committed version (and its bases) is kept until newer version is committed.
+      if (version == win.modifiable_values->global_checkpoint_version) {
+         mpi_log_debug("Checkpoint version %d of window '%s' is globally committed.", version, win.name);
+         return MPI_SUCCESS;
+      }
+      // Checkpoint created in MPI_Win_fence is kept until all processes complete it together.
+      if (win.modifiable_values->queued_checkpoint != NULL && version == win.modifiable_values->queued_checkpoint->version) {
+         mpi_log_debug("Checkpoint version %d of window '%s' wasn't committed yet.", version, win.name);
+         return MPI_SUCCESS;
+      }
+      // Stop if this checkpoint is a base of some other checkpoint which is not being deleted.
+      for (i = version + 1; i < versions_count; i++) {
+         if (versions[i].flags == MPI_PMEM_FLAG_OBJECT_EXISTS && checkpoint_depends_on(versions, i, version)) {
+            mpi_log_debug("Checkpoint version %d of window '%s' is still needed by version %d.", version, win.name, i);
+            return MPI_SUCCESS;
+         }
+      }
+      parent_version = is_chained_format(versions[version].format) && versions[version].parent_version < version ? versions[version].parent_version : -1;
+      if (versions[version].flags == MPI_PMEM_FLAG_OBJECT_EXISTS) {
+         result = delete_checkpoint(win, versions, version);
+         CHECK_ERROR_CODE(result);
+      }
+      version = parent_version;
+   }
+
+   return MPI_SUCCESS;
+}
+
+int delete_dependent_checkpoints(MPI_Win_pmem win, MPI_Win_pmem_version *versions, int versions_count, int base) {
+   int result, i;
+
+   for (i = base + 1; i < versions_count; i++) {
+      if (versions[i].flags == MPI_PMEM_FLAG_OBJECT_EXISTS && checkpoint_depends_on(versions, i, base)) {
+         result = delete_checkpoint(win, versions, i);
+         CHECK_ERROR_CODE(result);
+      }
+   }
+
+   return MPI_SUCCESS;
+}
@@ -0,0 +1,162 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_INCREMENTAL_H__
+#define __MPI_WIN_PMEM_INCREMENTAL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <mpi.h>
+#include "mpi_win_pmem.h"
+#include "mpi_win_pmem_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MPI_PMEM_CHECKPOINT_PAGE_SIZE 4096
+#define MPI_PMEM_DEFAULT_FULL_CHECKPOINT_INTERVAL 8
+#define MPI_PMEM_INCREMENTAL_CHECKPOINT_MAGIC 0x52434E49434D454DULL // "MEMCINCR"
+
+// Header of incremental checkpoint file. It is followed by array of indices of saved pages (page map) and contents of these pages in the same order.
+typedef struct {
+   uint64_t magic;
+   uint64_t window_size;
+   uint64_t page_size;
+   uint64_t pages_count;
+} MPI_Win_pmem_incremental_header;
+
+/**
+ * Calculate digests of all pages of memory area and find pages which differ from the ones saved in previous checkpoint.
+ *
+ * @param comm          Communicator used for error handling.
+ * @param base          Starting address of memory area.
+ * @param size          Size of memory area.
+ * @param old_digests   Digests of pages saved in previous checkpoint or NULL if all pages should be treated as modified.
+ * @param new_digests   Output array for digests of current pages (must have space for one digest per page).
+ * @param pages         Output variable for array of indices of modified pages (must be freed by the caller) or NULL if only digests should be calculated.
+ * @param pages_count   Output variable for number of modified pages (ignored if pages is NULL).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int find_modified_pages(MPI_Comm comm, const void *base, MPI_Aint size, const uint64_t *old_digests, uint64_t *new_digests, uint64_t **pages, uint64_t *pages_count);
+
+/**
+ * Calculate size of incremental checkpoint file consisting of specified pages of memory area.
+ *
+ * @param size          Size of memory area.
+ * @param pages         Sorted array of indices of pages to save.
+ * @param pages_count   Number of pages to save.
+ *
+ * @returns Size of checkpoint file in bytes.
+ */
+MPI_Aint incremental_checkpoint_size(MPI_Aint size, const uint64_t *pages, uint64_t pages_count);
+
+/**
+ * Write incremental checkpoint consisting of specified pages of memory area into opened checkpoint file.
+ *
+ * @param writer        Writer of checkpoint file opened with size returned by incremental_checkpoint_size.
+ * @param base          Starting address of memory area.
+ * @param size          Size of memory area.
+ * @param pages         Sorted array of indices of pages to save.
+ * @param pages_count   Number of pages to save.
+ * @param packed        Flag specifying whether base contains only saved pages stored one after another (see pack_modified_pages).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int write_incremental_checkpoint(MPI_Win_pmem_checkpoint_writer *writer, const void *base, MPI_Aint size, const uint64_t *pages, uint64_t pages_count, bool packed);
+
+/**
+ * Copy specified pages of memory area one after another into destination.
+ *
+ * @param destination   Destination memory area.
+ * @param base          Starting address of memory area.
+ * @param size          Size of memory area.
+ * @param pages         Sorted array of indices of pages to copy.
+ * @param pages_count   Number of pages to copy.
+ */
+void pack_modified_pages(void *destination, const void *base, MPI_Aint size, const uint64_t *pages, uint64_t pages_count);
+
+/**
+ * Rebuild contents of specified checkpoint version by copying its last full checkpoint and applying all following incremental and delta checkpoints.
+ *
+ * @param comm          Communicator used for error handling.
+ * @param name          Window's name.
+ * @param versions      Memory address of mapped window's versions metadata file.
+ * @param versions_count Number of records in window's versions metadata file (without terminating record).
+ * @param version       Checkpoint version to restore.
+ * @param size          Size of window in bytes.
+ * @param destination   Destination memory area to copy data into.
+ * @param pool          Pool of threads used to copy full checkpoint (may be NULL).
+ * @param chain_length  Output variable for number of incremental and delta checkpoints applied on top of full checkpoint.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int restore_checkpoint_chain(MPI_Comm comm, const char *name, MPI_Win_pmem_version *versions, int versions_count, int version, MPI_Aint size, void *destination, MPI_Win_pmem_copy_pool *pool, int *chain_length);
+
+/**
+ * Check whether checkpoint version depends (directly or through other incremental or delta checkpoints) on base version.
+ *
+ * @param versions   Memory address of mapped window's versions metadata file.
+ * @param version    Checkpoint version to check.
+ * @param base       Possible base version.
+ *
+ * @returns True if base version is needed to restore checkpoint version, false otherwise.
+ */
+bool checkpoint_depends_on(MPI_Win_pmem_version *versions, int version, int base);
+
+/**
+ * Delete specified checkpoint version and all checkpoints it is based on (set flag in metadata file and remove data file).
+ * Checkpoints which are still needed by other existing checkpoints are not deleted.
+ *
+ * @param win              Window object.
+ * @param versions         Memory address of mapped window's versions metadata file.
+ * @param versions_count   Number of records in window's versions metadata file (without terminating record).
+ * @param version          Last checkpoint version of the chain to delete.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int delete_checkpoint_chain(MPI_Win_pmem win, MPI_Win_pmem_version *versions, int versions_count, int version);
+
+/**
+ * Delete all existing checkpoints based on specified version (set flag in metadata file and remove data file).
+ *
+ * @param win              Window object.
+ * @param versions         Memory address of mapped window's versions metadata file.
+ * @param versions_count   Number of records in window's versions metadata file (without terminating record).
+ * @param base             Base checkpoint version.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int delete_dependent_checkpoints(MPI_Win_pmem win, MPI_Win_pmem_version *versions, int versions_count, int base);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
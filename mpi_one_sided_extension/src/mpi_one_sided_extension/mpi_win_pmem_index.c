@@ -0,0 +1,425 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "mpi_win_pmem_index.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem_helper.h"
+
+#define MPI_PMEM_WINDOWS_INDEX_PATH_LENGTH (MPI_PMEM_MAX_ROOT_PATH + 19) // Additional 19 characters for: "/.windows_index", ".tmp" and terminating zero.
+
+// Index released by close_windows_index, kept mapped for next call of open_windows_index (windows field is NULL if there is no such index).
+static MPI_Win_pmem_windows_index cached_index;
+static char cached_root_path[MPI_PMEM_MAX_ROOT_PATH];
+// Protects cached_index and cached_root_path, as index may be opened from background checkpoint thread.
+static pthread_mutex_t cached_index_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Check whether file is the same file (and has the same size) as when it was mapped.
+ *
+ * @param file_name  Name of file.
+ * @param inode      Inode number of mapped file.
+ * @param size       Size of mapped file.
+ *
+ * @returns true if file wasn't replaced nor resized.
+ */
+static bool check_if_file_unchanged(const char *file_name, ino_t inode, off_t size) {
+   struct stat file_status;
+
+   return stat(file_name, &file_status) == 0 && file_status.st_ino == inode && file_status.st_size == size;
+}
+
+/**
+ * Get inode number of file.
+ *
+ * @param comm       Communicator used for error handling.
+ * @param file_name  Name of file.
+ * @param inode      Output variable for inode number.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int get_file_inode(MPI_Comm comm, const char *file_name, ino_t *inode) {
+   struct stat file_status;
+
+   if (stat(file_name, &file_status) != 0) {
+      mpi_log_error("Unable to get status of file '%s'.", file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   *inode = file_status.st_ino;
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Unmap global metadata file and its index.
+ *
+ * @param comm   Communicator used for error handling.
+ * @param index  Mapped index.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int unmap_windows_index(MPI_Comm comm, MPI_Win_pmem_windows_index *index) {
+   int result;
+
+   if (index->table != NULL) {
+      result = unmap_pmem_file(comm, index->table, index->table_file_size);
+      CHECK_ERROR_CODE(result);
+      index->table = NULL;
+   }
+   result = unmap_pmem_file(comm, index->windows, index->windows_file_size);
+   CHECK_ERROR_CODE(result);
+   index->windows = NULL;
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Calculate hash of window name (64-bit FNV-1a).
+ *
+ * @param name  Name of window.
+ *
+ * @returns Hash of name.
+ */
+static uint64_t hash_window_name(const char *name) {
+   uint64_t hash = 0xcbf29ce484222325ULL;
+
+   for (; *name != '\0'; name++) {
+      hash = (hash ^ (unsigned char) *name) * 0x100000001b3ULL;
+   }
+
+   return hash;
+}
+
+/**
+ * Count records preceding terminating record of global metadata file.
+ *
+ * @param index  Index with mapped global metadata file.
+ * @param first  Index of first record to check, all preceding records must be valid.
+ *
+ * @returns Number of records.
+ */
+static uint64_t count_window_records(const MPI_Win_pmem_windows_index *index, uint64_t first) {
+   uint64_t i;
+   uint64_t max_records = index->windows_file_size / sizeof(MPI_Win_pmem_metadata);
+
+   for (i = first; i < max_records && index->windows[i].flags != MPI_PMEM_FLAG_NO_OBJECT; i++);
+
+   return i;
+}
+
+/**
+ * Find slot referencing record of window with specified name.
+ *
+ * @param index    Opened index.
+ * @param name     Name of window.
+ * @param records  Only slots referencing records with lower index are taken into account.
+ *
+ * @returns Index of record in global metadata file or -1 if it isn't found.
+ */
+static int64_t lookup_window_record(const MPI_Win_pmem_windows_index *index, const char *name, uint64_t records) {
+   uint64_t position, record;
+
+   position = hash_window_name(name) & (index->table->capacity - 1);
+   while (index->table->slots[position] != 0) {
+      record = index->table->slots[position] - 1;
+      if (record < records && strcmp(index->windows[record].name, name) == 0) {
+         return (int64_t) record;
+      }
+      position = (position + 1) & (index->table->capacity - 1);
+   }
+
+   return -1;
+}
+
+/**
+ * Put record into first free slot of index table. Record must not be in table already.
+ *
+ * @param table    Index table.
+ * @param windows  Mapped global metadata file.
+ * @param record   Index of record in global metadata file.
+ *
+ * @returns Address of modified slot.
+ */
+static uint32_t* insert_window_record(MPI_Win_pmem_windows_index_table *table, const MPI_Win_pmem_metadata *windows, uint64_t record) {
+   uint64_t position = hash_window_name(windows[record].name) & (table->capacity - 1);
+
+   while (table->slots[position] != 0) {
+      position = (position + 1) & (table->capacity - 1);
+   }
+   table->slots[position] = (uint32_t) (record + 1);
+
+   return &table->slots[position];
+}
+
+/**
+ * Build new index of all records in global metadata file. Index is written into temporary file which replaces old index, so crash during rebuild leaves
+ * old index intact.
+ *
+ * @param comm      Communicator used for error handling.
+ * @param index     Index with mapped global metadata file. Previous index table (if any) is unmapped.
+ * @param capacity  Minimal number of slots of new index table (power of 2).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int rebuild_windows_index(MPI_Comm comm, MPI_Win_pmem_windows_index *index, uint64_t capacity) {
+   int result;
+   uint64_t i, records;
+   char file_name[MPI_PMEM_WINDOWS_INDEX_PATH_LENGTH], temporary_file_name[MPI_PMEM_WINDOWS_INDEX_PATH_LENGTH];
+   MPI_Win_pmem_windows_index_table *table;
+   off_t table_file_size;
+
+   // Keep load factor below 0.5, so probe sequences stay short.
+   records = count_window_records(index, 0);
+   while ((records + 1) * 2 > capacity) {
+      capacity *= 2;
+   }
+   mpi_log_debug("Building windows index with %lu slots for %lu windows.", capacity, records);
+
+   sprintf(file_name, "%s/.windows_index", mpi_pmem_root_path);
+   sprintf(temporary_file_name, "%s/.windows_index.tmp", mpi_pmem_root_path);
+   remove(temporary_file_name);
+   table_file_size = sizeof(MPI_Win_pmem_windows_index_table) + capacity * sizeof(uint32_t);
+   result = open_pmem_file(comm, temporary_file_name, table_file_size, (void**) &table);
+   CHECK_ERROR_CODE(result);
+   memset(table, 0, table_file_size);
+   table->capacity = capacity;
+   for (i = 0; i < records; i++) {
+      insert_window_record(table, index->windows, i);
+   }
+   table->records = records;
+   result = persist_pmem_file(comm, table, table_file_size);
+   CHECK_ERROR_CODE(result);
+
+   if (index->table != NULL) {
+      result = unmap_pmem_file(comm, index->table, index->table_file_size);
+      CHECK_ERROR_CODE(result);
+   }
+   if (rename(temporary_file_name, file_name) != 0) {
+      mpi_log_error("Unable to rename file '%s' to '%s'.", temporary_file_name, file_name);
+      unmap_pmem_file(comm, table, table_file_size);
+      index->table = NULL;
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   index->table = table;
+   index->table_file_size = table_file_size;
+   result = get_file_inode(comm, file_name, &index->table_inode);
+   CHECK_ERROR_CODE(result);
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Add record following the last indexed record to index. Index table is rebuilt with twice as many slots when it becomes half full.
+ *
+ * @param comm   Communicator used for error handling.
+ * @param index  Opened index.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int index_next_window_record(MPI_Comm comm, MPI_Win_pmem_windows_index *index) {
+   int result;
+   uint32_t *slot;
+   uint64_t record = index->table->records;
+
+   if ((record + 2) * 2 > index->table->capacity) {
+      return rebuild_windows_index(comm, index, index->table->capacity * 2);
+   }
+
+   // Slot is persisted before record count, so crash in between leaves record in table and it isn't inserted again.
+   if (lookup_window_record(index, index->windows[record].name, record + 1) < 0) {
+      slot = insert_window_record(index->table, index->windows, record);
+      result = persist_pmem_file(comm, slot, sizeof(uint32_t));
+      CHECK_ERROR_CODE(result);
+   }
+   index->table->records = record + 1;
+   result = persist_pmem_file(comm, &index->table->records, sizeof(uint64_t));
+   CHECK_ERROR_CODE(result);
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Map global metadata file and its index. Index is rebuilt if it doesn't exist or doesn't match global metadata file.
+ *
+ * @param comm   Communicator used for error handling.
+ * @param index  Output variable for mapped files. Files mapped before error are left in it.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int map_windows_index(MPI_Comm comm, MPI_Win_pmem_windows_index *index) {
+   int result;
+   bool valid;
+   char windows_file_name[MPI_PMEM_WINDOWS_INDEX_PATH_LENGTH], file_name[MPI_PMEM_WINDOWS_INDEX_PATH_LENGTH];
+   MPI_Win_pmem_windows_index_table *table;
+   uint64_t max_records;
+
+   sprintf(windows_file_name, "%s/.windows", mpi_pmem_root_path);
+   sprintf(file_name, "%s/.windows_index", mpi_pmem_root_path);
+   index->windows = NULL;
+   index->table = NULL;
+
+   result = open_windows_metadata_file(comm, &index->windows, &index->windows_file_size);
+   CHECK_ERROR_CODE(result);
+   result = get_file_inode(comm, windows_file_name, &index->windows_inode);
+   CHECK_ERROR_CODE(result);
+
+   // Map existing index and check whether it matches global metadata file.
+   if (check_if_file_exist(file_name)) {
+      result = get_file_size(comm, file_name, &index->table_file_size);
+      CHECK_ERROR_CODE(result);
+      if (index->table_file_size >= (off_t) sizeof(MPI_Win_pmem_windows_index_table)) {
+         result = open_pmem_file(comm, file_name, index->table_file_size, (void**) &table);
+         CHECK_ERROR_CODE(result);
+         max_records = index->windows_file_size / sizeof(MPI_Win_pmem_metadata);
+         valid = table->capacity >= MPI_PMEM_WINDOWS_INDEX_MIN_CAPACITY && (table->capacity & (table->capacity - 1)) == 0 &&
+                 index->table_file_size == (off_t) (sizeof(MPI_Win_pmem_windows_index_table) + table->capacity * sizeof(uint32_t)) &&
+                 table->records < max_records && (table->records == 0 || index->windows[table->records - 1].flags != MPI_PMEM_FLAG_NO_OBJECT);
+         if (valid) {
+            index->table = table;
+            result = get_file_inode(comm, file_name, &index->table_inode);
+            CHECK_ERROR_CODE(result);
+         } else {
+            mpi_log_debug("Windows index '%s' doesn't match global metadata file.", file_name);
+            result = unmap_pmem_file(comm, table, index->table_file_size);
+            CHECK_ERROR_CODE(result);
+         }
+      }
+   }
+   if (index->table == NULL) {
+      return rebuild_windows_index(comm, index, MPI_PMEM_WINDOWS_INDEX_MIN_CAPACITY);
+   }
+
+   return MPI_SUCCESS;
+}
+
+int open_windows_index(MPI_Comm comm, MPI_Win_pmem_windows_index *index) {
+   int result = MPI_SUCCESS;
+   bool reuse = false;
+   char windows_file_name[MPI_PMEM_WINDOWS_INDEX_PATH_LENGTH], file_name[MPI_PMEM_WINDOWS_INDEX_PATH_LENGTH];
+
+   sprintf(windows_file_name, "%s/.windows", mpi_pmem_root_path);
+   sprintf(file_name, "%s/.windows_index", mpi_pmem_root_path);
+
+   // Take over files mapped by previous call. Caller owns them until close_windows_index, so no other caller can use them in the meantime.
+   pthread_mutex_lock(&cached_index_mutex);
+   *index = cached_index;
+   cached_index.windows = NULL;
+   if (index->windows != NULL) {
+      reuse = strcmp(cached_root_path, mpi_pmem_root_path) == 0 && check_if_file_unchanged(windows_file_name, index->windows_inode, index->windows_file_size) &&
+              check_if_file_unchanged(file_name, index->table_inode, index->table_file_size);
+   }
+   pthread_mutex_unlock(&cached_index_mutex);
+
+   if (!reuse) {
+      if (index->windows != NULL) {
+         result = unmap_windows_index(comm, index);
+         CHECK_ERROR_CODE(result);
+      }
+      result = map_windows_index(comm, index);
+   }
+
+   // Index records appended after last update of index.
+   while (result == MPI_SUCCESS && count_window_records(index, index->table->records) > index->table->records) {
+      result = index_next_window_record(comm, index);
+   }
+
+   // Files aren't passed to caller on error, so they must not stay mapped.
+   if (result != MPI_SUCCESS && index->windows != NULL) {
+      unmap_windows_index(comm, index);
+   }
+
+   return result;
+}
+
+int find_window_record(const MPI_Win_pmem_windows_index *index, const char *name) {
+   return (int) lookup_window_record(index, name, index->table->records);
+}
+
+int append_window_record(MPI_Comm comm, MPI_Win_pmem_windows_index *index, const char *name, MPI_Aint size, int *record) {
+   int result;
+   char file_name[MPI_PMEM_WINDOWS_INDEX_PATH_LENGTH];
+   uint64_t i = index->table->records;
+   off_t file_size = (i + 2) * sizeof(MPI_Win_pmem_metadata);
+
+   // Enlarge global metadata file.
+   if (file_size > index->windows_file_size) {
+      result = unmap_pmem_file(comm, index->windows, index->windows_file_size);
+      CHECK_ERROR_CODE(result);
+      sprintf(file_name, "%s/.windows", mpi_pmem_root_path);
+      result = open_pmem_file(comm, file_name, file_size, (void**) &index->windows);
+      CHECK_ERROR_CODE(result);
+      index->windows_file_size = file_size;
+   }
+
+   // Create new terminating record and update window's metadata in previous terminating record. Both records are persisted at once, as record isn't valid
+   // until its flag is set.
+   index->windows[i + 1].size = 0;
+   index->windows[i + 1].flags = MPI_PMEM_FLAG_NO_OBJECT;
+   index->windows[i + 1].stripe_root_path = 0;
+   strcpy(index->windows[i].name, name);
+   index->windows[i].size = size;
+   index->windows[i].stripe_root_path = 0;
+   result = persist_pmem_file(comm, &index->windows[i], 2 * sizeof(MPI_Win_pmem_metadata));
+   CHECK_ERROR_CODE(result);
+   // Set flag to indicate that window exists.
+   index->windows[i].flags = MPI_PMEM_FLAG_OBJECT_EXISTS;
+   result = persist_pmem_file(comm, &index->windows[i].flags, sizeof(char));
+   CHECK_ERROR_CODE(result);
+
+   result = index_next_window_record(comm, index);
+   CHECK_ERROR_CODE(result);
+   *record = (int) i;
+
+   return MPI_SUCCESS;
+}
+
+int close_windows_index(MPI_Comm comm, MPI_Win_pmem_windows_index *index) {
+   int result;
+   MPI_Win_pmem_windows_index replaced_index;
+
+   // Index closed in the meantime (by another caller) is replaced.
+   pthread_mutex_lock(&cached_index_mutex);
+   replaced_index = cached_index;
+   cached_index = *index;
+   strcpy(cached_root_path, mpi_pmem_root_path);
+   pthread_mutex_unlock(&cached_index_mutex);
+
+   if (replaced_index.windows != NULL) {
+      result = unmap_windows_index(comm, &replaced_index);
+      CHECK_ERROR_CODE(result);
+   }
+
+   return MPI_SUCCESS;
+}
@@ -0,0 +1,109 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __MPI_WIN_PMEM_INDEX_H__
+#define __MPI_WIN_PMEM_INDEX_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <mpi.h>
+#include "mpi_win_pmem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MPI_PMEM_WINDOWS_INDEX_MIN_CAPACITY 64
+
+// Hash table saved in file <root>/.windows_index. Slots are open addressed with linear probing and contain index of record in global metadata file increased
+// by 1 (0 marks empty slot). Records of deleted windows stay in global metadata file (flagged as deleted) and their slots act as tombstones.
+typedef struct {
+   uint64_t capacity;   // Number of slots, always power of 2.
+   uint64_t records;    // Number of leading records of global metadata file which are indexed.
+   uint32_t slots[];
+} MPI_Win_pmem_windows_index_table;
+
+// Global metadata file together with its index, both mapped into memory.
+typedef struct {
+   MPI_Win_pmem_metadata *windows;
+   off_t windows_file_size;
+   ino_t windows_inode;
+   MPI_Win_pmem_windows_index_table *table;
+   off_t table_file_size;
+   ino_t table_inode;
+} MPI_Win_pmem_windows_index;
+
+/**
+ * Map global metadata file and its index. Files stay mapped between calls (as long as root path doesn't change and files aren't replaced or resized by other
+ * process), so usually only their status is checked. Records appended to global metadata file but not indexed (e.g. because of crash) are added to index,
+ * index is rebuilt if it doesn't exist or doesn't match global metadata file.
+ *
+ * @param comm   Communicator used for error handling.
+ * @param index  Output variable for mapped files. Use close_windows_index to unmap them (they are unmapped on error).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int open_windows_index(MPI_Comm comm, MPI_Win_pmem_windows_index *index);
+
+/**
+ * Find record of window in global metadata file.
+ *
+ * @param index  Index opened with open_windows_index.
+ * @param name   Name of window.
+ *
+ * @returns Index of record in global metadata file or -1 if window with specified name has never been created.
+ */
+int find_window_record(const MPI_Win_pmem_windows_index *index, const char *name);
+
+/**
+ * Append record of new window to global metadata file and add it to index.
+ *
+ * @param comm    Communicator used for error handling.
+ * @param index   Index opened with open_windows_index.
+ * @param name    Name of window.
+ * @param size    Size of window.
+ * @param record  Output variable for index of new record in global metadata file.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int append_window_record(MPI_Comm comm, MPI_Win_pmem_windows_index *index, const char *name, MPI_Aint size, int *record);
+
+/**
+ * Release global metadata file and its index. Files are kept mapped for next call of open_windows_index.
+ *
+ * @param comm   Communicator used for error handling.
+ * @param index  Index opened with open_windows_index.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int close_windows_index(MPI_Comm comm, MPI_Win_pmem_windows_index *index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
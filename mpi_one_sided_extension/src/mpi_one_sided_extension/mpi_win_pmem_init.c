@@ -31,9 +31,23 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include <libpmem.h>
 #include "../common/logger.h"
+#include "../common/util.h"
 #include "mpi_win_pmem_helper.h"
+#include "mpi_win_pmem_incremental.h"
+#include "mpi_win_pmem_parallel.h"
+#include "mpi_win_pmem_codec.h"
+#include "mpi_win_pmem_dirty.h"
+#include "mpi_win_pmem_throttle.h"
+#include "mpi_win_pmem_aggregate.h"
+#include "mpi_win_pmem_shared.h"
+#include "mpi_win_pmem_areas.h"
+#include "mpi_win_pmem_numa.h"
+#include "mpi_win_pmem_lazy.h"
+#include "mpi_win_pmem_slots.h"
+#include "mpi_win_pmem_reclaim.h"
 
 int MPI_Win_create_pmem(void *base, MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm, MPI_Win_pmem *win) {
    int result;
@@ -50,18 +64,16 @@ int MPI_Win_create_pmem(void *base, MPI_Aint size, int disp_unit, MPI_Info info,
    } else {
       result = parse_mpi_info_bool(info, "pmem_is_pmem", &win->is_pmem);
       CHECK_ERROR_CODE(result);
+      if (win->is_pmem) {
+         result = parse_mpi_info_bool(info, "pmem_track_dirty_ranges", &win->track_dirty_ranges);
+         CHECK_ERROR_CODE(result);
+      }
    }
-   win->modifiable_values->memory_areas = malloc(sizeof(MPI_Win_memory_areas_list));
-   if (win->modifiable_values->memory_areas == NULL) {
-      mpi_log_error("Unable to allocate memory.");
-      MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
-      return MPI_ERR_PMEM_NO_MEM;
-   }
-   win->modifiable_values->memory_areas->base = base;
-   win->modifiable_values->memory_areas->size = size;
-   win->modifiable_values->memory_areas->next = NULL;
-   if (win->is_pmem == true) {
-      win->modifiable_values->memory_areas->is_pmem = pmem_is_pmem(base, size);
+   result = add_memory_area(*win, base, size, NULL);
+   CHECK_ERROR_CODE(result);
+   if (win->track_dirty_ranges) {
+      result = create_dirty_tracker(*win, disp_unit, false, &win->modifiable_values->dirty_tracker);
+      CHECK_ERROR_CODE(result);
    }
    
    mpi_log_debug("Window with base: 0x%lx, size: %lu created.", (long int) base, size);
@@ -69,19 +81,18 @@ int MPI_Win_create_pmem(void *base, MPI_Aint size, int disp_unit, MPI_Info info,
    return MPI_SUCCESS;
 }
 
-int MPI_Win_allocate_pmem(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm, void *baseptr, MPI_Win_pmem *win) {
-   int result;
-   char *file_name;
-   MPI_Win_pmem_version *versions;
-   off_t versions_file_size;
-   void **pmem_ptr = baseptr;
-   bool window_exists;
-
-   mpi_log_debug("Allocating window of size: %lu.", size);
+/**
+ * Parse MPI_Info parameters of window allocated by MPI_Win_allocate_pmem or MPI_Win_allocate_shared_pmem.
+ *
+ * @param win   Window object.
+ * @param info  MPI_Info object to parse.
+ * @param comm  Communicator used for error handling.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int parse_allocated_window_info(MPI_Win_pmem *win, MPI_Info info, MPI_Comm comm) {
+   int result, thread_support, page_size;
 
-   // Parse MPI_Info.
-   result = set_default_window_metadata(win, comm);
-   CHECK_ERROR_CODE(result);
    if (info == MPI_INFO_NULL) {
       mpi_log_debug("MPI_Info object is NULL.");
    } else {
@@ -98,6 +109,58 @@ int MPI_Win_allocate_pmem(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm
          if (win->modifiable_values->transactional) {
             result = parse_mpi_info_bool(info, "pmem_keep_all_checkpoints", &win->modifiable_values->keep_all_checkpoints);
             CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_bool(info, "pmem_checkpoint_incremental", &win->incremental_checkpoints);
+            CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_bool(info, "pmem_checkpoint_delta", &win->delta_checkpoints);
+            CHECK_ERROR_CODE(result);
+            if (win->delta_checkpoints && win->incremental_checkpoints) {
+               // Delta of modified pages contains also changes found by page digests, so only one of the modes is used.
+               mpi_log_debug("Checkpoints aren't incremental, because delta checkpoints are enabled.");
+               win->incremental_checkpoints = false;
+            }
+            result = parse_mpi_info_bool(info, "pmem_checkpoint_async", &win->async_checkpoints);
+            CHECK_ERROR_CODE(result);
+            if (win->async_checkpoints) {
+               // Background thread uses MPI (error handlers, logger), so it can be used only if MPI supports multiple threads.
+               MPI_Query_thread(&thread_support);
+               if (thread_support != MPI_THREAD_MULTIPLE) {
+                  mpi_log_debug("MPI_THREAD_MULTIPLE not supported, checkpoints will be written synchronously.");
+                  win->async_checkpoints = false;
+               }
+            }
+            result = parse_mpi_info_checkpoint_threads(comm, info, &win->checkpoint_threads);
+            CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_checkpoint_codec(comm, info, &win->checkpoint_codec);
+            CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_bool(info, "pmem_checkpoint_dedup", &win->dedup_checkpoints);
+            CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_bool(info, "pmem_checkpoint_aggregate", &win->aggregate_checkpoints);
+            CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_checkpoint_schedule(comm, info, &win->checkpoint_mtbf, &win->checkpoint_overhead);
+            CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_checkpoint_throttle(comm, info, &win->checkpoint_writers, &win->checkpoint_rate);
+            CHECK_ERROR_CODE(result);
+            if (win->incremental_checkpoints || win->delta_checkpoints) {
+               result = parse_mpi_info_int(comm, info, "pmem_checkpoint_full_interval", MPI_PMEM_DEFAULT_FULL_CHECKPOINT_INTERVAL, &win->full_checkpoint_interval);
+               CHECK_ERROR_CODE(result);
+               if (win->full_checkpoint_interval < 1) {
+                  mpi_log_error("Invalid value %d for key pmem_checkpoint_full_interval.", win->full_checkpoint_interval);
+                  call_comm_errhandler(comm, MPI_ERR_PMEM_ARG);
+                  return MPI_ERR_PMEM_ARG;
+               }
+            }
+            // Node checkpoint file contains plain copies of windows placed at offsets computed before data is written.
+            if (win->aggregate_checkpoints && (win->incremental_checkpoints || win->delta_checkpoints || win->checkpoint_codec != MPI_PMEM_CODEC_NONE || win->dedup_checkpoints)) {
+               mpi_log_debug("Checkpoints aren't aggregated, because they are incremental, delta encoded, compressed or deduplicated.");
+               win->aggregate_checkpoints = false;
+            }
+            result = parse_mpi_info_int(comm, info, "pmem_checkpoint_slots", 0, &win->checkpoint_slots);
+            CHECK_ERROR_CODE(result);
+            if (win->checkpoint_slots < 0) {
+               mpi_log_error("Invalid value %d for key pmem_checkpoint_slots.", win->checkpoint_slots);
+               call_comm_errhandler(comm, MPI_ERR_PMEM_ARG);
+               return MPI_ERR_PMEM_ARG;
+            }
          }
          result = parse_mpi_info_name(comm, info, win->name);
          CHECK_ERROR_CODE(result);
@@ -110,88 +173,218 @@ int MPI_Win_allocate_pmem(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm
             CHECK_ERROR_CODE(result);
             result = parse_mpi_info_bool(info, "pmem_global_checkpoint", &win->global_checkpoint);
             CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_bool(info, "pmem_restore_zero_copy", &win->zero_copy_restore);
+            CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_bool(info, "pmem_restore_lazy", &win->lazy_restore);
+            CHECK_ERROR_CODE(result);
+            if (win->lazy_restore && (win->incremental_checkpoints || win->delta_checkpoints)) {
+               // Digests or reference copy of restored pages are computed at once, which would fault in the whole window.
+               mpi_log_debug("Window isn't restored lazily, because incremental or delta checkpoints are enabled.");
+               win->lazy_restore = false;
+            }
          }
          result = parse_mpi_info_bool(info, "pmem_volatile", &win->is_volatile);
          CHECK_ERROR_CODE(result);
+         result = parse_mpi_info_bool(info, "pmem_track_dirty_ranges", &win->track_dirty_ranges);
+         CHECK_ERROR_CODE(result);
+         result = parse_mpi_info_bool(info, "pmem_map_sync", &win->map_sync);
+         CHECK_ERROR_CODE(result);
+         result = parse_mpi_info_bool(info, "pmem_prefault", &win->prefault);
+         CHECK_ERROR_CODE(result);
+         result = parse_mpi_info_int(comm, info, "pmem_stripe_size", 0, &win->stripe_size);
+         CHECK_ERROR_CODE(result);
+         if (win->stripe_size < 0) {
+            mpi_log_error("Invalid value %d for key pmem_stripe_size.", win->stripe_size);
+            call_comm_errhandler(comm, MPI_ERR_PMEM_ARG);
+            return MPI_ERR_PMEM_ARG;
+         }
+         if (win->stripe_size > 0 && (mpi_pmem_root_paths_count < 2 || win->allocate_in_ram)) {
+            mpi_log_debug("Window isn't striped, because it is allocated in RAM or there is only one root path.");
+            win->stripe_size = 0;
+         }
+         if (win->stripe_size > 0) {
+            // Stripes are mapped separately, so they have to be aligned to pages. Striped memory can't be replaced with mapped checkpoint file.
+            page_size = sysconf(_SC_PAGESIZE);
+            win->stripe_size = (win->stripe_size + page_size - 1) / page_size * page_size;
+            win->zero_copy_restore = false;
+         }
+      }
+   }
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Load metadata of allocated window and create objects used to write its checkpoints.
+ *
+ * @param win   Window object.
+ * @param size  Size of window (memory segment of calling process in shared window).
+ * @param comm  Communicator used for error handling.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int prepare_allocated_window(MPI_Win_pmem *win, MPI_Aint size, MPI_Comm comm) {
+   int result;
+
+   if (!win->is_volatile) {
+      result = load_window_metadata(win, size);
+      CHECK_ERROR_CODE(result);
+      if (win->modifiable_values->transactional && win->checkpoint_slots > 0) {
+         result = open_checkpoint_slots(comm, win->name, win->checkpoint_slots, size, &win->modifiable_values->slot_ring);
+         CHECK_ERROR_CODE(result);
       }
    }
+   result = create_copy_pool(comm, win->checkpoint_threads, &win->modifiable_values->copy_pool);
+   CHECK_ERROR_CODE(result);
+   if (win->checkpoint_writers > 0) {
+      result = create_checkpoint_throttle(comm, win->checkpoint_writers, &win->modifiable_values->throttle);
+      CHECK_ERROR_CODE(result);
+   }
+   if (win->aggregate_checkpoints) {
+      result = create_checkpoint_aggregator(comm, &win->modifiable_values->aggregator);
+      CHECK_ERROR_CODE(result);
+   }
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Fill memory of allocated window with last checkpoint if window is opened in checkpoint mode.
+ *
+ * @param win     Window object.
+ * @param size    Size of window (memory segment of calling process in shared window).
+ * @param base    Memory of window.
+ * @param mapped  Flag specifying whether checkpoint file already is window's memory.
+ * @param comm    Communicator used for error handling.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int restore_allocated_window(MPI_Win_pmem *win, MPI_Aint size, void *base, bool mapped, MPI_Comm comm) {
+   int result;
+
+   if (!win->is_volatile && win->mode == MPI_PMEM_MODE_CHECKPOINT) {
+      if (!mapped) {
+         result = copy_data_from_checkpoint(*win, size, base);
+         CHECK_ERROR_CODE(result);
+      }
+      // Restored data is the base for next incremental checkpoint.
+      if (win->incremental_checkpoints) {
+         win->modifiable_values->page_digests = malloc((((uint64_t) size + MPI_PMEM_CHECKPOINT_PAGE_SIZE - 1) / MPI_PMEM_CHECKPOINT_PAGE_SIZE + 1) * sizeof(uint64_t));
+         if (win->modifiable_values->page_digests == NULL) {
+            mpi_log_error("Unable to allocate memory.");
+            call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+            return MPI_ERR_PMEM_NO_MEM;
+         }
+         result = find_modified_pages(comm, base, size, NULL, win->modifiable_values->page_digests, NULL, NULL);
+         CHECK_ERROR_CODE(result);
+         win->modifiable_values->page_digests_valid = true;
+      }
+      // Restored data is the reference for next delta.
+      if (win->delta_checkpoints) {
+         win->modifiable_values->delta_reference = malloc(size);
+         if (win->modifiable_values->delta_reference == NULL) {
+            mpi_log_error("Unable to allocate memory.");
+            call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+            return MPI_ERR_PMEM_NO_MEM;
+         }
+         parallel_memcpy(win->modifiable_values->copy_pool, win->modifiable_values->delta_reference, base, size);
+      }
+   }
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Register memory of allocated window as its only memory area.
+ *
+ * @param win        Window object.
+ * @param base       Memory of window.
+ * @param size       Size of window (memory segment of calling process in shared window).
+ * @param disp_unit  Displacement unit of window.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int add_allocated_memory_area(MPI_Win_pmem *win, void *base, MPI_Aint size, int disp_unit) {
+   int result;
+
+   result = add_memory_area(*win, base, size, NULL);
+   CHECK_ERROR_CODE(result);
+   if (win->track_dirty_ranges) {
+      result = create_dirty_tracker(*win, disp_unit, false, &win->modifiable_values->dirty_tracker);
+      CHECK_ERROR_CODE(result);
+   }
+
+   return MPI_SUCCESS;
+}
+
+int MPI_Win_allocate_pmem(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm, void *baseptr, MPI_Win_pmem *win) {
+   int result;
+   char *file_name;
+   bool mapped;
+   void **pmem_ptr = baseptr;
+
+   mpi_log_debug("Allocating window of size: %lu.", size);
+
+   // Parse MPI_Info.
+   result = set_default_window_metadata(win, comm);
+   CHECK_ERROR_CODE(result);
+   result = parse_allocated_window_info(win, info, comm);
+   CHECK_ERROR_CODE(result);
 
    // Allocate memory and update metadata.
    if (win->is_pmem) {
       file_name = malloc((strlen(mpi_pmem_root_path) + strlen(win->name) + 3) * sizeof(char)); // Additional 3 characters for: "/." and terminating zero.
       if (file_name == NULL) {
          mpi_log_error("Unable to allocate memory.");
-         MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+         call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
          return MPI_ERR_PMEM_NO_MEM;
       }
 
-      // Check if window already exists in metadata and create it if not.
-      if (!win->is_volatile) {
-         result = check_if_window_exists_and_its_size(win, size, &window_exists);
+      result = prepare_allocated_window(win, size, comm);
+      CHECK_ERROR_CODE(result);
+
+      // Allocate memory.
+      mapped = false;
+      if (!win->allocate_in_ram && !win->is_volatile && win->mode == MPI_PMEM_MODE_CHECKPOINT && win->zero_copy_restore) {
+         result = map_checkpoint_as_window(*win, size, pmem_ptr, &mapped);
          CHECK_ERROR_CODE(result);
-         sprintf(file_name, "%s/.%s", mpi_pmem_root_path, win->name);
-         if (window_exists) {
-            result = get_file_size(comm, file_name, &versions_file_size);
-            CHECK_ERROR_CODE(result);
-            result = open_pmem_file(comm, file_name, versions_file_size, (void**) &versions);
-            CHECK_ERROR_CODE(result);
-            // Cleanup old window's versions when expanding window.
-            if (win->mode == MPI_PMEM_MODE_EXPAND) {
-               result = delete_old_checkpoints(win->comm, win->name, versions);
-               CHECK_ERROR_CODE(result);
-               result = update_window_size_in_metadata_file(win, size);
-               CHECK_ERROR_CODE(result);
-            }
-         } else {
-            if (win->mode == MPI_PMEM_MODE_CHECKPOINT) {
-               mpi_log_error("Window with name '%s' doesn't exist.", win->name);
-               MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM_NAME);
-               return MPI_ERR_PMEM_NAME;
-            }
-            result = create_window_metadata_file(comm, file_name, &versions, win->name, size);
+      }
+      if (mapped) {
+         // Checkpoint already is the window's memory.
+         win->modifiable_values->checkpoint_chain_length = 0;
+      } else if (win->allocate_in_ram) {
+         if (!win->is_volatile && win->mode == MPI_PMEM_MODE_CHECKPOINT && win->lazy_restore) {
+            result = start_lazy_restore(*win, size, pmem_ptr, &mapped);
             CHECK_ERROR_CODE(result);
-            versions_file_size = sizeof(MPI_Win_pmem_version);
          }
-         result = set_checkpoint_versions(win, versions);
-         CHECK_ERROR_CODE(result);
-         result = unmap_pmem_file(comm, versions, versions_file_size);
-         CHECK_ERROR_CODE(result);
-      }
-
-      // Allocate memory.
-      if (win->allocate_in_ram) {
-         *pmem_ptr = malloc(size);
-         if (*pmem_ptr == NULL) {
+         if (mapped) {
+            // Pages are filled from checkpoint on demand by background thread.
+            win->modifiable_values->checkpoint_chain_length = 0;
+         } else if ((*pmem_ptr = malloc(size)) == NULL) {
             mpi_log_error("Unable to allocate memory.");
-            MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+            call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
             return MPI_ERR_PMEM_NO_MEM;
          }
+      } else if (win->stripe_size > 0) {
+         result = open_striped_pmem_file(comm, win->name, size, win->stripe_size, pmem_ptr);
+         CHECK_ERROR_CODE(result);
       } else {
          sprintf(file_name, "%s/%s", mpi_pmem_root_path, win->name);
-         result = open_pmem_file(comm, file_name, size, pmem_ptr);
+         result = map_window_file(comm, file_name, size, win->map_sync, pmem_ptr);
          CHECK_ERROR_CODE(result);
       }
-
-      if (!win->is_volatile && win->mode == MPI_PMEM_MODE_CHECKPOINT) {
-         result = copy_data_from_checkpoint(*win, size, *pmem_ptr);
-         CHECK_ERROR_CODE(result);
+      if (!mapped && !win->allocate_in_ram && win->prefault) {
+         parallel_prefault(win->modifiable_values->copy_pool, *pmem_ptr, size);
       }
+      result = restore_allocated_window(win, size, *pmem_ptr, mapped, comm);
+      CHECK_ERROR_CODE(result);
 
       free(file_name);
 
       result = MPI_Win_create(*pmem_ptr, size, disp_unit, info, comm, &win->win);
       CHECK_ERROR_CODE(result);
-
-      win->modifiable_values->memory_areas = malloc(sizeof(MPI_Win_memory_areas_list));
-      if (win->modifiable_values->memory_areas == NULL) {
-         mpi_log_error("Unable to allocate memory.");
-         MPI_Comm_call_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
-         return MPI_ERR_PMEM_NO_MEM;
-      }
-      win->modifiable_values->memory_areas->base = *pmem_ptr;
-      win->modifiable_values->memory_areas->size = size;
-      win->modifiable_values->memory_areas->next = NULL;
-      win->modifiable_values->memory_areas->is_pmem = pmem_is_pmem(*pmem_ptr, size);
+      result = add_allocated_memory_area(win, *pmem_ptr, size, disp_unit);
+      CHECK_ERROR_CODE(result);
    } else {
       result = MPI_Win_allocate(size, disp_unit, info, comm, baseptr, &win->win);
       CHECK_ERROR_CODE(result);
@@ -204,21 +397,56 @@ int MPI_Win_allocate_pmem(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm
 
 int MPI_Win_allocate_shared_pmem(MPI_Aint size, int disp_unit, MPI_Info info, MPI_Comm comm, void *baseptr, MPI_Win_pmem *win) {
    int result;
+   void **pmem_ptr = baseptr;
+
+   mpi_log_debug("Allocating shared window of size: %lu.", size);
 
-   result = MPI_Win_allocate_shared(size, disp_unit, info, comm, baseptr, &win->win);
-   CHECK_ERROR_CODE(result);
    result = set_default_window_metadata(win, comm);
    CHECK_ERROR_CODE(result);
-   
+   result = parse_allocated_window_info(win, info, comm);
+   CHECK_ERROR_CODE(result);
+
+   if (win->is_pmem) {
+      // Segments of all processes are placed in one data file mapped by all of them, so they can't be allocated in RAM, striped or mapped from checkpoint files.
+      win->allocate_in_ram = false;
+      win->stripe_size = 0;
+      win->zero_copy_restore = false;
+      win->lazy_restore = false;
+      result = prepare_allocated_window(win, size, comm);
+      CHECK_ERROR_CODE(result);
+      result = map_shared_window(win, size, disp_unit, pmem_ptr);
+      CHECK_ERROR_CODE(result);
+      if (win->prefault) {
+         parallel_prefault(win->modifiable_values->copy_pool, *pmem_ptr, size);
+      }
+      result = restore_allocated_window(win, size, *pmem_ptr, false, comm);
+      CHECK_ERROR_CODE(result);
+      result = MPI_Win_create(*pmem_ptr, size, disp_unit, info, comm, &win->win);
+      CHECK_ERROR_CODE(result);
+      result = add_allocated_memory_area(win, *pmem_ptr, size, disp_unit);
+      CHECK_ERROR_CODE(result);
+   } else {
+      result = MPI_Win_allocate_shared(size, disp_unit, info, comm, baseptr, &win->win);
+      CHECK_ERROR_CODE(result);
+   }
+
+   mpi_log_debug("Shared window of size: %lu allocated.", size);
+
    return MPI_SUCCESS;
 }
 
 int MPI_Win_shared_query_pmem(MPI_Win_pmem win, int rank, MPI_Aint *size, int *disp_unit, void *baseptr) {
+   // Window created by MPI_Win_create isn't shared for MPI, so segments are described by extension.
+   if (win.modifiable_values->shared_segments != NULL) {
+      return query_shared_segment(win, rank, size, disp_unit, baseptr);
+   }
+
    return MPI_Win_shared_query(win.win, rank, size, disp_unit, baseptr);
 }
 
 int MPI_Win_create_dynamic_pmem(MPI_Info info, MPI_Comm comm, MPI_Win_pmem *win) {
-   int result;
+   int result, name_length, has_name;
+   bool dont_use_transactions;
 
    mpi_log_debug("Creating dynamic window.");
 
@@ -231,6 +459,56 @@ int MPI_Win_create_dynamic_pmem(MPI_Info info, MPI_Comm comm, MPI_Win_pmem *win)
    } else {
       result = parse_mpi_info_bool(info, "pmem_is_pmem", &win->is_pmem);
       CHECK_ERROR_CODE(result);
+      if (win->is_pmem) {
+         result = parse_mpi_info_bool(info, "pmem_track_dirty_ranges", &win->track_dirty_ranges);
+         CHECK_ERROR_CODE(result);
+      }
+      // Dynamic window is checkpointed only if it has a name.
+      result = MPI_Info_get_valuelen(info, "pmem_name", &name_length, &has_name);
+      CHECK_ERROR_CODE(result);
+      if (win->is_pmem && has_name) {
+         result = parse_mpi_info_bool(info, "pmem_dont_use_transactions", &dont_use_transactions);
+         CHECK_ERROR_CODE(result);
+         win->modifiable_values->transactional = !dont_use_transactions;
+         if (win->modifiable_values->transactional) {
+            result = parse_mpi_info_bool(info, "pmem_keep_all_checkpoints", &win->modifiable_values->keep_all_checkpoints);
+            CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_checkpoint_threads(comm, info, &win->checkpoint_threads);
+            CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_checkpoint_schedule(comm, info, &win->checkpoint_mtbf, &win->checkpoint_overhead);
+            CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_checkpoint_throttle(comm, info, &win->checkpoint_writers, &win->checkpoint_rate);
+            CHECK_ERROR_CODE(result);
+         }
+         result = parse_mpi_info_name(comm, info, win->name);
+         CHECK_ERROR_CODE(result);
+         result = parse_mpi_info_mode(comm, info, &win->mode);
+         CHECK_ERROR_CODE(result);
+         if (win->mode == MPI_PMEM_MODE_CHECKPOINT) {
+            result = parse_mpi_info_checkpoint_version(comm, info, &win->modifiable_values->last_checkpoint_version);
+            CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_bool(info, "pmem_append_checkpoints", &win->append_checkpoints);
+            CHECK_ERROR_CODE(result);
+            result = parse_mpi_info_bool(info, "pmem_global_checkpoint", &win->global_checkpoint);
+            CHECK_ERROR_CODE(result);
+         }
+
+         // Size of dynamic window is not known, so it is saved as 0 in global metadata file.
+         result = load_window_metadata(win, 0);
+         CHECK_ERROR_CODE(result);
+         result = create_copy_pool(comm, win->checkpoint_threads, &win->modifiable_values->copy_pool);
+         CHECK_ERROR_CODE(result);
+         if (win->checkpoint_writers > 0) {
+            result = create_checkpoint_throttle(comm, win->checkpoint_writers, &win->modifiable_values->throttle);
+            CHECK_ERROR_CODE(result);
+         }
+         win->modifiable_values->restore_on_attach = win->mode == MPI_PMEM_MODE_CHECKPOINT && win->modifiable_values->last_checkpoint_version != -1;
+      }
+   }
+   if (win->track_dirty_ranges) {
+      // Displacements in dynamic windows are addresses.
+      result = create_dirty_tracker(*win, 1, true, &win->modifiable_values->dirty_tracker);
+      CHECK_ERROR_CODE(result);
    }
    
    mpi_log_debug("Dynamic window created.");
@@ -246,18 +524,13 @@ int MPI_Win_attach_pmem(MPI_Win_pmem win, void *base, MPI_Aint size) {
 
    result = MPI_Win_attach(win.win, base, size);
    CHECK_ERROR_CODE(result);
-   list_item = malloc(sizeof(MPI_Win_memory_areas_list));
-   if (list_item == NULL) {
-      mpi_log_error("Unable to allocate memory.");
-      MPI_Win_call_errhandler(win.win, MPI_ERR_PMEM_NO_MEM);
-      return MPI_ERR_PMEM_NO_MEM;
-   }
-   list_item->base = base;
-   list_item->size = size;
-   list_item->next = win.modifiable_values->memory_areas;
-   win.modifiable_values->memory_areas = list_item;
-   if (win.is_pmem == true) {
-      list_item->is_pmem = pmem_is_pmem(base, size);
+   result = add_memory_area(win, base, size, &list_item);
+   CHECK_ERROR_CODE(result);
+
+   // Fill memory area with data saved in checkpoint, areas are matched by the order in which they were attached.
+   if (win.modifiable_values->restore_on_attach) {
+      result = restore_memory_area(win, list_item);
+      CHECK_ERROR_CODE(result);
    }
 
    mpi_log_debug("Memory area with base: 0x%lx, size: %lu attached.", (long int) base, size);
@@ -267,59 +540,87 @@ int MPI_Win_attach_pmem(MPI_Win_pmem win, void *base, MPI_Aint size) {
 
 int MPI_Win_detach_pmem(MPI_Win_pmem win, const void *base) {
    int result;
-   MPI_Win_memory_areas_list *current_item, *previous_item;
+   MPI_Win_memory_areas_list *list_item;
 
    mpi_log_debug("Detaching memory area with base: 0x%lx.", (long int) base);
 
    result = MPI_Win_detach(win.win, base);
    CHECK_ERROR_CODE(result);
-   previous_item = NULL;
-   current_item = win.modifiable_values->memory_areas;
-   while (current_item != NULL) {
-      if (current_item->base == base) {
-         if (previous_item == NULL) {
-            win.modifiable_values->memory_areas = current_item->next;
-         } else {
-            previous_item->next = current_item->next;
-         }
-         free(current_item);
-         mpi_log_debug("Memory area with base: 0x%lx detached.", (long int) base);
-         return MPI_SUCCESS;
-      } else {
-         previous_item = current_item;
-         current_item = current_item->next;
-      }
+   list_item = remove_memory_area(win, base);
+   if (list_item != NULL) {
+      free(list_item);
+      mpi_log_debug("Memory area with base: 0x%lx detached.", (long int) base);
+      return MPI_SUCCESS;
    }
    mpi_log_error("Memory area with base: 0x%lx not found on list of attached memories.");
-   MPI_Win_call_errhandler(win.win, MPI_ERR_ARG);
+   call_win_errhandler(win.win, MPI_ERR_ARG);
    return MPI_ERR_ARG;
 }
 
 int MPI_Win_free_pmem(MPI_Win_pmem *win) {
-   int result;
-   MPI_Win_memory_areas_list *current_item, *next_item;
+   int result, rank;
    char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME];
 
    mpi_log_debug("Freeing window.");
 
+   // Window data can't be freed before checkpoint written in background is completed.
+   result = complete_pending_checkpoint(*win, true);
+   CHECK_ERROR_CODE(result);
+   free_copy_pool(win->modifiable_values->copy_pool);
+   win->modifiable_values->copy_pool = NULL;
+   free_checkpoint_throttle(win->modifiable_values->throttle);
+   win->modifiable_values->throttle = NULL;
+   free_checkpoint_aggregator(win->modifiable_values->aggregator);
+   win->modifiable_values->aggregator = NULL;
+   close_checkpoint_slots(win->modifiable_values->slot_ring);
+   win->modifiable_values->slot_ring = NULL;
+   result = close_window_versions(*win);
+   CHECK_ERROR_CODE(result);
+
    result = MPI_Win_free(&win->win);
    CHECK_ERROR_CODE(result);
 
    // If allocated via MPI_Win_allocate unmap memory and delete file if set as volatile.
-   if (win->created_via_allocate) {
+   if (win->created_via_allocate && win->modifiable_values->shared_base != NULL) {
+      result = unmap_shared_window(*win);
+      CHECK_ERROR_CODE(result);
+      // Data file of shared window is placed in root path of process with rank 0.
+      MPI_Comm_rank(win->comm, &rank);
+      if (win->is_volatile && rank == 0) {
+         sprintf(file_name, "%s/%s", mpi_pmem_root_path, win->name);
+         mpi_log_debug("Deleting file: %s", file_name);
+         if (!reclaim_file(mpi_pmem_root_path, file_name)) {
+            mpi_log_error("Unable to delete file '%s'.", file_name);
+            call_comm_errhandler(win->comm, MPI_ERR_PMEM);
+            return MPI_ERR_PMEM;
+         }
+      }
+   } else if (win->created_via_allocate) {
       if (win->allocate_in_ram) {
          mpi_log_debug("Freeing memory area base: 0x%lx, size: %lu.", (long int) win->modifiable_values->memory_areas->base, win->modifiable_values->memory_areas->size);
-         free(win->modifiable_values->memory_areas->base);
+         if (win->modifiable_values->lazy_restore != NULL) {
+            free_lazy_restore(win->modifiable_values->lazy_restore);
+         } else {
+            free(win->modifiable_values->memory_areas->base);
+         }
       } else {
          mpi_log_debug("Unmapping memory area base: 0x%lx, size: %lu.", (long int) win->modifiable_values->memory_areas->base, win->modifiable_values->memory_areas->size);
-         result = unmap_pmem_file(win->comm, win->modifiable_values->memory_areas->base, win->modifiable_values->memory_areas->size);
+         if (win->stripe_size > 0) {
+            result = unmap_striped_pmem_file(win->comm, win->modifiable_values->memory_areas->base, win->modifiable_values->memory_areas->size, win->stripe_size);
+         } else {
+            result = unmap_pmem_file(win->comm, win->modifiable_values->memory_areas->base, win->modifiable_values->memory_areas->size);
+         }
          CHECK_ERROR_CODE(result);
+         if (win->is_volatile && win->stripe_size > 0) {
+            result = remove_striped_pmem_file(win->comm, win->name, mpi_pmem_root_path_index);
+            CHECK_ERROR_CODE(result);
+         }
          if (win->is_volatile) {
             sprintf(file_name, "%s/%s", mpi_pmem_root_path, win->name);
             mpi_log_debug("Deleting file: %s", file_name);
-            if (remove(file_name) != 0) {
+            if (!reclaim_file(mpi_pmem_root_path, file_name)) {
                mpi_log_error("Unable to delete file '%s'.", file_name);
-               MPI_Comm_call_errhandler(win->comm, MPI_ERR_PMEM);
+               call_comm_errhandler(win->comm, MPI_ERR_PMEM);
                return MPI_ERR_PMEM;
             }
          }
@@ -327,13 +628,11 @@ int MPI_Win_free_pmem(MPI_Win_pmem *win) {
    }
 
    // Clear list of memory areas.
-   current_item = win->modifiable_values->memory_areas;
-   while (current_item != NULL) {
-      next_item = current_item->next;
-      mpi_log_debug("Freeing memory area metadata base: 0x%lx, size: %lu.", (long int) current_item->base, current_item->size);
-      free(current_item);
-      current_item = next_item;
-   }
+   free_memory_areas(*win);
+   free(win->modifiable_values->page_digests);
+   free(win->modifiable_values->delta_reference);
+   free(win->modifiable_values->checkpoint_staging_buffer);
+   free_dirty_tracker(win->modifiable_values->dirty_tracker);
    free(win->modifiable_values);
 
    mpi_log_debug("Window freed.");
@@ -389,14 +688,58 @@ int MPI_Win_get_info_pmem(MPI_Win_pmem win, MPI_Info *info_used) {
    if (win.is_pmem) {
       result = MPI_Info_set(*info_used, "pmem_is_pmem", "true");
       CHECK_ERROR_CODE(result);
+      result = MPI_Info_set(*info_used, "pmem_track_dirty_ranges", win.track_dirty_ranges ? "true" : "false");
+      CHECK_ERROR_CODE(result);
       if (win.created_via_allocate) {
          result = MPI_Info_set(*info_used, "pmem_allocate_in_ram", win.allocate_in_ram ? "true" : "false");
          CHECK_ERROR_CODE(result);
+         result = MPI_Info_set(*info_used, "pmem_map_sync", win.map_sync ? "true" : "false");
+         CHECK_ERROR_CODE(result);
+         result = MPI_Info_set(*info_used, "pmem_prefault", win.prefault ? "true" : "false");
+         CHECK_ERROR_CODE(result);
+         sprintf(checkpoint_version, "%d", win.stripe_size);
+         result = MPI_Info_set(*info_used, "pmem_stripe_size", checkpoint_version);
+         CHECK_ERROR_CODE(result);
          result = MPI_Info_set(*info_used, "pmem_dont_use_transactions", win.modifiable_values->transactional ? "false" : "true");
          CHECK_ERROR_CODE(result);
          if (win.modifiable_values->transactional) {
             result = MPI_Info_set(*info_used, "pmem_keep_all_checkpoints", win.modifiable_values->keep_all_checkpoints ? "true" : "false");
             CHECK_ERROR_CODE(result);
+            result = MPI_Info_set(*info_used, "pmem_checkpoint_async", win.async_checkpoints ? "true" : "false");
+            CHECK_ERROR_CODE(result);
+            result = MPI_Info_set(*info_used, "pmem_checkpoint_incremental", win.incremental_checkpoints ? "true" : "false");
+            CHECK_ERROR_CODE(result);
+            result = MPI_Info_set(*info_used, "pmem_checkpoint_delta", win.delta_checkpoints ? "true" : "false");
+            CHECK_ERROR_CODE(result);
+            sprintf(checkpoint_version, "%d", win.checkpoint_threads);
+            result = MPI_Info_set(*info_used, "pmem_checkpoint_threads", checkpoint_version);
+            CHECK_ERROR_CODE(result);
+            result = MPI_Info_set(*info_used, "pmem_checkpoint_codec", find_codec(win.checkpoint_codec)->name);
+            CHECK_ERROR_CODE(result);
+            result = MPI_Info_set(*info_used, "pmem_checkpoint_dedup", win.dedup_checkpoints ? "true" : "false");
+            CHECK_ERROR_CODE(result);
+            result = MPI_Info_set(*info_used, "pmem_checkpoint_aggregate", win.aggregate_checkpoints ? "true" : "false");
+            CHECK_ERROR_CODE(result);
+            sprintf(checkpoint_version, "%d", win.checkpoint_mtbf);
+            result = MPI_Info_set(*info_used, "pmem_checkpoint_mtbf", checkpoint_version);
+            CHECK_ERROR_CODE(result);
+            sprintf(checkpoint_version, "%d", win.checkpoint_overhead);
+            result = MPI_Info_set(*info_used, "pmem_checkpoint_overhead", checkpoint_version);
+            CHECK_ERROR_CODE(result);
+            sprintf(checkpoint_version, "%d", win.checkpoint_writers);
+            result = MPI_Info_set(*info_used, "pmem_checkpoint_writers", checkpoint_version);
+            CHECK_ERROR_CODE(result);
+            sprintf(checkpoint_version, "%d", win.checkpoint_rate);
+            result = MPI_Info_set(*info_used, "pmem_checkpoint_rate", checkpoint_version);
+            CHECK_ERROR_CODE(result);
+            sprintf(checkpoint_version, "%d", win.checkpoint_slots);
+            result = MPI_Info_set(*info_used, "pmem_checkpoint_slots", checkpoint_version);
+            CHECK_ERROR_CODE(result);
+            if (win.incremental_checkpoints || win.delta_checkpoints) {
+               sprintf(checkpoint_version, "%d", win.full_checkpoint_interval);
+               result = MPI_Info_set(*info_used, "pmem_checkpoint_full_interval", checkpoint_version);
+               CHECK_ERROR_CODE(result);
+            }
          }
          if (win.mode == MPI_PMEM_MODE_CHECKPOINT) {
             sprintf(checkpoint_version, "%d", win.modifiable_values->last_checkpoint_version);
@@ -406,6 +749,12 @@ int MPI_Win_get_info_pmem(MPI_Win_pmem win, MPI_Info *info_used) {
             CHECK_ERROR_CODE(result);
             result = MPI_Info_set(*info_used, "pmem_global_checkpoint", win.global_checkpoint ? "true" : "false");
             CHECK_ERROR_CODE(result);
+            if (win.created_via_allocate) {
+               result = MPI_Info_set(*info_used, "pmem_restore_zero_copy", win.zero_copy_restore ? "true" : "false");
+               CHECK_ERROR_CODE(result);
+               result = MPI_Info_set(*info_used, "pmem_restore_lazy", win.lazy_restore ? "true" : "false");
+               CHECK_ERROR_CODE(result);
+            }
          }
          result = MPI_Info_set(*info_used, "pmem_name", win.name);
          CHECK_ERROR_CODE(result);
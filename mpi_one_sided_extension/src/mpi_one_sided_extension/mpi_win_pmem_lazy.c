@@ -0,0 +1,290 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_lazy.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/userfaultfd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem.h"
+#include "mpi_win_pmem_helper.h"
+
+/**
+ * Fill missing pages of window memory with data from checkpoint file. Pages which are already present are skipped.
+ *
+ * @param lazy_restore  Restore of window memory.
+ * @param offset        Offset of first page (multiple of page size).
+ * @param size          Size of filled range (multiple of page size, at most MPI_PMEM_LAZY_RESTORE_BATCH).
+ *
+ * @returns false if pages can't be filled or checkpoint file is truncated, true otherwise.
+ */
+static bool restore_pages(MPI_Win_pmem_lazy_restore *lazy_restore, uint64_t offset, uint64_t size) {
+   ssize_t bytes_read;
+   uint64_t filled = 0, expected;
+   struct uffdio_copy copy;
+
+   // Only part of last page behind end of window is filled with zeros, checkpoint file shorter than window is corrupted.
+   expected = offset >= lazy_restore->data_size ? 0 : lazy_restore->data_size - offset < size ? lazy_restore->data_size - offset : size;
+   bytes_read = pread(lazy_restore->checkpoint_fd, lazy_restore->buffer, size, offset);
+   if (bytes_read < 0 || (uint64_t) bytes_read < expected) {
+      return false;
+   }
+   memset(lazy_restore->buffer + bytes_read, 0, size - bytes_read);
+
+   while (filled < size) {
+      copy.dst = (uintptr_t) lazy_restore->base + offset + filled;
+      copy.src = (uintptr_t) lazy_restore->buffer + filled;
+      copy.len = size - filled;
+      copy.mode = 0;
+      copy.copy = 0;
+      if (ioctl(lazy_restore->uffd, UFFDIO_COPY, &copy) == 0) {
+         break;
+      }
+      // Copy stops at page which is already present (e.g. restored on fault), it is skipped.
+      if (copy.copy > 0) {
+         filled += copy.copy;
+      } else if (errno == EEXIST) {
+         filled += lazy_restore->page_size;
+      } else if (errno != EAGAIN) {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+/**
+ * Main function of thread restoring window memory. Page faults are served first, remaining pages are prefetched when there is no pending fault.
+ *
+ * @param argument  Restore of window memory.
+ *
+ * @returns Always NULL.
+ */
+static void *lazy_restore_worker(void *argument) {
+   MPI_Win_pmem_lazy_restore *lazy_restore = argument;
+   struct pollfd descriptors[2];
+   struct uffd_msg message;
+   uint64_t next_offset = 0, offset, size;
+   int ready;
+
+   descriptors[0].fd = lazy_restore->uffd;
+   descriptors[0].events = POLLIN;
+   descriptors[1].fd = lazy_restore->stop_fd;
+   descriptors[1].events = POLLIN;
+   while (true) {
+      ready = poll(descriptors, 2, next_offset < lazy_restore->size ? 0 : -1);
+      if (ready < 0 && errno == EINTR) {
+         continue;
+      }
+      if (ready < 0 || (descriptors[1].revents & POLLIN)) {
+         break;
+      }
+      if (ready > 0 && (descriptors[0].revents & POLLIN)) {
+         if (read(lazy_restore->uffd, &message, sizeof(message)) == sizeof(message) && message.event == UFFD_EVENT_PAGEFAULT) {
+            offset = (message.arg.pagefault.address - (uintptr_t) lazy_restore->base) & ~(lazy_restore->page_size - 1);
+            if (!restore_pages(lazy_restore, offset, lazy_restore->page_size)) {
+               break;
+            }
+         }
+      } else if (next_offset < lazy_restore->size) {
+         size = lazy_restore->size - next_offset < MPI_PMEM_LAZY_RESTORE_BATCH ? lazy_restore->size - next_offset : MPI_PMEM_LAZY_RESTORE_BATCH;
+         if (!restore_pages(lazy_restore, next_offset, size)) {
+            break;
+         }
+         next_offset += size;
+         if (next_offset == lazy_restore->size) {
+            mpi_log_debug("Window memory restored from checkpoint.");
+         }
+      }
+   }
+
+   // Faults which can't be served any more are resolved with zero pages instead of blocking forever. Failure is reported by next operation on window.
+   if (next_offset < lazy_restore->size && !(descriptors[1].revents & POLLIN)) {
+      mpi_log_error("Unable to restore window memory from checkpoint.");
+      __atomic_store_n(&lazy_restore->failed, true, __ATOMIC_RELEASE);
+      struct uffdio_range range = {(uintptr_t) lazy_restore->base, lazy_restore->size};
+      ioctl(lazy_restore->uffd, UFFDIO_UNREGISTER, &range);
+   }
+
+   return NULL;
+}
+
+/**
+ * Check whether last checkpoint of window contains plain copy of window and open it.
+ *
+ * @param win            Window object.
+ * @param checkpoint_fd  Output variable for descriptor of checkpoint file (-1 if checkpoint doesn't contain plain copy of window).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int open_plain_checkpoint(MPI_Win_pmem win, int *checkpoint_fd) {
+   int result;
+   MPI_Win_pmem_version *versions;
+   int version = win.modifiable_values->last_checkpoint_version;
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 14];
+
+   *checkpoint_fd = -1;
+   if (version < 0) {
+      return MPI_SUCCESS;
+   }
+   result = open_window_versions(win, &versions);
+   CHECK_ERROR_CODE(result);
+   if ((off_t) ((version + 1) * sizeof(MPI_Win_pmem_version)) >= win.modifiable_values->versions_file_size || versions[version].flags != MPI_PMEM_FLAG_OBJECT_EXISTS ||
+       versions[version].format != MPI_PMEM_CHECKPOINT_FULL || versions[version].codec != MPI_PMEM_CODEC_NONE) {
+      mpi_log_debug("Checkpoint version %d of window '%s' can't be restored lazily, it will be copied.", version, win.name);
+      return MPI_SUCCESS;
+   }
+   sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, win.name, version);
+   if ((*checkpoint_fd = open(file_name, O_RDONLY)) < 0) {
+      mpi_log_error("Checkpoint file '%s' doesn't exist.", file_name);
+      call_comm_errhandler(win.comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   return MPI_SUCCESS;
+}
+
+int start_lazy_restore(MPI_Win_pmem win, MPI_Aint size, void **address, bool *started) {
+   int result, checkpoint_fd;
+   struct uffdio_api api;
+   struct uffdio_register registration;
+   MPI_Win_pmem_lazy_restore *lazy_restore;
+
+   *started = false;
+   result = open_plain_checkpoint(win, &checkpoint_fd);
+   CHECK_ERROR_CODE(result);
+   if (checkpoint_fd < 0) {
+      return MPI_SUCCESS;
+   }
+
+   lazy_restore = malloc(sizeof(MPI_Win_pmem_lazy_restore));
+   if (lazy_restore != NULL) {
+      lazy_restore->buffer = malloc(MPI_PMEM_LAZY_RESTORE_BATCH);
+   }
+   if (lazy_restore == NULL || lazy_restore->buffer == NULL) {
+      free(lazy_restore);
+      close(checkpoint_fd);
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(win.comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   lazy_restore->checkpoint_fd = checkpoint_fd;
+   lazy_restore->page_size = (uint64_t) sysconf(_SC_PAGESIZE);
+   lazy_restore->size = ((uint64_t) size + lazy_restore->page_size - 1) & ~(lazy_restore->page_size - 1);
+   lazy_restore->data_size = (uint64_t) size;
+   lazy_restore->version = win.modifiable_values->last_checkpoint_version;
+   lazy_restore->failed = false;
+   lazy_restore->stop_fd = -1;
+   lazy_restore->base = MAP_FAILED;
+
+   // Userfaultfd may be unavailable (old kernel, missing privileges), window is restored by copying then.
+   lazy_restore->uffd = syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+   api.api = UFFD_API;
+   api.features = 0;
+   if (lazy_restore->uffd < 0 || ioctl(lazy_restore->uffd, UFFDIO_API, &api) != 0) {
+      mpi_log_debug("Userfaultfd not available, checkpoint will be copied.");
+      free_lazy_restore(lazy_restore);
+      return MPI_SUCCESS;
+   }
+   lazy_restore->base = mmap(NULL, lazy_restore->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (lazy_restore->base == MAP_FAILED) {
+      free_lazy_restore(lazy_restore);
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(win.comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   registration.range.start = (uintptr_t) lazy_restore->base;
+   registration.range.len = lazy_restore->size;
+   registration.mode = UFFDIO_REGISTER_MODE_MISSING;
+   if (ioctl(lazy_restore->uffd, UFFDIO_REGISTER, &registration) != 0 || (lazy_restore->stop_fd = eventfd(0, EFD_CLOEXEC)) < 0 ||
+       pthread_create(&lazy_restore->thread, NULL, lazy_restore_worker, lazy_restore) != 0) {
+      mpi_log_debug("Unable to register window memory with userfaultfd, checkpoint will be copied.");
+      if (lazy_restore->stop_fd >= 0) {
+         close(lazy_restore->stop_fd);
+         lazy_restore->stop_fd = -1;
+      }
+      free_lazy_restore(lazy_restore);
+      return MPI_SUCCESS;
+   }
+
+   mpi_log_debug("Restoring checkpoint version %d of window '%s' on demand.", win.modifiable_values->last_checkpoint_version, win.name);
+   win.modifiable_values->lazy_restore = lazy_restore;
+   *address = lazy_restore->base;
+   *started = true;
+
+   return MPI_SUCCESS;
+}
+
+int check_lazy_restore(MPI_Win_pmem win) {
+   MPI_Win_pmem_lazy_restore *lazy_restore = win.modifiable_values->lazy_restore;
+
+   if (lazy_restore != NULL && __atomic_load_n(&lazy_restore->failed, __ATOMIC_ACQUIRE)) {
+      mpi_log_error("Memory of window '%s' wasn't restored from checkpoint version %d.", win.name, lazy_restore->version);
+      call_win_errhandler(win.win, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   return MPI_SUCCESS;
+}
+
+void free_lazy_restore(MPI_Win_pmem_lazy_restore *lazy_restore) {
+   uint64_t stop = 1;
+
+   if (lazy_restore == NULL) {
+      return;
+   }
+
+   // Thread is running only if stop descriptor was created.
+   if (lazy_restore->stop_fd >= 0) {
+      if (write(lazy_restore->stop_fd, &stop, sizeof(stop)) != sizeof(stop)) {
+         mpi_log_error("Unable to stop thread restoring window memory.");
+      }
+      pthread_join(lazy_restore->thread, NULL);
+      close(lazy_restore->stop_fd);
+   }
+   if (lazy_restore->base != MAP_FAILED) {
+      munmap(lazy_restore->base, lazy_restore->size);
+   }
+   if (lazy_restore->uffd >= 0) {
+      close(lazy_restore->uffd);
+   }
+   close(lazy_restore->checkpoint_fd);
+   free(lazy_restore->buffer);
+   free(lazy_restore);
+}
@@ -0,0 +1,94 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_LAZY_H__
+#define __MPI_WIN_PMEM_LAZY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <mpi.h>
+#include "mpi_win_pmem_datatypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MPI_PMEM_LAZY_RESTORE_BATCH (1024 * 1024)  // Size of data prefetched at once when there is no pending page fault.
+
+// Restore of window memory on demand. Memory is registered with userfaultfd and pages are filled from checkpoint file by background thread when they are
+// touched for the first time, pages which aren't touched are prefetched in order of addresses.
+struct MPI_Win_pmem_lazy_restore_structure {
+   char *base;          // Window memory (anonymous mapping).
+   uint64_t size;       // Size of window memory rounded up to pages.
+   uint64_t data_size;  // Size of window (and of checkpoint file).
+   uint64_t page_size;
+   int uffd;            // Userfaultfd file descriptor.
+   int checkpoint_fd;   // Checkpoint file containing plain copy of window.
+   int version;         // Restored checkpoint version.
+   int stop_fd;         // Eventfd used to stop background thread.
+   char *buffer;        // Data read from checkpoint file before it is copied into window memory.
+   pthread_t thread;
+   bool failed;         // Set by background thread when pages can't be restored, memory which wasn't restored contains zeros then.
+};
+
+/**
+ * Allocate window memory in RAM and start restoring it from last checkpoint on demand. Restore is started only if last checkpoint contains plain copy of
+ * window and userfaultfd can be used, otherwise memory isn't allocated and window has to be restored by copy_data_from_checkpoint.
+ *
+ * @param win      Window object.
+ * @param size     Size of window.
+ * @param address  Output variable for address of window memory.
+ * @param started  Output variable for flag specifying whether restore was started.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int start_lazy_restore(MPI_Win_pmem win, MPI_Aint size, void **address, bool *started);
+
+/**
+ * Check whether window memory was restored successfully (or is still being restored). Window whose restore failed contains zeros instead of checkpoint data,
+ * so it must not be persisted nor checkpointed.
+ *
+ * @param win  Window object.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int check_lazy_restore(MPI_Win_pmem win);
+
+/**
+ * Stop restoring window memory and free it.
+ *
+ * @param lazy_restore  Restore started by start_lazy_restore (may be NULL).
+ */
+void free_lazy_restore(MPI_Win_pmem_lazy_restore *lazy_restore);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
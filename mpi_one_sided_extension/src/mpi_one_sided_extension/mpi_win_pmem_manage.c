@@ -32,9 +32,19 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <string.h>
 #include <sys/stat.h>
 #include "../common/logger.h"
+#include "../common/util.h"
 #include "mpi_win_pmem_helper.h"
+#include "mpi_win_pmem_incremental.h"
+#include "mpi_win_pmem_chunks.h"
+#include "mpi_win_pmem_index.h"
+#include "mpi_win_pmem_aggregate.h"
+#include "mpi_win_pmem_numa.h"
+#include "mpi_win_pmem_reclaim.h"
 
 char mpi_pmem_root_path[MPI_PMEM_MAX_ROOT_PATH];
+char mpi_pmem_root_paths[MPI_PMEM_MAX_ROOT_PATHS][MPI_PMEM_MAX_ROOT_PATH];
+int mpi_pmem_root_paths_count = 0;
+int mpi_pmem_root_path_index = 0;
 
 /**
  * Check if MPI_Win_pmem_windows structure contains windows array.
@@ -46,7 +56,7 @@ char mpi_pmem_root_path[MPI_PMEM_MAX_ROOT_PATH];
 int check_windows_structure(MPI_Win_pmem_windows windows) {
    if (windows.windows == NULL) {
       mpi_log_error("No windows data in windows structure.");
-      MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_WINDOWS);
+      call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_WINDOWS);
       return MPI_ERR_PMEM_WINDOWS;
    }
    return MPI_SUCCESS;
@@ -63,7 +73,7 @@ int check_windows_structure(MPI_Win_pmem_windows windows) {
 int check_index_in_windows_structure(MPI_Win_pmem_windows windows, int n) {
    if (n < 0 || n >= windows.size) {
       mpi_log_error("Invalid index %d in windows. Number of windows is %d.", n, windows.size);
-      MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_ARG);
+      call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_ARG);
       return MPI_ERR_PMEM_ARG;
    }
    return MPI_SUCCESS;
@@ -79,7 +89,7 @@ int check_index_in_windows_structure(MPI_Win_pmem_windows windows, int n) {
 int check_versions_structure(MPI_Win_pmem_versions versions) {
    if (versions.versions == NULL) {
       mpi_log_error("No versions data in versions structure.");
-      MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_VERSIONS);
+      call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_VERSIONS);
       return MPI_ERR_PMEM_VERSIONS;
    }
    return MPI_SUCCESS;
@@ -96,7 +106,7 @@ int check_versions_structure(MPI_Win_pmem_versions versions) {
 int check_index_in_versions_structure(MPI_Win_pmem_versions versions, int n) {
    if (n < 0 || n >= versions.size) {
       mpi_log_error("Invalid index %d in versions. Number of versions is %d.", n, versions.size);
-      MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_ARG);
+      call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_ARG);
       return MPI_ERR_PMEM_ARG;
    }
    return MPI_SUCCESS;
@@ -112,7 +122,7 @@ int MPI_Win_pmem_set_root_path(const char *path) {
    // Check if path is not too long.
    if (strlen(path) + 1 > MPI_PMEM_MAX_ROOT_PATH) {
       mpi_log_error("Root path too long.");
-      MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_ROOT_PATH);
+      call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_ROOT_PATH);
       return MPI_ERR_PMEM_ROOT_PATH;
    }
 
@@ -120,7 +130,7 @@ int MPI_Win_pmem_set_root_path(const char *path) {
    struct stat file_status;
    if (stat(path, &file_status) != 0 || !S_ISDIR(file_status.st_mode)) {
       mpi_log_error("Root path either doesn't exist or isn't a directory.");
-      MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_ROOT_PATH);
+      call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_ROOT_PATH);
       return MPI_ERR_PMEM_ROOT_PATH;
    }
 
@@ -141,13 +151,56 @@ int MPI_Win_pmem_set_root_path(const char *path) {
       mpi_log_debug("Metadata file '%s' created.", metadata_file_name);
    }
 
+   // Files deleted by crashed process may still be waiting to be unlinked.
+   result = recover_reclaimed_files(MPI_COMM_WORLD, path);
+   CHECK_ERROR_CODE(result);
+
    strcpy(mpi_pmem_root_path, path);
+   strcpy(mpi_pmem_root_paths[0], path);
+   mpi_pmem_root_paths_count = 1;
+   mpi_pmem_root_path_index = 0;
 
    mpi_log_debug("Root path set to: %s", mpi_pmem_root_path);
 
    return MPI_SUCCESS;
 }
 
+int MPI_Win_pmem_set_root_paths(int count, const char *paths[]) {
+   int result, i, local_index;
+   struct stat file_status;
+
+   if (count < 1 || count > MPI_PMEM_MAX_ROOT_PATHS) {
+      mpi_log_error("Invalid number of root paths %d.", count);
+      call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_ARG);
+      return MPI_ERR_PMEM_ARG;
+   }
+   for (i = 0; i < count; i++) {
+      if (strlen(paths[i]) + 1 > MPI_PMEM_MAX_ROOT_PATH || stat(paths[i], &file_status) != 0 || !S_ISDIR(file_status.st_mode)) {
+         mpi_log_error("Root path '%s' is either too long, doesn't exist or isn't a directory.", paths[i]);
+         call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_ROOT_PATH);
+         return MPI_ERR_PMEM_ROOT_PATH;
+      }
+   }
+
+   // Windows and checkpoints are placed in persistent memory of NUMA node on which process is running.
+   local_index = current_numa_node() % count;
+   result = MPI_Win_pmem_set_root_path(paths[local_index]);
+   CHECK_ERROR_CODE(result);
+   for (i = 0; i < count; i++) {
+      strcpy(mpi_pmem_root_paths[i], paths[i]);
+      if (i != local_index) {
+         result = recover_reclaimed_files(MPI_COMM_WORLD, paths[i]);
+         CHECK_ERROR_CODE(result);
+      }
+   }
+   mpi_pmem_root_paths_count = count;
+   mpi_pmem_root_path_index = local_index;
+
+   mpi_log_debug("Root path %d of %d is local to NUMA node of process.", local_index, count);
+
+   return MPI_SUCCESS;
+}
+
 int MPI_Win_pmem_list(MPI_Win_pmem_windows *windows) {
    int result, i, j, window_count;
    MPI_Win_pmem_metadata *metadata;
@@ -169,7 +222,7 @@ int MPI_Win_pmem_list(MPI_Win_pmem_windows *windows) {
    windows->windows = malloc(window_count * sizeof(MPI_Win_pmem_window));
    if (windows->windows == NULL) {
       mpi_log_error("Unable to allocate memory.");
-      MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_NO_MEM);
+      call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_NO_MEM);
       return MPI_ERR_PMEM_NO_MEM;
    }
    j = 0;
@@ -257,7 +310,7 @@ int MPI_Win_pmem_get_versions(MPI_Win_pmem_windows windows, int n, MPI_Win_pmem_
    versions->versions = malloc(versions_count * sizeof(MPI_Win_pmem_window));
    if (versions->versions == NULL) {
       mpi_log_error("Unable to allocate memory.");
-      MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_NO_MEM);
+      call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_NO_MEM);
       return MPI_ERR_PMEM_NO_MEM;
    }
    j = 0;
@@ -321,97 +374,94 @@ int MPI_Win_pmem_get_version_timestamp(MPI_Win_pmem_versions versions, int n, ti
 int MPI_Win_pmem_delete(const char *name) {
    int result, i;
    char *file_name;
-   MPI_Win_pmem_metadata *windows;
+   MPI_Win_pmem_windows_index index;
    MPI_Win_pmem_version *versions;
-   off_t metadata_file_size, file_size;
+   off_t file_size;
 
-   result = open_windows_metadata_file(MPI_COMM_WORLD, &windows, &metadata_file_size);
+   result = open_windows_index(MPI_COMM_WORLD, &index);
    CHECK_ERROR_CODE(result);
-   for (i = 0; windows[i].flags != MPI_PMEM_FLAG_NO_OBJECT; i++) {
-      if (strcmp(name, windows[i].name) == 0) {
-         // Check if window is already deleted.
-         if (windows[i].flags == MPI_PMEM_FLAG_OBJECT_DELETED) {
-            mpi_log_debug("Window '%s' already deleted.", name);
-            result = unmap_pmem_file(MPI_COMM_WORLD, windows, metadata_file_size);
-            CHECK_ERROR_CODE(result);
-            return MPI_SUCCESS;
-         }
-         
-         // Delete old versions.
-         result = open_versions_metadata_file(MPI_COMM_WORLD, name, &versions, &file_size);
-         CHECK_ERROR_CODE(result);
-         result = delete_old_checkpoints(MPI_COMM_WORLD, name, versions);
-         CHECK_ERROR_CODE(result);
-         result = unmap_pmem_file(MPI_COMM_WORLD, versions, file_size);
-         CHECK_ERROR_CODE(result);
-
-         // Set window status to deleted in global metadata file.
-         windows[i].flags = MPI_PMEM_FLAG_OBJECT_DELETED;
-         result = persist_pmem_file(MPI_COMM_WORLD, &windows[i].flags, sizeof(char));
+   i = find_window_record(&index, name);
+   if (i >= 0) {
+      // Check if window is already deleted.
+      if (index.windows[i].flags == MPI_PMEM_FLAG_OBJECT_DELETED) {
+         mpi_log_debug("Window '%s' already deleted.", name);
+         result = close_windows_index(MPI_COMM_WORLD, &index);
          CHECK_ERROR_CODE(result);
-         
-         // Remove metadata file.
-         file_name = malloc((strlen(mpi_pmem_root_path) + strlen(name) + 3) * sizeof(char)); // Additional 3 characters for: "/." and terminating zero.
-         if (file_name == NULL) {
-            mpi_log_error("Unable to allocate memory.");
-            MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_NO_MEM);
-            return MPI_ERR_PMEM_NO_MEM;
-         }
-         sprintf(file_name, "%s/.%s", mpi_pmem_root_path, name);
-         if (remove(file_name) != 0) {
-            mpi_log_error("Unable to delete file '%s'.", file_name);
-            MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM);
-            return MPI_ERR_PMEM;
-         }
+         return MPI_SUCCESS;
+      }
+      
+      // Delete old versions.
+      result = open_versions_metadata_file(MPI_COMM_WORLD, name, &versions, &file_size);
+      CHECK_ERROR_CODE(result);
+      result = delete_old_checkpoints(MPI_COMM_WORLD, name, versions);
+      CHECK_ERROR_CODE(result);
+      result = unmap_pmem_file(MPI_COMM_WORLD, versions, file_size);
+      CHECK_ERROR_CODE(result);
 
-         // Remove data file.
-         sprintf(file_name, "%s/%s", mpi_pmem_root_path, name);
-         if (remove(file_name) != 0) {
-            mpi_log_error("Unable to delete file '%s'.", file_name);
-            MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM);
-            return MPI_ERR_PMEM;
-         }
-         free(file_name);
+      // Set window status to deleted in global metadata file.
+      index.windows[i].flags = MPI_PMEM_FLAG_OBJECT_DELETED;
+      result = persist_pmem_file(MPI_COMM_WORLD, &index.windows[i].flags, sizeof(char));
+      CHECK_ERROR_CODE(result);
+      
+      // Remove metadata file.
+      file_name = malloc((strlen(mpi_pmem_root_path) + strlen(name) + 3) * sizeof(char)); // Additional 3 characters for: "/." and terminating zero.
+      if (file_name == NULL) {
+         mpi_log_error("Unable to allocate memory.");
+         call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_NO_MEM);
+         return MPI_ERR_PMEM_NO_MEM;
+      }
+      sprintf(file_name, "%s/.%s", mpi_pmem_root_path, name);
+      if (remove(file_name) != 0) {
+         mpi_log_error("Unable to delete file '%s'.", file_name);
+         call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM);
+         return MPI_ERR_PMEM;
+      }
 
-         result = unmap_pmem_file(MPI_COMM_WORLD, windows, metadata_file_size);
+      // Remove data file and its parts placed in other root paths.
+      sprintf(file_name, "%s/%s", mpi_pmem_root_path, name);
+      if (!reclaim_file(mpi_pmem_root_path, file_name)) {
+         mpi_log_error("Unable to delete file '%s'.", file_name);
+         call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM);
+         return MPI_ERR_PMEM;
+      }
+      free(file_name);
+      if (index.windows[i].stripe_root_path > 0) {
+         result = remove_striped_pmem_file(MPI_COMM_WORLD, name, index.windows[i].stripe_root_path - 1);
          CHECK_ERROR_CODE(result);
-         mpi_log_debug("Window '%s' successfully deleted.", name);
-         return MPI_SUCCESS;
       }
+
+      result = close_windows_index(MPI_COMM_WORLD, &index);
+      CHECK_ERROR_CODE(result);
+      mpi_log_debug("Window '%s' successfully deleted.", name);
+      return MPI_SUCCESS;
    }
 
-   result = unmap_pmem_file(MPI_COMM_WORLD, windows, metadata_file_size);
+   result = close_windows_index(MPI_COMM_WORLD, &index);
    CHECK_ERROR_CODE(result);
    mpi_log_error("Window '%s' not found.", name);
-   MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_NAME);
+   call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_NAME);
    return MPI_ERR_PMEM_NAME;
 }
 
 int MPI_Win_pmem_delete_version(const char *name, int version) {
-   int result, i;
-   MPI_Win_pmem_metadata *windows;
+   int result, i, j, node_version;
+   char format;
+   MPI_Win_pmem_windows_index index;
    MPI_Win_pmem_version *versions;
    off_t file_size;
    bool found;
    char *file_name;
 
    // Check in global metadata file if window exists.
-   result = open_windows_metadata_file(MPI_COMM_WORLD, &windows, &file_size);
+   result = open_windows_index(MPI_COMM_WORLD, &index);
    CHECK_ERROR_CODE(result);
-   found = false;
-   for (i = 0; windows[i].flags != MPI_PMEM_FLAG_NO_OBJECT; i++) {
-      if (strcmp(windows[i].name, name) == 0) {
-         if (windows[i].flags == MPI_PMEM_FLAG_OBJECT_EXISTS) {
-            found = true;
-         }
-         break;
-      }
-   }
-   result = unmap_pmem_file(MPI_COMM_WORLD, windows, file_size);
+   i = find_window_record(&index, name);
+   found = i >= 0 && index.windows[i].flags == MPI_PMEM_FLAG_OBJECT_EXISTS;
+   result = close_windows_index(MPI_COMM_WORLD, &index);
    CHECK_ERROR_CODE(result);
    if (!found) {
       mpi_log_error("Window '%s' not found.", name);
-      MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_NAME);
+      call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_NAME);
       return MPI_ERR_PMEM_NAME;
    }
 
@@ -428,25 +478,54 @@ int MPI_Win_pmem_delete_version(const char *name, int version) {
             return MPI_SUCCESS;
          }
 
+         // Check if other existing checkpoints are incremental checkpoints based on this version.
+         for (j = i + 1; versions[j].flags != MPI_PMEM_FLAG_NO_OBJECT; j++) {
+            if (versions[j].flags == MPI_PMEM_FLAG_OBJECT_EXISTS && checkpoint_depends_on(versions, j, i)) {
+               mpi_log_error("Version %d of window '%s' is needed by incremental checkpoint version %d.", version, name, j);
+               result = unmap_pmem_file(MPI_COMM_WORLD, versions, file_size);
+               CHECK_ERROR_CODE(result);
+               call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_CKPT_VER);
+               return MPI_ERR_PMEM_CKPT_VER;
+            }
+         }
+
+         // Global epoch record can't point to deleted version.
+         result = invalidate_global_checkpoint_version(MPI_COMM_WORLD, name, version);
+         CHECK_ERROR_CODE(result);
+
          // Set window's version flag to deleted.
          versions[i].flags = MPI_PMEM_FLAG_OBJECT_DELETED;
          result = persist_pmem_file(MPI_COMM_WORLD, &versions[i].flags, sizeof(char));
          CHECK_ERROR_CODE(result);
+         format = versions[i].format;
+         node_version = versions[i].parent_version;
          result = unmap_pmem_file(MPI_COMM_WORLD, versions, file_size);
          CHECK_ERROR_CODE(result);
+         if (format == MPI_PMEM_CHECKPOINT_AGGREGATED) {
+            remove_aggregated_checkpoint(name, node_version);
+            mpi_log_debug("Version %d of window '%s' successfully deleted.", version, name);
+            return MPI_SUCCESS;
+         }
+         // Slot file is kept, so it can be reused by next checkpoints of window.
+         if (format == MPI_PMEM_CHECKPOINT_SLOT) {
+            mpi_log_debug("Version %d of window '%s' successfully deleted.", version, name);
+            return MPI_SUCCESS;
+         }
 
          // Delete checkpoint data file.
          // Additional 14 characters for: "/.", "-", 10 characters for checkpoint number (length of maximum 4 byte integer number written in decimal form is 10 characters) and terminating zero.
          file_name = malloc((strlen(mpi_pmem_root_path) + strlen(name) + 14) * sizeof(char));
          if (file_name == NULL) {
             mpi_log_error("Unable to allocate memory.");
-            MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_NO_MEM);
+            call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_NO_MEM);
             return MPI_ERR_PMEM_NO_MEM;
          }
          sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, name, version);
-         if (remove(file_name) != 0) {
+         result = release_checkpoint_chunks(MPI_COMM_WORLD, file_name, format);
+         CHECK_ERROR_CODE(result);
+         if (!reclaim_file(mpi_pmem_root_path, file_name)) {
             mpi_log_error("Unable to delete file '%s'.", file_name);
-            MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM);
+            call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM);
             return MPI_ERR_PMEM;
          }
          free(file_name);
@@ -456,6 +535,6 @@ int MPI_Win_pmem_delete_version(const char *name, int version) {
    }
 
    mpi_log_error("Version %d of window '%s' not found.", version, name);
-   MPI_Comm_call_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_CKPT_VER);
+   call_comm_errhandler(MPI_COMM_WORLD, MPI_ERR_PMEM_CKPT_VER);
    return MPI_ERR_PMEM_CKPT_VER;
 }
@@ -42,6 +42,17 @@ extern "C" {
  */
 int MPI_Win_pmem_set_root_path(const char *path);
 
+/**
+ * Set root paths placed in persistent memory of different NUMA nodes (e.g. namespaces of different sockets). Path local to NUMA node of CPU to which process
+ * is bound becomes root path containing application's memory windows, windows allocated with pmem_stripe_size info key are striped over all paths.
+ *
+ * @param count  Number of paths.
+ * @param paths  Filesystem paths to directories, path with index i is used by processes running on NUMA node i (modulo number of paths).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int MPI_Win_pmem_set_root_paths(int count, const char *paths[]);
+
 /**
  * Creates MPI_Win_pmem_windows opaque object containing list of available windows. Created windows object should be freed using MPI_Win_pmem_free_windows_list.
  *
@@ -154,7 +165,7 @@ int MPI_Win_pmem_get_version_timestamp(MPI_Win_pmem_versions versions, int n, ti
 int MPI_Win_pmem_delete(const char *name);
 
 /**
- * Deletes specified version of window with specified name.
+ * Deletes specified version of window with specified name. Version which is a base of existing incremental checkpoint can't be deleted.
  *
  * @param name    Name of the window.
  * @param version Version of window to delete.
@@ -0,0 +1,159 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_numa.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem.h"
+#include "mpi_win_pmem_helper.h"
+#include "mpi_win_pmem_reclaim.h"
+
+int current_numa_node(void) {
+   int cpu, node = 0;
+   char directory_name[64];
+   DIR *directory;
+   struct dirent *entry;
+
+   cpu = sched_getcpu();
+   if (cpu < 0) {
+      return 0;
+   }
+   // Directory of CPU contains link named node<n> pointing to its NUMA node.
+   sprintf(directory_name, "/sys/devices/system/cpu/cpu%d", cpu);
+   directory = opendir(directory_name);
+   if (directory == NULL) {
+      return 0;
+   }
+   while ((entry = readdir(directory)) != NULL) {
+      if (strncmp(entry->d_name, "node", 4) == 0 && sscanf(entry->d_name + 4, "%d", &node) == 1) {
+         break;
+      }
+   }
+   closedir(directory);
+
+   return node >= 0 ? node : 0;
+}
+
+/**
+ * Get name of part of window's data file placed in specified root path.
+ *
+ * @param name             Name of window.
+ * @param root_path_index  Index of root path local to process which created data file.
+ * @param i                Position of root path counting from local root path.
+ * @param file_name        Output variable for file name.
+ */
+static void get_stripe_file_name(const char *name, int root_path_index, int i, char *file_name) {
+   if (i == 0) {
+      sprintf(file_name, "%s/%s", mpi_pmem_root_path, name);
+   } else {
+      sprintf(file_name, "%s/.%s-stripe-%d", mpi_pmem_root_paths[(root_path_index + i) % mpi_pmem_root_paths_count], name, root_path_index);
+   }
+}
+
+int open_striped_pmem_file(MPI_Comm comm, const char *name, MPI_Aint size, MPI_Aint stripe_size, void **address) {
+   int i, fd;
+   MPI_Aint stripes, stripe, path_stripes;
+   char *base;
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 20];
+
+   stripes = size > 0 ? (size + stripe_size - 1) / stripe_size : 1;
+   // Reserve address range first, so stripes mapped from different files form contiguous memory.
+   base = mmap(NULL, stripes * stripe_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+   if (base == MAP_FAILED) {
+      mpi_log_error("Unable to reserve %lu bytes of address space.", stripes * stripe_size);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+
+   for (i = 0; i < mpi_pmem_root_paths_count && i < stripes; i++) {
+      path_stripes = (stripes - i + mpi_pmem_root_paths_count - 1) / mpi_pmem_root_paths_count;
+      get_stripe_file_name(name, mpi_pmem_root_path_index, i, file_name);
+      if ((fd = open(file_name, O_CREAT | O_RDWR, 0666)) < 0) {
+         mpi_log_error("Unable to open file '%s'.", file_name);
+         munmap(base, stripes * stripe_size);
+         call_comm_errhandler(comm, MPI_ERR_PMEM);
+         return MPI_ERR_PMEM;
+      }
+      if (posix_fallocate(fd, 0, path_stripes * stripe_size) != 0) {
+         mpi_log_error("Unable to allocate disk space for file '%s'.", file_name);
+         close(fd);
+         munmap(base, stripes * stripe_size);
+         call_comm_errhandler(comm, MPI_ERR_NO_SPACE);
+         return MPI_ERR_NO_SPACE;
+      }
+      for (stripe = i; stripe < stripes; stripe += mpi_pmem_root_paths_count) {
+         if (mmap(base + stripe * stripe_size, stripe_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd,
+                  (off_t) (stripe / mpi_pmem_root_paths_count) * stripe_size) == MAP_FAILED) {
+            mpi_log_error("Unable to map stripe %lu of file '%s' to memory.", stripe, file_name);
+            close(fd);
+            munmap(base, stripes * stripe_size);
+            call_comm_errhandler(comm, MPI_ERR_PMEM);
+            return MPI_ERR_PMEM;
+         }
+      }
+      close(fd);
+      mpi_log_debug("Mapped %lu stripes of file '%s'.", path_stripes, file_name);
+   }
+   *address = base;
+
+   return MPI_SUCCESS;
+}
+
+int unmap_striped_pmem_file(MPI_Comm comm, void *address, MPI_Aint size, MPI_Aint stripe_size) {
+   MPI_Aint stripes = size > 0 ? (size + stripe_size - 1) / stripe_size : 1;
+
+   return unmap_pmem_file(comm, address, stripes * stripe_size);
+}
+
+int remove_striped_pmem_file(MPI_Comm comm, const char *name, int root_path_index) {
+   int i;
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 20];
+
+   for (i = 1; i < mpi_pmem_root_paths_count; i++) {
+      get_stripe_file_name(name, root_path_index, i, file_name);
+      if (check_if_file_exist(file_name)) {
+         mpi_log_debug("Deleting file: %s", file_name);
+         if (!reclaim_file(mpi_pmem_root_paths[(root_path_index + i) % mpi_pmem_root_paths_count], file_name)) {
+            mpi_log_error("Unable to delete file '%s'.", file_name);
+            call_comm_errhandler(comm, MPI_ERR_PMEM);
+            return MPI_ERR_PMEM;
+         }
+      }
+   }
+
+   return MPI_SUCCESS;
+}
@@ -0,0 +1,87 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_NUMA_H__
+#define __MPI_WIN_PMEM_NUMA_H__
+
+#include <mpi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Find NUMA node of CPU on which calling process is running.
+ *
+ * @returns Identifier of NUMA node (0 if it can't be determined).
+ */
+int current_numa_node(void);
+
+/**
+ * Open data file of window striped over all root paths and map it into memory. Stripe i is placed in root path (local root path index + i) modulo number of
+ * root paths, so the first stripe is placed in root path local to process. Part of data file placed in local root path is named like data file of not striped
+ * window, parts in other root paths are named .<name>-stripe-<local root path index>. Use unmap_striped_pmem_file to free memory mapped by this function.
+ *
+ * @param comm         Communicator used for error handling.
+ * @param name         Name of window.
+ * @param size         Size of window.
+ * @param stripe_size  Size of stripe (multiple of page size).
+ * @param address      Output variable for memory address of mapped file.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int open_striped_pmem_file(MPI_Comm comm, const char *name, MPI_Aint size, MPI_Aint stripe_size, void **address);
+
+/**
+ * Unmap data file of window mapped by open_striped_pmem_file.
+ *
+ * @param comm         Communicator used for error handling.
+ * @param address      Memory address of mapped file.
+ * @param size         Size of window.
+ * @param stripe_size  Size of stripe.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int unmap_striped_pmem_file(MPI_Comm comm, void *address, MPI_Aint size, MPI_Aint stripe_size);
+
+/**
+ * Delete parts of data file of striped window placed in root paths other than local one.
+ *
+ * @param comm             Communicator used for error handling.
+ * @param name             Name of window.
+ * @param root_path_index  Index of root path local to process which created data file (saved in global metadata file, as it may change after restart).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int remove_striped_pmem_file(MPI_Comm comm, const char *name, int root_path_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
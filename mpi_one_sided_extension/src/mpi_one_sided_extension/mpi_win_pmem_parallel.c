@@ -0,0 +1,373 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_parallel.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <libpmem.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+
+typedef enum {
+   MPI_PMEM_COPY_MEMORY,
+   MPI_PMEM_COPY_PMEM,
+   MPI_PMEM_COPY_FILE,
+   MPI_PMEM_PREFAULT
+} MPI_Win_pmem_copy_kind;
+
+struct MPI_Win_pmem_copy_pool_structure {
+   int threads_count;               // Number of copying threads, including thread submitting task.
+   pthread_t *threads;
+   pthread_mutex_t submit_mutex;    // Serializes tasks submitted by different threads (e.g. background checkpoint thread and restore).
+   pthread_mutex_t mutex;
+   pthread_cond_t task_ready;
+   pthread_cond_t task_done;
+   uint64_t generation;             // Incremented with every submitted task.
+   int busy_workers;
+   bool shutdown;
+   // Currently processed task.
+   MPI_Win_pmem_copy_kind kind;
+   char *destination;
+   const char *source;
+   int fd;
+   off_t offset;
+   uint64_t size;
+   uint64_t chunk_size;
+   uint64_t chunks_count;
+   uint64_t next_chunk;
+   bool failed;
+};
+
+/**
+ * Fault in pages of memory area for writing without changing its contents.
+ *
+ * @param address  Beginning of memory area.
+ * @param size     Size of memory area.
+ */
+static void prefault_pages(char *address, uint64_t size) {
+   uintptr_t page_size = (uintptr_t) sysconf(_SC_PAGESIZE);
+   char *page = (char*) ((uintptr_t) address & ~(page_size - 1));
+
+#ifdef MADV_POPULATE_WRITE
+   if (madvise(page, address + size - page, MADV_POPULATE_WRITE) == 0) {
+      return;
+   }
+#endif
+   // Atomic addition of zero writes every page without changing it, even if other thread writes it concurrently.
+   for (; page < address + size; page += page_size) {
+      __atomic_fetch_add(page, 0, __ATOMIC_RELAXED);
+   }
+}
+
+/**
+ * Process chunks of current task until there are no more chunks left.
+ *
+ * @param pool  Pool of copying threads.
+ */
+static void copy_chunks(MPI_Win_pmem_copy_pool *pool) {
+   uint64_t chunk, start, size;
+   ssize_t written;
+
+   while ((chunk = __atomic_fetch_add(&pool->next_chunk, 1, __ATOMIC_RELAXED)) < pool->chunks_count) {
+      start = chunk * pool->chunk_size;
+      size = start + pool->chunk_size > pool->size ? pool->size - start : pool->chunk_size;
+      switch (pool->kind) {
+      case MPI_PMEM_COPY_MEMORY:
+         memcpy(pool->destination + start, pool->source + start, size);
+         break;
+      case MPI_PMEM_COPY_PMEM:
+         pmem_memcpy_nodrain(pool->destination + start, pool->source + start, size);
+         break;
+      case MPI_PMEM_COPY_FILE:
+         while (size > 0) {
+            written = pwrite(pool->fd, pool->source + start, size, pool->offset + start);
+            if (written < 0 && errno == EINTR) {
+               continue;
+            }
+            if (written <= 0) {
+               __atomic_store_n(&pool->failed, true, __ATOMIC_RELAXED);
+               break;
+            }
+            start += written;
+            size -= written;
+         }
+         break;
+      case MPI_PMEM_PREFAULT:
+         prefault_pages(pool->destination + start, size);
+         break;
+      }
+   }
+}
+
+/**
+ * Main function of worker thread.
+ *
+ * @param argument  Pool to which thread belongs.
+ *
+ * @returns Always NULL.
+ */
+static void *copy_worker(void *argument) {
+   MPI_Win_pmem_copy_pool *pool = argument;
+   uint64_t processed_generation = 0;
+
+   pthread_mutex_lock(&pool->mutex);
+   while (true) {
+      while (!pool->shutdown && pool->generation == processed_generation) {
+         pthread_cond_wait(&pool->task_ready, &pool->mutex);
+      }
+      if (pool->shutdown) {
+         break;
+      }
+      processed_generation = pool->generation;
+      pthread_mutex_unlock(&pool->mutex);
+
+      copy_chunks(pool);
+
+      // Locking mutex is a locked instruction, which orders non-temporal stores of worker before pmem_drain issued later by submitting thread.
+      pthread_mutex_lock(&pool->mutex);
+      if (--pool->busy_workers == 0) {
+         pthread_cond_signal(&pool->task_done);
+      }
+   }
+   pthread_mutex_unlock(&pool->mutex);
+
+   return NULL;
+}
+
+/**
+ * Split task into chunks and process it with all threads from pool (including calling thread).
+ *
+ * @param pool  Pool of copying threads with task parameters already set.
+ */
+static void run_task(MPI_Win_pmem_copy_pool *pool) {
+   pool->chunk_size = pool->size / (pool->threads_count * 4);
+   if (pool->chunk_size < MPI_PMEM_PARALLEL_COPY_MIN_CHUNK) {
+      pool->chunk_size = MPI_PMEM_PARALLEL_COPY_MIN_CHUNK;
+   }
+   // Keep chunks page aligned.
+   pool->chunk_size = (pool->chunk_size + 4095) & ~((uint64_t) 4095);
+   pool->chunks_count = (pool->size + pool->chunk_size - 1) / pool->chunk_size;
+   pool->next_chunk = 0;
+   pool->failed = false;
+
+   pthread_mutex_lock(&pool->mutex);
+   pool->busy_workers = pool->threads_count - 1;
+   pool->generation++;
+   pthread_cond_broadcast(&pool->task_ready);
+   pthread_mutex_unlock(&pool->mutex);
+
+   copy_chunks(pool);
+
+   pthread_mutex_lock(&pool->mutex);
+   while (pool->busy_workers > 0) {
+      pthread_cond_wait(&pool->task_done, &pool->mutex);
+   }
+   pthread_mutex_unlock(&pool->mutex);
+}
+
+int create_copy_pool(MPI_Comm comm, int threads_count, MPI_Win_pmem_copy_pool **pool) {
+   int i, cpu, first_cpu, started_threads;
+   cpu_set_t process_cpus, thread_cpus;
+   pthread_attr_t attributes;
+   MPI_Win_pmem_copy_pool *new_pool;
+
+   *pool = NULL;
+   if (threads_count <= 1) {
+      return MPI_SUCCESS;
+   }
+
+   new_pool = malloc(sizeof(MPI_Win_pmem_copy_pool));
+   if (new_pool != NULL) {
+      new_pool->threads = malloc((threads_count - 1) * sizeof(pthread_t));
+   }
+   if (new_pool == NULL || new_pool->threads == NULL) {
+      free(new_pool);
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   new_pool->threads_count = threads_count;
+   new_pool->generation = 0;
+   new_pool->busy_workers = 0;
+   new_pool->shutdown = false;
+   pthread_mutex_init(&new_pool->submit_mutex, NULL);
+   pthread_mutex_init(&new_pool->mutex, NULL);
+   pthread_cond_init(&new_pool->task_ready, NULL);
+   pthread_cond_init(&new_pool->task_done, NULL);
+
+   // Workers are pinned to cores of calling process only if process is bound to part of the node, so they don't run on cores of other processes. Otherwise
+   // they inherit affinity of calling thread and are placed by scheduler.
+   if (sched_getaffinity(0, sizeof(cpu_set_t), &process_cpus) != 0 || CPU_COUNT(&process_cpus) >= sysconf(_SC_NPROCESSORS_ONLN)) {
+      CPU_ZERO(&process_cpus);
+   }
+   first_cpu = sched_getcpu();
+   cpu = first_cpu < 0 ? 0 : first_cpu;
+   started_threads = 0;
+   for (i = 0; i < threads_count - 1; i++) {
+      pthread_attr_init(&attributes);
+      if (CPU_COUNT(&process_cpus) > 1) {
+         do {
+            cpu = (cpu + 1) % CPU_SETSIZE;
+         } while (!CPU_ISSET(cpu, &process_cpus));
+         CPU_ZERO(&thread_cpus);
+         CPU_SET(cpu, &thread_cpus);
+         pthread_attr_setaffinity_np(&attributes, sizeof(cpu_set_t), &thread_cpus);
+      }
+      if (pthread_create(&new_pool->threads[i], &attributes, copy_worker, new_pool) == 0) {
+         started_threads++;
+      }
+      pthread_attr_destroy(&attributes);
+      if (started_threads != i + 1) {
+         break;
+      }
+   }
+   if (started_threads != threads_count - 1) {
+      new_pool->threads_count = started_threads + 1;
+      free_copy_pool(new_pool);
+      mpi_log_error("Unable to start checkpoint copying thread.");
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   mpi_log_debug("Created pool of %d checkpoint copying threads.", threads_count);
+   *pool = new_pool;
+
+   return MPI_SUCCESS;
+}
+
+void free_copy_pool(MPI_Win_pmem_copy_pool *pool) {
+   int i;
+
+   if (pool == NULL) {
+      return;
+   }
+
+   pthread_mutex_lock(&pool->mutex);
+   pool->shutdown = true;
+   pthread_cond_broadcast(&pool->task_ready);
+   pthread_mutex_unlock(&pool->mutex);
+   for (i = 0; i < pool->threads_count - 1; i++) {
+      pthread_join(pool->threads[i], NULL);
+   }
+
+   pthread_cond_destroy(&pool->task_done);
+   pthread_cond_destroy(&pool->task_ready);
+   pthread_mutex_destroy(&pool->mutex);
+   pthread_mutex_destroy(&pool->submit_mutex);
+   free(pool->threads);
+   free(pool);
+}
+
+void parallel_memcpy(MPI_Win_pmem_copy_pool *pool, void *destination, const void *source, uint64_t size) {
+   if (pool == NULL || size < MPI_PMEM_PARALLEL_COPY_MIN_SIZE) {
+      memcpy(destination, source, size);
+      return;
+   }
+
+   pthread_mutex_lock(&pool->submit_mutex);
+   pool->kind = MPI_PMEM_COPY_MEMORY;
+   pool->destination = destination;
+   pool->source = source;
+   pool->size = size;
+   run_task(pool);
+   pthread_mutex_unlock(&pool->submit_mutex);
+}
+
+void parallel_pmem_memcpy(MPI_Win_pmem_copy_pool *pool, void *destination, const void *source, uint64_t size) {
+   parallel_pmem_memcpy_nodrain(pool, destination, source, size);
+   pmem_drain();
+}
+
+void parallel_pmem_memcpy_nodrain(MPI_Win_pmem_copy_pool *pool, void *destination, const void *source, uint64_t size) {
+   if (pool == NULL || size < MPI_PMEM_PARALLEL_COPY_MIN_SIZE) {
+      pmem_memcpy_nodrain(destination, source, size);
+      return;
+   }
+
+   pthread_mutex_lock(&pool->submit_mutex);
+   pool->kind = MPI_PMEM_COPY_PMEM;
+   pool->destination = destination;
+   pool->source = source;
+   pool->size = size;
+   run_task(pool);
+   pthread_mutex_unlock(&pool->submit_mutex);
+}
+
+bool parallel_pwrite(MPI_Win_pmem_copy_pool *pool, int fd, const void *source, uint64_t size, off_t offset) {
+   ssize_t written;
+   bool result;
+   const char *position = source;
+
+   if (pool == NULL || size < MPI_PMEM_PARALLEL_COPY_MIN_SIZE) {
+      while (size > 0) {
+         written = pwrite(fd, position, size, offset);
+         if (written < 0 && errno == EINTR) {
+            continue;
+         }
+         if (written <= 0) {
+            return false;
+         }
+         position += written;
+         offset += written;
+         size -= written;
+      }
+      return true;
+   }
+
+   pthread_mutex_lock(&pool->submit_mutex);
+   pool->kind = MPI_PMEM_COPY_FILE;
+   pool->fd = fd;
+   pool->source = source;
+   pool->offset = offset;
+   pool->size = size;
+   run_task(pool);
+   result = !pool->failed;
+   pthread_mutex_unlock(&pool->submit_mutex);
+
+   return result;
+}
+
+void parallel_prefault(MPI_Win_pmem_copy_pool *pool, void *address, uint64_t size) {
+   if (pool == NULL || size < MPI_PMEM_PARALLEL_COPY_MIN_SIZE) {
+      prefault_pages(address, size);
+      return;
+   }
+
+   pthread_mutex_lock(&pool->submit_mutex);
+   pool->kind = MPI_PMEM_PREFAULT;
+   pool->destination = address;
+   pool->size = size;
+   run_task(pool);
+   pthread_mutex_unlock(&pool->submit_mutex);
+}
@@ -0,0 +1,121 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_PARALLEL_H__
+#define __MPI_WIN_PMEM_PARALLEL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <mpi.h>
+#include "mpi_win_pmem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MPI_PMEM_DEFAULT_CHECKPOINT_THREADS 1
+#define MPI_PMEM_PARALLEL_COPY_MIN_SIZE (4 * 1024 * 1024)  // Smaller copies are done by calling thread only.
+#define MPI_PMEM_PARALLEL_COPY_MIN_CHUNK (1024 * 1024)
+
+/**
+ * Create pool of threads used to copy checkpoint data. Worker threads are pinned to consecutive cores (starting from the core of calling thread) from affinity mask of the process.
+ *
+ * @param comm           Communicator used for error handling.
+ * @param threads_count  Number of threads copying data, including calling thread.
+ * @param pool           Output variable for created pool (NULL if threads_count is 1).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int create_copy_pool(MPI_Comm comm, int threads_count, MPI_Win_pmem_copy_pool **pool);
+
+/**
+ * Stop all worker threads and free pool.
+ *
+ * @param pool  Pool to free (may be NULL).
+ */
+void free_copy_pool(MPI_Win_pmem_copy_pool *pool);
+
+/**
+ * Copy memory area using all threads from pool.
+ *
+ * @param pool         Pool of copying threads (if NULL, data is copied by calling thread).
+ * @param destination  Destination memory area.
+ * @param source       Source memory area.
+ * @param size         Size of memory area.
+ */
+void parallel_memcpy(MPI_Win_pmem_copy_pool *pool, void *destination, const void *source, uint64_t size);
+
+/**
+ * Copy memory area into persistent memory using non-temporal stores of all threads from pool. Data is persistent when function returns.
+ *
+ * @param pool         Pool of copying threads (if NULL, data is copied by calling thread).
+ * @param destination  Destination memory area placed in persistent memory.
+ * @param source       Source memory area.
+ * @param size         Size of memory area.
+ */
+void parallel_pmem_memcpy(MPI_Win_pmem_copy_pool *pool, void *destination, const void *source, uint64_t size);
+
+/**
+ * Copy memory area into persistent memory like parallel_pmem_memcpy, but without waiting for stores to be drained. Data of any number of copies is persistent
+ * after calling thread calls pmem_drain.
+ *
+ * @param pool         Pool of copying threads (if NULL, data is copied by calling thread).
+ * @param destination  Destination memory area placed in persistent memory.
+ * @param source       Source memory area.
+ * @param size         Size of memory area.
+ */
+void parallel_pmem_memcpy_nodrain(MPI_Win_pmem_copy_pool *pool, void *destination, const void *source, uint64_t size);
+
+/**
+ * Write memory area into file at specified offset using all threads from pool.
+ *
+ * @param pool    Pool of writing threads (if NULL, data is written by calling thread).
+ * @param fd      File descriptor.
+ * @param source  Memory area to write.
+ * @param size    Size of memory area.
+ * @param offset  Offset in file.
+ *
+ * @returns True if whole memory area was written, false otherwise.
+ */
+bool parallel_pwrite(MPI_Win_pmem_copy_pool *pool, int fd, const void *source, uint64_t size, off_t offset);
+
+/**
+ * Fault in all pages of memory area using all threads from pool, so they are mapped before memory is used. Contents of memory area isn't changed.
+ *
+ * @param pool     Pool of threads (if NULL, pages are faulted in by calling thread).
+ * @param address  Beginning of memory area.
+ * @param size     Size of memory area.
+ */
+void parallel_prefault(MPI_Win_pmem_copy_pool *pool, void *address, uint64_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "mpi_win_pmem_persist.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <libpmem.h>
+#include "../common/logger.h"
+
+#define MPI_PMEM_PERSIST_BATCH_MIN_CAPACITY 16
+
+/**
+ * Compare ranges by kind and beginning address (used by qsort).
+ *
+ * @param first   First range.
+ * @param second  Second range.
+ *
+ * @returns Negative, zero or positive value if first range should be placed before, at the same position or after second range.
+ */
+static int compare_persist_ranges(const void *first, const void *second) {
+   const MPI_Win_pmem_persist_range *first_range = first;
+   const MPI_Win_pmem_persist_range *second_range = second;
+
+   if (first_range->is_pmem != second_range->is_pmem) {
+      return first_range->is_pmem ? -1 : 1;
+   }
+   if (first_range->begin != second_range->begin) {
+      return first_range->begin < second_range->begin ? -1 : 1;
+   }
+
+   return 0;
+}
+
+void init_persist_batch(MPI_Win_pmem_persist_batch *batch) {
+   batch->ranges = NULL;
+   batch->count = 0;
+   batch->capacity = 0;
+}
+
+bool add_persist_range(MPI_Win_pmem_persist_batch *batch, const void *address, MPI_Aint size, bool is_pmem) {
+   MPI_Win_pmem_persist_range *ranges;
+   uintptr_t alignment = is_pmem ? MPI_PMEM_CACHE_LINE_SIZE : (uintptr_t) sysconf(_SC_PAGESIZE);
+
+   if (size == 0) {
+      return true;
+   }
+   if (batch->count == batch->capacity) {
+      ranges = realloc(batch->ranges, (batch->capacity == 0 ? MPI_PMEM_PERSIST_BATCH_MIN_CAPACITY : 2 * batch->capacity) * sizeof(MPI_Win_pmem_persist_range));
+      if (ranges == NULL) {
+         return false;
+      }
+      batch->ranges = ranges;
+      batch->capacity = batch->capacity == 0 ? MPI_PMEM_PERSIST_BATCH_MIN_CAPACITY : 2 * batch->capacity;
+   }
+
+   // Ranges are aligned to units of flushing, so ranges sharing cache line (or page) are merged.
+   batch->ranges[batch->count].begin = (uintptr_t) address & ~(alignment - 1);
+   batch->ranges[batch->count].end = ((uintptr_t) address + size + alignment - 1) & ~(alignment - 1);
+   batch->ranges[batch->count].is_pmem = is_pmem;
+   batch->count++;
+
+   return true;
+}
+
+void merge_persist_ranges(MPI_Win_pmem_persist_batch *batch) {
+   int i, merged;
+   MPI_Win_pmem_persist_range *ranges = batch->ranges;
+
+   if (batch->count == 0) {
+      return;
+   }
+   qsort(ranges, batch->count, sizeof(MPI_Win_pmem_persist_range), compare_persist_ranges);
+   merged = 0;
+   for (i = 1; i < batch->count; i++) {
+      if (ranges[i].is_pmem == ranges[merged].is_pmem && ranges[i].begin <= ranges[merged].end) {
+         if (ranges[i].end > ranges[merged].end) {
+            ranges[merged].end = ranges[i].end;
+         }
+      } else {
+         ranges[++merged] = ranges[i];
+      }
+   }
+   batch->count = merged + 1;
+}
+
+bool persist_batch(MPI_Win_pmem_persist_batch *batch) {
+   int i;
+   bool flushed = false, result = true;
+   MPI_Win_pmem_persist_range *ranges = batch->ranges;
+
+   merge_persist_ranges(batch);
+   for (i = 0; i < batch->count; i++) {
+      if (ranges[i].is_pmem) {
+         pmem_flush((void*) ranges[i].begin, ranges[i].end - ranges[i].begin);
+         flushed = true;
+      } else if (pmem_msync((void*) ranges[i].begin, ranges[i].end - ranges[i].begin) != 0) {
+         mpi_log_error("Unable to msync memory area base: 0x%lx, size: %lu.", (long int) ranges[i].begin, ranges[i].end - ranges[i].begin);
+         result = false;
+      }
+   }
+   if (flushed) {
+      pmem_drain();
+   }
+   batch->count = 0;
+
+   return result;
+}
+
+void free_persist_batch(MPI_Win_pmem_persist_batch *batch) {
+   free(batch->ranges);
+   init_persist_batch(batch);
+}
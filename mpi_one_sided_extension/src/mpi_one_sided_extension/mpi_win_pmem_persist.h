@@ -0,0 +1,102 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __MPI_WIN_PMEM_PERSIST_H__
+#define __MPI_WIN_PMEM_PERSIST_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <mpi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MPI_PMEM_CACHE_LINE_SIZE 64
+
+// Memory range which has to be stored durably.
+typedef struct {
+   uintptr_t begin;
+   uintptr_t end;
+   bool is_pmem;  // Range is flushed from CPU caches if true, otherwise it is written back with msync.
+} MPI_Win_pmem_persist_range;
+
+// Batch of ranges persisted together: overlapping and adjacent ranges are merged and all flushes are completed with single drain.
+typedef struct {
+   MPI_Win_pmem_persist_range *ranges;
+   int count;
+   int capacity;
+} MPI_Win_pmem_persist_batch;
+
+/**
+ * Initialize empty batch.
+ *
+ * @param batch  Batch to initialize.
+ */
+void init_persist_batch(MPI_Win_pmem_persist_batch *batch);
+
+/**
+ * Add memory range to batch. Range is not persisted until persist_batch is called.
+ *
+ * @param batch    Batch of ranges.
+ * @param address  Beginning of memory range.
+ * @param size     Size of memory range.
+ * @param is_pmem  Flag specifying whether range is persistent memory (result of pmem_is_pmem).
+ *
+ * @returns false if there is not enough memory to extend batch, true otherwise.
+ */
+bool add_persist_range(MPI_Win_pmem_persist_batch *batch, const void *address, MPI_Aint size, bool is_pmem);
+
+/**
+ * Sort ranges of batch and merge overlapping and adjacent ranges of the same kind.
+ *
+ * @param batch  Batch of ranges.
+ */
+void merge_persist_ranges(MPI_Win_pmem_persist_batch *batch);
+
+/**
+ * Persist all ranges of batch and make batch empty. Ranges of persistent memory are aligned to cache lines and flushed from CPU caches, other ranges are aligned
+ * to pages and synchronized with msync.
+ *
+ * @param batch  Batch of ranges.
+ *
+ * @returns false if any range couldn't be synchronized, true otherwise.
+ */
+bool persist_batch(MPI_Win_pmem_persist_batch *batch);
+
+/**
+ * Free memory used by batch.
+ *
+ * @param batch  Batch of ranges.
+ */
+void free_persist_batch(MPI_Win_pmem_persist_batch *batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,226 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "mpi_win_pmem_reclaim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem.h"
+
+// File waiting in reclaim directory to be unlinked.
+typedef struct MPI_Win_pmem_reclaimed_file_structure {
+   char *file_name;
+   struct MPI_Win_pmem_reclaimed_file_structure *next;
+} MPI_Win_pmem_reclaimed_file;
+
+// Queue of files unlinked by background thread, which is shared by all windows of process. Thread is started by first queued file and never stops,
+// MPI_Finalize_pmem waits until queue is empty. Files queued by crashed process stay in reclaim directory and are recovered by next process using the same
+// root path.
+static pthread_mutex_t reclaim_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reclaim_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t reclaim_done = PTHREAD_COND_INITIALIZER;
+static MPI_Win_pmem_reclaimed_file *reclaim_head = NULL;
+static MPI_Win_pmem_reclaimed_file *reclaim_tail = NULL;
+static int reclaim_pending = 0;   // Number of queued files including the one being unlinked.
+static bool reclaim_thread_started = false;
+static unsigned long reclaim_counter = 0;
+
+/**
+ * Unlink queued files in background. Freeing extents of large files (especially on DAX file systems) is what makes unlink slow, so it is done here instead
+ * of in the thread which deleted file. Files aren't hole-punched, because checkpoint files may still be mapped privately by restored windows.
+ *
+ * @param argument  Not used.
+ *
+ * @returns Nothing (never returns).
+ */
+static void *reclaim_files(void *argument) {
+   MPI_Win_pmem_reclaimed_file *file;
+
+   (void) argument;
+
+   pthread_mutex_lock(&reclaim_mutex);
+   while (true) {
+      while (reclaim_head == NULL) {
+         pthread_cond_wait(&reclaim_queued, &reclaim_mutex);
+      }
+      file = reclaim_head;
+      reclaim_head = file->next;
+      if (reclaim_head == NULL) {
+         reclaim_tail = NULL;
+      }
+      pthread_mutex_unlock(&reclaim_mutex);
+
+      unlink(file->file_name);
+      free(file->file_name);
+      free(file);
+
+      pthread_mutex_lock(&reclaim_mutex);
+      if (--reclaim_pending == 0) {
+         pthread_cond_broadcast(&reclaim_done);
+      }
+   }
+
+   return NULL;
+}
+
+/**
+ * Add file placed in reclaim directory to queue of background thread. File is unlinked at once if thread can't be started.
+ *
+ * @param file_name  Name of file in reclaim directory. It is freed by this function.
+ */
+static void queue_reclaimed_file(char *file_name) {
+   pthread_t thread;
+   MPI_Win_pmem_reclaimed_file *file;
+
+   pthread_mutex_lock(&reclaim_mutex);
+   if (!reclaim_thread_started && pthread_create(&thread, NULL, reclaim_files, NULL) == 0) {
+      pthread_detach(thread);
+      reclaim_thread_started = true;
+   }
+   file = reclaim_thread_started ? malloc(sizeof(MPI_Win_pmem_reclaimed_file)) : NULL;
+   if (file == NULL) {
+      pthread_mutex_unlock(&reclaim_mutex);
+      unlink(file_name);
+      free(file_name);
+      return;
+   }
+   file->file_name = file_name;
+   file->next = NULL;
+   if (reclaim_tail != NULL) {
+      reclaim_tail->next = file;
+   } else {
+      reclaim_head = file;
+   }
+   reclaim_tail = file;
+   reclaim_pending++;
+   pthread_cond_signal(&reclaim_queued);
+   pthread_mutex_unlock(&reclaim_mutex);
+}
+
+bool reclaim_file(const char *root_path, const char *file_name) {
+   char *reclaimed_name, *base_name;
+   unsigned long counter;
+   struct stat file_status;
+
+   base_name = strrchr(file_name, '/');
+   base_name = base_name != NULL ? base_name + 1 : (char*) file_name;
+   // Additional 36 characters for: two "/", two "-", 11 characters for process id, 20 characters for counter and terminating zero.
+   reclaimed_name = malloc((strlen(root_path) + strlen(MPI_PMEM_RECLAIM_DIRECTORY) + strlen(base_name) + 36) * sizeof(char));
+   if (reclaimed_name == NULL) {
+      return remove(file_name) == 0;
+   }
+   pthread_mutex_lock(&reclaim_mutex);
+   counter = reclaim_counter++;
+   pthread_mutex_unlock(&reclaim_mutex);
+   sprintf(reclaimed_name, "%s/%s/%d-%lu-%s", root_path, MPI_PMEM_RECLAIM_DIRECTORY, (int) getpid(), counter, base_name);
+
+   // Renaming file in the same file system is atomic and doesn't free its extents, so deleted file is either under its name or in reclaim directory.
+   if (rename(file_name, reclaimed_name) != 0) {
+      if (errno == ENOENT) {
+         // Either file doesn't exist or reclaim directory isn't created yet.
+         if (lstat(file_name, &file_status) != 0) {
+            free(reclaimed_name);
+            return false;
+         }
+         sprintf(reclaimed_name, "%s/%s", root_path, MPI_PMEM_RECLAIM_DIRECTORY);
+         if (mkdir(reclaimed_name, 0777) != 0) {
+            free(reclaimed_name);
+            return false;
+         }
+         sprintf(reclaimed_name, "%s/%s/%d-%lu-%s", root_path, MPI_PMEM_RECLAIM_DIRECTORY, (int) getpid(), counter, base_name);
+         if (rename(file_name, reclaimed_name) == 0) {
+            queue_reclaimed_file(reclaimed_name);
+            return true;
+         }
+      }
+      free(reclaimed_name);
+      return remove(file_name) == 0;
+   }
+   queue_reclaimed_file(reclaimed_name);
+
+   return true;
+}
+
+int recover_reclaimed_files(MPI_Comm comm, const char *root_path) {
+   char *directory_name, *file_name;
+   DIR *directory;
+   struct dirent *entry;
+   int count = 0;
+
+   directory_name = malloc((strlen(root_path) + strlen(MPI_PMEM_RECLAIM_DIRECTORY) + 2) * sizeof(char));
+   if (directory_name == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   sprintf(directory_name, "%s/%s", root_path, MPI_PMEM_RECLAIM_DIRECTORY);
+   directory = opendir(directory_name);
+   if (directory == NULL) {
+      free(directory_name);
+      return MPI_SUCCESS;
+   }
+
+   while ((entry = readdir(directory)) != NULL) {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+         continue;
+      }
+      file_name = malloc((strlen(directory_name) + strlen(entry->d_name) + 2) * sizeof(char));
+      if (file_name == NULL) {
+         mpi_log_error("Unable to allocate memory.");
+         closedir(directory);
+         free(directory_name);
+         call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+         return MPI_ERR_PMEM_NO_MEM;
+      }
+      sprintf(file_name, "%s/%s", directory_name, entry->d_name);
+      queue_reclaimed_file(file_name);
+      count++;
+   }
+   closedir(directory);
+   if (count > 0) {
+      mpi_log_debug("%d files left in '%s' queued to be unlinked.", count, directory_name);
+   }
+   free(directory_name);
+
+   return MPI_SUCCESS;
+}
+
+void wait_for_reclaimed_files() {
+   pthread_mutex_lock(&reclaim_mutex);
+   while (reclaim_pending > 0) {
+      pthread_cond_wait(&reclaim_done, &reclaim_mutex);
+   }
+   pthread_mutex_unlock(&reclaim_mutex);
+}
@@ -0,0 +1,72 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef __MPI_WIN_PMEM_RECLAIM_H__
+#define __MPI_WIN_PMEM_RECLAIM_H__
+
+#include <stdbool.h>
+#include <mpi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Directory (inside root path) containing files which are deleted, but whose space hasn't been reclaimed yet.
+#define MPI_PMEM_RECLAIM_DIRECTORY ".reclaim"
+
+/**
+ * Delete file without waiting for its space to be freed. File is atomically moved to reclaim directory of its root path and unlinked there by background
+ * thread, so it doesn't exist under its name after this function returns. Files left in reclaim directory by crashed process are unlinked after root path
+ * is set again. Function doesn't use MPI, so it can be called from any thread.
+ *
+ * @param root_path  Root path containing file.
+ * @param file_name  Name of file to delete.
+ *
+ * @returns true if file was deleted, false if it doesn't exist or can't be deleted.
+ */
+bool reclaim_file(const char *root_path, const char *file_name);
+
+/**
+ * Queue files left in reclaim directory of root path (e.g. by crashed process) to be unlinked by background thread.
+ *
+ * @param comm       Communicator used for error handling.
+ * @param root_path  Root path.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int recover_reclaimed_files(MPI_Comm comm, const char *root_path);
+
+/**
+ * Wait until all queued files are unlinked. Called by MPI_Finalize_pmem.
+ */
+void wait_for_reclaimed_files();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
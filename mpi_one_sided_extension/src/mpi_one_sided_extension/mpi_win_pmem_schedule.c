@@ -0,0 +1,94 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_schedule.h"
+#include <math.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+
+double optimal_checkpoint_interval(double cost, int mtbf, int overhead) {
+   double interval, budget_interval;
+
+   if (cost < 2.0 * mtbf) {
+      interval = sqrt(2.0 * cost * mtbf) * (1.0 + sqrt(cost / (2.0 * mtbf)) / 3.0 + cost / (18.0 * mtbf)) - cost;
+   } else {
+      interval = mtbf;
+   }
+   if (overhead > 0) {
+      budget_interval = cost * 100.0 / overhead;
+      if (budget_interval > interval) {
+         interval = budget_interval;
+      }
+   }
+
+   return interval;
+}
+
+bool is_checkpoint_due(MPI_Win_pmem win) {
+   double interval;
+
+   if (win.checkpoint_mtbf == 0) {
+      return true;
+   }
+   interval = optimal_checkpoint_interval(win.modifiable_values->checkpoint_cost, win.checkpoint_mtbf, win.checkpoint_overhead);
+   if (MPI_Wtime() - win.modifiable_values->last_checkpoint_time < interval) {
+      mpi_log_debug("Checkpoint skipped, interval %f s didn't elapse yet.", interval);
+      return false;
+   }
+
+   return true;
+}
+
+int is_checkpoint_due_on_all_processes(MPI_Win_pmem win, bool *due) {
+   int result;
+   char due_in_process, due_in_any_process;
+
+   if (win.checkpoint_mtbf == 0) {
+      *due = true;
+      return MPI_SUCCESS;
+   }
+   // Clocks and checkpoint costs differ between processes, so checkpoint is created if it is due in any of them.
+   due_in_process = is_checkpoint_due(win) ? 1 : 0;
+   result = MPI_Allreduce(&due_in_process, &due_in_any_process, 1, MPI_CHAR, MPI_MAX, win.comm);
+   CHECK_ERROR_CODE(result);
+   *due = due_in_any_process == 1;
+
+   return MPI_SUCCESS;
+}
+
+void record_checkpoint_cost(MPI_Win_pmem win, double start_time) {
+   double end_time = MPI_Wtime();
+
+   if (win.modifiable_values->checkpoint_cost == 0.0) {
+      win.modifiable_values->checkpoint_cost = end_time - start_time;
+   } else {
+      win.modifiable_values->checkpoint_cost = (1.0 - MPI_PMEM_CHECKPOINT_COST_WEIGHT) * win.modifiable_values->checkpoint_cost +
+                                               MPI_PMEM_CHECKPOINT_COST_WEIGHT * (end_time - start_time);
+   }
+   win.modifiable_values->last_checkpoint_time = end_time;
+}
@@ -0,0 +1,87 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_SCHEDULE_H__
+#define __MPI_WIN_PMEM_SCHEDULE_H__
+
+#include <stdbool.h>
+#include <mpi.h>
+#include "mpi_win_pmem_datatypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Weight of last measurement in estimated cost of checkpoint (exponential moving average).
+#define MPI_PMEM_CHECKPOINT_COST_WEIGHT 0.25
+
+/**
+ * Compute optimal interval between checkpoints using Daly's higher order approximation of Young's formula. Interval is extended if checkpoints
+ * would take more than allowed percentage of run time.
+ *
+ * @param cost      Time of creating checkpoint in seconds.
+ * @param mtbf      Mean time between failures in seconds.
+ * @param overhead  Maximum percentage of run time spent on checkpoints (0 if not limited).
+ *
+ * @returns Interval between checkpoints in seconds.
+ */
+double optimal_checkpoint_interval(double cost, int mtbf, int overhead);
+
+/**
+ * Check if optimal interval elapsed since last checkpoint of window. Checkpoint is always due if window doesn't schedule checkpoints.
+ *
+ * @param win  Window object.
+ *
+ * @returns true if checkpoint should be created, false otherwise.
+ */
+bool is_checkpoint_due(MPI_Win_pmem win);
+
+/**
+ * Check if checkpoint is due in any process of window, so all processes make the same decision. Collective over window's communicator if window
+ * schedules checkpoints.
+ *
+ * @param win  Window object.
+ * @param due  Output variable specifying whether checkpoint should be created.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int is_checkpoint_due_on_all_processes(MPI_Win_pmem win, bool *due);
+
+/**
+ * Update estimated cost of checkpoint with time elapsed since start of checkpoint and remember time of checkpoint.
+ *
+ * @param win         Window object.
+ * @param start_time  Time (result of MPI_Wtime) when checkpoint was started.
+ */
+void record_checkpoint_cost(MPI_Win_pmem win, double start_time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_shared.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem.h"
+#include "mpi_win_pmem_helper.h"
+
+int map_shared_window(MPI_Win_pmem *win, MPI_Aint size, int disp_unit, void **base) {
+   int result, rank, processes, i;
+   char status;
+   MPI_Aint local[2], offset;
+   MPI_Aint *segments;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 1];
+
+   MPI_Comm_rank(win->comm, &rank);
+   MPI_Comm_size(win->comm, &processes);
+   segments = malloc(3 * processes * sizeof(MPI_Aint));
+   if (segments == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(win->comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+
+   // Segments are placed one after another in order of ranks.
+   local[0] = size;
+   local[1] = disp_unit;
+   result = MPI_Allgather(local, 2, MPI_AINT, segments + processes, 2, MPI_AINT, win->comm);
+   CHECK_ERROR_CODE(result);
+   offset = 0;
+   for (i = 0; i < processes; i++) {
+      segments[3 * i + 1] = segments[processes + 2 * i];
+      segments[3 * i + 2] = segments[processes + 2 * i + 1];
+      segments[3 * i] = offset;
+      offset += segments[3 * i + 1];
+   }
+
+   // All processes map data file placed in root path of process with rank 0, which creates it first.
+   offset = offset > 0 ? offset : 1;
+   strcpy(root_path, mpi_pmem_root_path);
+   result = MPI_Bcast(root_path, MPI_PMEM_MAX_ROOT_PATH, MPI_CHAR, 0, win->comm);
+   CHECK_ERROR_CODE(result);
+   sprintf(file_name, "%s/%s", root_path, win->name);
+   status = 1;
+   if (rank == 0) {
+      result = map_window_file(win->comm, file_name, offset, win->map_sync, &win->modifiable_values->shared_base);
+      status = result == MPI_SUCCESS ? 1 : 0;
+   }
+   MPI_Bcast(&status, 1, MPI_CHAR, 0, win->comm);
+   if (rank == 0 && status == 0) {
+      free(segments);
+      return result;
+   }
+   if (status == 0) {
+      mpi_log_error("Unable to create data file '%s' of shared window.", file_name);
+      free(segments);
+      call_comm_errhandler(win->comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   if (rank != 0) {
+      result = map_window_file(win->comm, file_name, offset, win->map_sync, &win->modifiable_values->shared_base);
+      CHECK_ERROR_CODE(result);
+   }
+
+   win->modifiable_values->shared_size = offset;
+   win->modifiable_values->shared_segments = segments;
+   *base = (char*) win->modifiable_values->shared_base + segments[3 * rank];
+   mpi_log_debug("Segment of shared window mapped at offset %lu of file '%s'.", segments[3 * rank], file_name);
+
+   return MPI_SUCCESS;
+}
+
+int query_shared_segment(MPI_Win_pmem win, int rank, MPI_Aint *size, int *disp_unit, void *baseptr) {
+   int processes;
+   MPI_Aint *segments = win.modifiable_values->shared_segments;
+
+   MPI_Comm_size(win.comm, &processes);
+   if (rank == MPI_PROC_NULL) {
+      for (rank = 0; rank < processes - 1 && segments[3 * rank + 1] == 0; rank++) {
+      }
+   }
+   if (rank < 0 || rank >= processes) {
+      mpi_log_error("Invalid rank %d of shared window.", rank);
+      call_win_errhandler(win.win, MPI_ERR_RANK);
+      return MPI_ERR_RANK;
+   }
+
+   *size = segments[3 * rank + 1];
+   *disp_unit = (int) segments[3 * rank + 2];
+   *(void**) baseptr = (char*) win.modifiable_values->shared_base + segments[3 * rank];
+
+   return MPI_SUCCESS;
+}
+
+int unmap_shared_window(MPI_Win_pmem win) {
+   int result;
+
+   result = unmap_pmem_file(win.comm, win.modifiable_values->shared_base, win.modifiable_values->shared_size);
+   CHECK_ERROR_CODE(result);
+   free(win.modifiable_values->shared_segments);
+   win.modifiable_values->shared_base = NULL;
+   win.modifiable_values->shared_segments = NULL;
+
+   return MPI_SUCCESS;
+}
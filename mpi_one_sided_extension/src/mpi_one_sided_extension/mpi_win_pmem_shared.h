@@ -0,0 +1,78 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_SHARED_H__
+#define __MPI_WIN_PMEM_SHARED_H__
+
+#include <mpi.h>
+#include "mpi_win_pmem_datatypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Map data file of shared window. File is placed in root path of process with rank 0 and contains contiguous segments of all processes in order of their
+ * ranks. Collective over communicator of window.
+ *
+ * @param win        Window object.
+ * @param size       Size of segment of calling process.
+ * @param disp_unit  Displacement unit of segment of calling process.
+ * @param base       Output variable for address of segment of calling process.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int map_shared_window(MPI_Win_pmem *win, MPI_Aint size, int disp_unit, void **base);
+
+/**
+ * Get segment of specified process in shared window (same semantics as MPI_Win_shared_query).
+ *
+ * @param win        Window object.
+ * @param rank       Rank of process or MPI_PROC_NULL for the first non-empty segment.
+ * @param size       Output variable for size of segment.
+ * @param disp_unit  Output variable for displacement unit of segment.
+ * @param baseptr    Output variable for address of segment.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int query_shared_segment(MPI_Win_pmem win, int rank, MPI_Aint *size, int *disp_unit, void *baseptr);
+
+/**
+ * Unmap data file of shared window.
+ *
+ * @param win  Window object.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int unmap_shared_window(MPI_Win_pmem win);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
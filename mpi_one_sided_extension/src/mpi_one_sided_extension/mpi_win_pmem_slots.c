@@ -0,0 +1,170 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_slots.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <libpmem.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem_reclaim.h"
+
+int get_slot_file_name(MPI_Comm comm, const char *name, int slot, char **file_name) {
+   // Additional 19 characters for: "/.", "-slot-", 10 characters for slot number (length of maximum 4 byte integer number written in decimal form is 10 characters) and terminating zero.
+   *file_name = malloc((strlen(mpi_pmem_root_path) + strlen(name) + 19) * sizeof(char));
+   if (*file_name == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   sprintf(*file_name, "%s/.%s-slot-%d", mpi_pmem_root_path, name, slot);
+
+   return MPI_SUCCESS;
+}
+
+int open_checkpoint_slots(MPI_Comm comm, const char *name, int count, MPI_Aint size, MPI_Win_pmem_slot_ring **ring) {
+   int result, i, root_file_descriptor;
+   char *file_name;
+   MPI_Win_pmem_checkpoint_slot *slot;
+
+   *ring = malloc(sizeof(MPI_Win_pmem_slot_ring) + count * sizeof(MPI_Win_pmem_checkpoint_slot));
+   if (*ring == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   (*ring)->count = 0;
+   (*ring)->size = size;
+   (*ring)->next_slot = 0;
+
+   for (i = 0; i < count; i++) {
+      result = get_slot_file_name(comm, name, i, &file_name);
+      if (result != MPI_SUCCESS) {
+         close_checkpoint_slots(*ring);
+         *ring = NULL;
+         return result;
+      }
+      slot = &(*ring)->slots[i];
+      if ((slot->fd = open(file_name, O_CREAT | O_RDWR, 0666)) < 0) {
+         mpi_log_error("Unable to open checkpoint slot file '%s'.", file_name);
+         free(file_name);
+         close_checkpoint_slots(*ring);
+         *ring = NULL;
+         call_comm_errhandler(comm, MPI_ERR_PMEM);
+         return MPI_ERR_PMEM;
+      }
+      slot->address = NULL;
+      (*ring)->count++;
+      // Space is allocated once, so writing checkpoint into slot doesn't change file metadata.
+      if (size > 0 && posix_fallocate(slot->fd, 0, size) != 0) {
+         mpi_log_error("Unable to allocate disk space for file '%s'.", file_name);
+         free(file_name);
+         close_checkpoint_slots(*ring);
+         *ring = NULL;
+         call_comm_errhandler(comm, MPI_ERR_NO_SPACE);
+         return MPI_ERR_NO_SPACE;
+      }
+      fsync(slot->fd);
+      // Use memory mapping only if file is placed in persistent memory, otherwise page cache would be involved anyway.
+      if (size > 0) {
+         slot->address = pmem_map(slot->fd);
+      }
+      if (slot->address != NULL && !pmem_is_pmem(slot->address, size)) {
+         munmap(slot->address, size);
+         slot->address = NULL;
+      }
+      mpi_log_debug("Checkpoint slot file '%s' %s.", file_name, slot->address != NULL ? "mapped" : "opened");
+      free(file_name);
+   }
+
+   // Slot files are created only once, directory is synchronized here instead of after every checkpoint.
+   root_file_descriptor = open(mpi_pmem_root_path, O_RDONLY);
+   fsync(root_file_descriptor);
+   close(root_file_descriptor);
+
+   return MPI_SUCCESS;
+}
+
+int find_free_checkpoint_slot(MPI_Win_pmem_slot_ring *ring, MPI_Win_pmem_version *versions, int versions_count) {
+   int i, j, slot;
+   bool used;
+
+   for (i = 0; i < ring->count; i++) {
+      slot = (ring->next_slot + i) % ring->count;
+      used = false;
+      for (j = 0; j < versions_count && !used; j++) {
+         used = versions[j].flags == MPI_PMEM_FLAG_OBJECT_EXISTS && versions[j].format == MPI_PMEM_CHECKPOINT_SLOT && versions[j].parent_version == slot;
+      }
+      if (!used) {
+         ring->next_slot = (slot + 1) % ring->count;
+         return slot;
+      }
+   }
+   mpi_log_debug("All %d checkpoint slots are used.", ring->count);
+
+   return -1;
+}
+
+void open_slot_writer(MPI_Win_pmem_slot_ring *ring, int slot, MPI_Comm comm, MPI_Win_pmem_copy_pool *pool, MPI_Win_pmem_checkpoint_writer *writer) {
+   open_reused_checkpoint_writer(comm, ring->slots[slot].fd, ring->slots[slot].address, ring->size, pool, writer);
+}
+
+void close_checkpoint_slots(MPI_Win_pmem_slot_ring *ring) {
+   int i;
+
+   if (ring == NULL) {
+      return;
+   }
+   for (i = 0; i < ring->count; i++) {
+      if (ring->slots[i].address != NULL) {
+         munmap(ring->slots[i].address, ring->size);
+      }
+      close(ring->slots[i].fd);
+   }
+   free(ring);
+}
+
+void remove_checkpoint_slots(MPI_Comm comm, const char *name) {
+   int slot;
+   char *file_name;
+
+   // Slot files are numbered from 0 without gaps.
+   for (slot = 0; get_slot_file_name(comm, name, slot, &file_name) == MPI_SUCCESS; slot++) {
+      if (!reclaim_file(mpi_pmem_root_path, file_name)) {
+         free(file_name);
+         break;
+      }
+      mpi_log_debug("Checkpoint slot file '%s' deleted.", file_name);
+      free(file_name);
+   }
+}
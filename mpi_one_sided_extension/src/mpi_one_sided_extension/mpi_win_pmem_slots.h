@@ -0,0 +1,121 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_SLOTS_H__
+#define __MPI_WIN_PMEM_SLOTS_H__
+
+#include <mpi.h>
+#include "mpi_win_pmem.h"
+#include "mpi_win_pmem_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Preallocated checkpoint file reused by checkpoints of different versions.
+typedef struct {
+   int fd;
+   void *address;    // Address of slot file mapped in persistent memory (NULL if file is written with write).
+} MPI_Win_pmem_checkpoint_slot;
+
+// Ring of preallocated checkpoint files named .<name>-slot-<index>. Plain full checkpoints are written to free slots round-robin, so steady-state checkpoints
+// neither create nor remove files. Version record of checkpoint saved in slot has format MPI_PMEM_CHECKPOINT_SLOT and index of slot as its parent version.
+struct MPI_Win_pmem_slot_ring_structure {
+   int count;        // Number of slots.
+   MPI_Aint size;    // Size of every slot file (size of window).
+   int next_slot;    // Slot used by next checkpoint if it is free.
+   MPI_Win_pmem_checkpoint_slot slots[];
+};
+
+/**
+ * Create name of slot file.
+ *
+ * @param comm       Communicator used for error handling.
+ * @param name       Window's name.
+ * @param slot       Index of slot.
+ * @param file_name  Output variable for file name. Must be freed by the caller.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int get_slot_file_name(MPI_Comm comm, const char *name, int slot, char **file_name);
+
+/**
+ * Open (create if needed) and preallocate all slot files of window and map the ones placed in persistent memory. Existing slot files keep their contents.
+ *
+ * @param comm   Communicator used for error handling.
+ * @param name   Window's name.
+ * @param count  Number of slots.
+ * @param size   Size of window.
+ * @param ring   Output variable for ring of slots. Must be freed by close_checkpoint_slots.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int open_checkpoint_slots(MPI_Comm comm, const char *name, int count, MPI_Aint size, MPI_Win_pmem_slot_ring **ring);
+
+/**
+ * Find slot which doesn't contain any existing checkpoint version, starting from slot following the one used last time.
+ *
+ * @param ring            Ring of slots.
+ * @param versions        Memory address of mapped window's versions metadata file.
+ * @param versions_count  Number of records in window's versions metadata file (without terminating record).
+ *
+ * @returns Index of free slot or -1 if all slots are used.
+ */
+int find_free_checkpoint_slot(MPI_Win_pmem_slot_ring *ring, MPI_Win_pmem_version *versions, int versions_count);
+
+/**
+ * Prepare writer of checkpoint saved in slot. Slot file stays opened (and mapped) after writer is closed.
+ *
+ * @param ring    Ring of slots.
+ * @param slot    Index of slot.
+ * @param comm    Communicator used for error handling.
+ * @param pool    Pool of threads used to copy data (may be NULL).
+ * @param writer  Output variable for writer.
+ */
+void open_slot_writer(MPI_Win_pmem_slot_ring *ring, int slot, MPI_Comm comm, MPI_Win_pmem_copy_pool *pool, MPI_Win_pmem_checkpoint_writer *writer);
+
+/**
+ * Unmap and close all slot files.
+ *
+ * @param ring  Ring of slots (may be NULL).
+ */
+void close_checkpoint_slots(MPI_Win_pmem_slot_ring *ring);
+
+/**
+ * Delete all slot files of window.
+ *
+ * @param comm  Communicator used for error handling.
+ * @param name  Window's name.
+ */
+void remove_checkpoint_slots(MPI_Comm comm, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
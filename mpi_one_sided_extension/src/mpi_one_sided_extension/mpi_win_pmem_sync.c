@@ -29,9 +29,14 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "mpi_win_pmem.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <libpmem.h>
 #include "../common/logger.h"
+#include "../common/util.h"
 #include "mpi_win_pmem_helper.h"
+#include "mpi_win_pmem_persist.h"
+#include "mpi_win_pmem_dirty.h"
+#include "mpi_win_pmem_schedule.h"
+#include "mpi_win_pmem_areas.h"
+#include "mpi_win_pmem_lazy.h"
 
 /**
  * Force any changes made to the window data to be stored durably in persistent memory.
@@ -40,32 +45,123 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  * @returns Error code as described in MPI specification.
  */
-int MPI_Win_pmem_persist(MPI_Win_pmem win) {
-   MPI_Win_memory_areas_list *current_item;
+static int persist_window(MPI_Win_pmem win) {
+   MPI_Win_memory_areas_list *current_item, *next_item;
+   uintptr_t end, next_end;
+   MPI_Win_pmem_persist_batch batch;
 
    if (win.is_pmem && !win.is_volatile && !win.allocate_in_ram) {
       mpi_log_debug("Persisting window.");
-      for (current_item = win.modifiable_values->memory_areas; current_item != NULL; current_item = current_item->next) {
-         if (current_item->is_pmem) {
-            mpi_log_debug("Persisting memory area with base: 0x%lx, size: %lu using pmem_persist.", (long int) current_item->base, current_item->size);
-            //pmem_persist(current_item->base, current_item->size);
-            pmem_msync(current_item->base, current_item->size);
-            pmem_drain();
-         } else {
-            mpi_log_debug("Persisting memory area with base: 0x%lx, size: %lu using pmem_msync.", (long int) current_item->base, current_item->size);
-            if (pmem_msync(current_item->base, current_item->size) != 0) {
-               mpi_log_error("Unable to msync memory area base: 0x%lx, size: %lu.", (long int) current_item->base, current_item->size);
-               MPI_Win_call_errhandler(win.win, MPI_ERR_PMEM);
-               return MPI_ERR_PMEM;
-            }
+      // Memory areas are persisted in one batch, so flushes of all pmem areas are completed with single drain.
+      init_persist_batch(&batch);
+      // Areas are visited in order of their addresses, so adjacent areas of the same kind are added to batch as one range.
+      for (current_item = find_memory_area(win, NULL); current_item != NULL; current_item = next_item) {
+         end = (uintptr_t) current_item->base + current_item->size;
+         for (next_item = current_item->index_next[0]; next_item != NULL && next_item->is_pmem == current_item->is_pmem && (uintptr_t) next_item->base <= end;
+              next_item = next_item->index_next[0]) {
+            next_end = (uintptr_t) next_item->base + next_item->size;
+            end = next_end > end ? next_end : end;
+         }
+         mpi_log_debug("Persisting memory range with base: 0x%lx, size: %lu using %s.", (long int) current_item->base, end - (uintptr_t) current_item->base,
+                       current_item->is_pmem ? "pmem_flush" : "pmem_msync");
+         if (!add_persist_range(&batch, current_item->base, end - (uintptr_t) current_item->base, current_item->is_pmem)) {
+            mpi_log_error("Unable to allocate memory.");
+            free_persist_batch(&batch);
+            call_win_errhandler(win.win, MPI_ERR_PMEM_NO_MEM);
+            return MPI_ERR_PMEM_NO_MEM;
          }
       }
+      if (!persist_batch(&batch)) {
+         free_persist_batch(&batch);
+         call_win_errhandler(win.win, MPI_ERR_PMEM);
+         return MPI_ERR_PMEM;
+      }
+      free_persist_batch(&batch);
       mpi_log_debug("Window persisted.");
    }
 
    return MPI_SUCCESS;
 }
 
+int MPI_Win_pmem_persist(MPI_Win_pmem win) {
+   int result;
+
+   result = check_lazy_restore(win);
+   CHECK_ERROR_CODE(result);
+
+   return persist_window(win);
+}
+
+/**
+ * Persist only ranges of window modified by RMA operations in completed epoch. Collective over window's communicator.
+ *
+ * @param win Window object.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int persist_dirty_ranges(MPI_Win_pmem win) {
+   int result;
+   MPI_Win_pmem_persist_batch batch;
+
+   init_persist_batch(&batch);
+   // Ranges have to be exchanged even if this window isn't persisted, because other processes wait for them.
+   result = collect_dirty_ranges(win, &batch);
+   if (result != MPI_SUCCESS) {
+      free_persist_batch(&batch);
+      return result;
+   }
+   if (win.is_pmem && !win.is_volatile && !win.allocate_in_ram) {
+      mpi_log_debug("Persisting %d dirty ranges of window.", batch.count);
+      if (!persist_batch(&batch)) {
+         free_persist_batch(&batch);
+         call_win_errhandler(win.win, MPI_ERR_PMEM);
+         return MPI_ERR_PMEM;
+      }
+   }
+   free_persist_batch(&batch);
+
+   return MPI_SUCCESS;
+}
+
+/**
+ * Persist window data and create checkpoint. Time spent is used to estimate cost of next checkpoints.
+ *
+ * @param win    Window object.
+ * @param fence  Flag specifying whether function is called from MPI_Win_fence.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int persist_and_checkpoint(MPI_Win_pmem win, bool fence) {
+   int result;
+   double start_time = MPI_Wtime();
+
+   // Failed restore of window is reported by create_checkpoint, so checkpoint created by all processes isn't left by one of them.
+   if (fence && win.modifiable_values->dirty_tracker != NULL) {
+      result = persist_dirty_ranges(win);
+   } else {
+      result = persist_window(win);
+   }
+   CHECK_ERROR_CODE(result);
+   result = create_checkpoint(win, fence);
+   CHECK_ERROR_CODE(result);
+   record_checkpoint_cost(win, start_time);
+
+   return MPI_SUCCESS;
+}
+
+int MPI_Win_pmem_wait_checkpoint(MPI_Win_pmem win) {
+   int result;
+
+   mpi_log_debug("Waiting for checkpoint.");
+
+   result = wait_for_pending_checkpoint(win);
+   CHECK_ERROR_CODE(result);
+
+   mpi_log_debug("Checkpoint completed.");
+
+   return MPI_SUCCESS;
+}
+
 int MPI_Win_fence_pmem(int assert, MPI_Win_pmem win) {
    int result;
 
@@ -73,6 +169,9 @@ int MPI_Win_fence_pmem(int assert, MPI_Win_pmem win) {
 
    result = MPI_Win_fence(assert, win.win);
    CHECK_ERROR_CODE(result);
+   compact_dirty_ranges(win);
+   result = check_lazy_restore(win);
+   CHECK_ERROR_CODE(result);
 
    mpi_log_debug("MPI_Win_fence completed.");
 
@@ -81,15 +180,24 @@ int MPI_Win_fence_pmem(int assert, MPI_Win_pmem win) {
 
 int MPI_Win_fence_pmem_persist(int assert, MPI_Win_pmem win) {
    int result;
+   bool due;
 
    mpi_log_debug("Starting MPI_Win_fence persist.");
 
    result = MPI_Win_fence(assert, win.win);
    CHECK_ERROR_CODE(result);
-   result = MPI_Win_pmem_persist(win);
-   CHECK_ERROR_CODE(result);
-   result = create_checkpoint(win, true);
+   // Checkpoint created in MPI_Win_fence is collective, so all processes decide together whether it is skipped.
+   result = is_checkpoint_due_on_all_processes(win, &due);
    CHECK_ERROR_CODE(result);
+   if (due) {
+      result = persist_and_checkpoint(win, true);
+      CHECK_ERROR_CODE(result);
+   } else {
+      // Ranges modified in this epoch are persisted by next fence which isn't skipped.
+      compact_dirty_ranges(win);
+      result = check_lazy_restore(win);
+      CHECK_ERROR_CODE(result);
+   }
 
    mpi_log_debug("MPI_Win_fence persist completed.");
 
@@ -116,6 +224,7 @@ int MPI_Win_complete_pmem(MPI_Win_pmem win) {
 
    result = MPI_Win_complete(win.win);
    CHECK_ERROR_CODE(result);
+   compact_dirty_ranges(win);
 
    mpi_log_debug("MPI_Win_complete completed.");
 
@@ -140,10 +249,10 @@ int MPI_Win_post_pmem_persist(MPI_Group group, int assert, MPI_Win_pmem win) {
 
    mpi_log_debug("Starting MPI_Win_post persist.");
 
-   result = MPI_Win_pmem_persist(win);
-   CHECK_ERROR_CODE(result);
-   result = create_checkpoint(win, false);
-   CHECK_ERROR_CODE(result);
+   if (is_checkpoint_due(win)) {
+      result = persist_and_checkpoint(win, false);
+      CHECK_ERROR_CODE(result);
+   }
    result = MPI_Win_post(group, assert, win.win);
    CHECK_ERROR_CODE(result);
 
@@ -172,10 +281,10 @@ int MPI_Win_wait_pmem_persist(MPI_Win_pmem win) {
 
    result = MPI_Win_wait(win.win);
    CHECK_ERROR_CODE(result);
-   result = MPI_Win_pmem_persist(win);
-   CHECK_ERROR_CODE(result);
-   result = create_checkpoint(win, false);
-   CHECK_ERROR_CODE(result);
+   if (is_checkpoint_due(win)) {
+      result = persist_and_checkpoint(win, false);
+      CHECK_ERROR_CODE(result);
+   }
 
    mpi_log_debug("MPI_Win_wait persist completed.");
 
@@ -202,10 +311,8 @@ int MPI_Win_test_pmem_persist(MPI_Win_pmem win, int *flag) {
 
    result = MPI_Win_test(win.win, flag);
    CHECK_ERROR_CODE(result);
-   if (*flag) {
-      result = MPI_Win_pmem_persist(win);
-      CHECK_ERROR_CODE(result);
-      result = create_checkpoint(win, false);
+   if (*flag && is_checkpoint_due(win)) {
+      result = persist_and_checkpoint(win, false);
       CHECK_ERROR_CODE(result);
    }
 
@@ -223,11 +330,23 @@ int MPI_Win_lock_all_pmem(int assert, MPI_Win_pmem win) {
 }
 
 int MPI_Win_unlock_pmem(int rank, MPI_Win_pmem win) {
-   return MPI_Win_unlock(rank, win.win);
+   int result;
+
+   result = MPI_Win_unlock(rank, win.win);
+   CHECK_ERROR_CODE(result);
+   compact_dirty_ranges(win);
+
+   return MPI_SUCCESS;
 }
 
 int MPI_Win_unlock_all_pmem(MPI_Win_pmem win) {
-   return MPI_Win_unlock_all(win.win);
+   int result;
+
+   result = MPI_Win_unlock_all(win.win);
+   CHECK_ERROR_CODE(result);
+   compact_dirty_ranges(win);
+
+   return MPI_SUCCESS;
 }
 
 int MPI_Win_flush_pmem(int rank, MPI_Win_pmem win) {
@@ -52,6 +52,7 @@ int MPI_Win_flush_all_pmem(MPI_Win_pmem win);
 int MPI_Win_flush_local_pmem(int rank, MPI_Win_pmem win);
 int MPI_Win_flush_local_all_pmem(MPI_Win_pmem win);
 int MPI_Win_sync_pmem(MPI_Win_pmem win);
+int MPI_Win_pmem_wait_checkpoint(MPI_Win_pmem win);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,123 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_throttle.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+
+/**
+ * Find physical package (socket) of CPU on which calling process is running.
+ *
+ * @returns Identifier of socket (0 if it can't be determined).
+ */
+static int current_socket(void) {
+   int cpu, socket = 0;
+   char file_name[96];
+   FILE *file;
+
+   cpu = sched_getcpu();
+   if (cpu < 0) {
+      return 0;
+   }
+   sprintf(file_name, "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+   file = fopen(file_name, "r");
+   if (file == NULL) {
+      return 0;
+   }
+   if (fscanf(file, "%d", &socket) != 1 || socket < 0) {
+      socket = 0;
+   }
+   fclose(file);
+
+   return socket;
+}
+
+int create_checkpoint_throttle(MPI_Comm comm, int writers, MPI_Win_pmem_throttle **throttle) {
+   int result, rank;
+   MPI_Comm node_comm, socket_comm;
+
+   *throttle = NULL;
+   result = MPI_Comm_rank(comm, &rank);
+   CHECK_ERROR_CODE(result);
+   result = MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+   CHECK_ERROR_CODE(result);
+   result = MPI_Comm_split(node_comm, current_socket(), rank, &socket_comm);
+   MPI_Comm_free(&node_comm);
+   CHECK_ERROR_CODE(result);
+
+   *throttle = malloc(sizeof(MPI_Win_pmem_throttle));
+   if (*throttle == NULL) {
+      mpi_log_error("Unable to allocate memory.");
+      MPI_Comm_free(&socket_comm);
+      call_comm_errhandler(comm, MPI_ERR_PMEM_NO_MEM);
+      return MPI_ERR_PMEM_NO_MEM;
+   }
+   (*throttle)->comm = socket_comm;
+   (*throttle)->writers = writers;
+   MPI_Comm_rank(socket_comm, &(*throttle)->rank);
+   MPI_Comm_size(socket_comm, &(*throttle)->size);
+   mpi_log_debug("Process %d of %d on socket, %d concurrent checkpoint writers.", (*throttle)->rank, (*throttle)->size, writers);
+   if ((*throttle)->size <= writers) {
+      free_checkpoint_throttle(*throttle);
+      *throttle = NULL;
+   }
+
+   return MPI_SUCCESS;
+}
+
+int acquire_write_token(MPI_Win_pmem_throttle *throttle) {
+   char token;
+
+   if (throttle->rank < throttle->writers) {
+      return MPI_SUCCESS;
+   }
+   mpi_log_debug("Waiting for checkpoint write token from process %d.", throttle->rank - throttle->writers);
+
+   return MPI_Recv(&token, 1, MPI_CHAR, throttle->rank - throttle->writers, MPI_PMEM_WRITE_TOKEN_TAG, throttle->comm, MPI_STATUS_IGNORE);
+}
+
+int release_write_token(MPI_Win_pmem_throttle *throttle) {
+   char token = 0;
+
+   if (throttle->rank + throttle->writers >= throttle->size) {
+      return MPI_SUCCESS;
+   }
+
+   return MPI_Send(&token, 1, MPI_CHAR, throttle->rank + throttle->writers, MPI_PMEM_WRITE_TOKEN_TAG, throttle->comm);
+}
+
+void free_checkpoint_throttle(MPI_Win_pmem_throttle *throttle) {
+   if (throttle != NULL) {
+      MPI_Comm_free(&throttle->comm);
+      free(throttle);
+   }
+}
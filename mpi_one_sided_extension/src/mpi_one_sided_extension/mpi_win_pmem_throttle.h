@@ -0,0 +1,91 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_THROTTLE_H__
+#define __MPI_WIN_PMEM_THROTTLE_H__
+
+#include <mpi.h>
+#include "mpi_win_pmem_datatypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tag of messages passing write tokens.
+#define MPI_PMEM_WRITE_TOKEN_TAG 0
+
+// Coordinator of checkpoint writes of processes sharing the same socket. Process with rank r in socket communicator writes after process r - writers
+// finished, so at most writers processes write at once and they start in staggered waves.
+struct MPI_Win_pmem_throttle_structure {
+   MPI_Comm comm;   // Processes of window running on the same socket.
+   int rank;
+   int size;
+   int writers;     // Maximum number of processes writing checkpoints concurrently.
+};
+
+/**
+ * Create coordinator of checkpoint writes. Collective over communicator of window.
+ *
+ * @param comm      Communicator of window.
+ * @param writers   Maximum number of processes of the same socket writing checkpoints concurrently.
+ * @param throttle  Output variable for coordinator (NULL if there are not more processes on socket than writers).
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int create_checkpoint_throttle(MPI_Comm comm, int writers, MPI_Win_pmem_throttle **throttle);
+
+/**
+ * Wait until process is allowed to write checkpoint. Has to be called by all processes of socket for the same checkpoint.
+ *
+ * @param throttle  Coordinator of checkpoint writes.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int acquire_write_token(MPI_Win_pmem_throttle *throttle);
+
+/**
+ * Allow next process to write checkpoint. Has to be called after acquire_write_token even if it or writing checkpoint failed.
+ *
+ * @param throttle  Coordinator of checkpoint writes.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int release_write_token(MPI_Win_pmem_throttle *throttle);
+
+/**
+ * Free coordinator of checkpoint writes. Collective over communicator of window.
+ *
+ * @param throttle  Coordinator of checkpoint writes (may be NULL).
+ */
+void free_checkpoint_throttle(MPI_Win_pmem_throttle *throttle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
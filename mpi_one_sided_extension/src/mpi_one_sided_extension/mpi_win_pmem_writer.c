@@ -0,0 +1,202 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "mpi_win_pmem_writer.h"
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <libpmem.h>
+#include "../common/error_codes.h"
+#include "../common/logger.h"
+#include "../common/util.h"
+#include "mpi_win_pmem.h"
+#include "mpi_win_pmem_reclaim.h"
+
+int open_checkpoint_writer(MPI_Comm comm, const char *file_name, MPI_Aint size, MPI_Win_pmem_copy_pool *pool, MPI_Win_pmem_checkpoint_writer *writer) {
+   writer->comm = comm;
+   writer->pool = pool;
+   writer->address = NULL;
+   writer->size = size;
+   writer->offset = 0;
+   writer->rate = 0.0;
+   writer->start_time = 0.0;
+   writer->start_offset = 0;
+   writer->reused = false;
+
+   // Overwritten checkpoint is unlinked instead of truncated, so windows mapping it privately keep their data. Usually file doesn't exist yet.
+   if (access(file_name, F_OK) == 0) {
+      reclaim_file(mpi_pmem_root_path, file_name);
+   }
+   if ((writer->fd = open(file_name, O_CREAT | O_RDWR | O_TRUNC, 0666)) < 0) {
+      mpi_log_error("Unable to open checkpoint file '%s'.", file_name);
+      call_comm_errhandler(comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   if (size == 0) {
+      return MPI_SUCCESS;
+   }
+
+   // Allocate space for the whole checkpoint up front.
+   if (posix_fallocate(writer->fd, 0, size) != 0) {
+      mpi_log_error("Unable to allocate disk space for file '%s'.", file_name);
+      close(writer->fd);
+      call_comm_errhandler(comm, MPI_ERR_NO_SPACE);
+      return MPI_ERR_NO_SPACE;
+   }
+
+   // Use memory mapping only if file is placed in persistent memory, otherwise page cache would be involved anyway.
+   writer->address = pmem_map(writer->fd);
+   if (writer->address != NULL && !pmem_is_pmem(writer->address, size)) {
+      munmap(writer->address, size);
+      writer->address = NULL;
+   }
+   if (writer->address != NULL) {
+      // Make file allocation durable, data will be persisted by non-temporal stores.
+      fsync(writer->fd);
+      mpi_log_debug("Writing checkpoint file '%s' using non-temporal stores.", file_name);
+   } else {
+      mpi_log_debug("Writing checkpoint file '%s' using write.", file_name);
+   }
+
+   return MPI_SUCCESS;
+}
+
+void open_reused_checkpoint_writer(MPI_Comm comm, int fd, void *address, MPI_Aint size, MPI_Win_pmem_copy_pool *pool, MPI_Win_pmem_checkpoint_writer *writer) {
+   writer->comm = comm;
+   writer->pool = pool;
+   writer->fd = fd;
+   writer->address = address;
+   writer->size = size;
+   writer->offset = 0;
+   writer->rate = 0.0;
+   writer->start_time = 0.0;
+   writer->start_offset = 0;
+   writer->reused = true;
+}
+
+void limit_checkpoint_writer_rate(MPI_Win_pmem_checkpoint_writer *writer, double rate) {
+   writer->rate = rate;
+   writer->start_time = MPI_Wtime();
+   writer->start_offset = writer->offset;
+}
+
+/**
+ * Copy data to checkpoint file at current offset.
+ *
+ * @param writer  Checkpoint writer.
+ * @param data    Data to write.
+ * @param size    Size of data.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+static int copy_checkpoint_data(MPI_Win_pmem_checkpoint_writer *writer, const void *data, MPI_Aint size) {
+   if (writer->address != NULL) {
+      parallel_pmem_memcpy_nodrain(writer->pool, (char*) writer->address + writer->offset, data, size);
+   } else if (!parallel_pwrite(writer->pool, writer->fd, data, size, writer->offset)) {
+      mpi_log_error("Unable to write checkpoint data.");
+      call_comm_errhandler(writer->comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   writer->offset += size;
+
+   return MPI_SUCCESS;
+}
+
+int write_checkpoint_data(MPI_Win_pmem_checkpoint_writer *writer, const void *data, MPI_Aint size) {
+   int result;
+   MPI_Aint slice_size;
+   double delay;
+   struct timespec sleep_time;
+
+   if (writer->offset + size > writer->size) {
+      mpi_log_error("Checkpoint data exceeds declared checkpoint size %lu.", writer->size);
+      call_comm_errhandler(writer->comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   if (writer->rate <= 0.0) {
+      return copy_checkpoint_data(writer, data, size);
+   }
+
+   while (size > 0) {
+      slice_size = size < MPI_PMEM_RATE_LIMIT_SLICE ? size : MPI_PMEM_RATE_LIMIT_SLICE;
+      result = copy_checkpoint_data(writer, data, slice_size);
+      CHECK_ERROR_CODE(result);
+      data = (const char*) data + slice_size;
+      size -= slice_size;
+
+      // Sleep until time in which written data should have been written at limited rate.
+      delay = writer->start_time + (writer->offset - writer->start_offset) / writer->rate - MPI_Wtime();
+      if (delay > 0.0) {
+         sleep_time.tv_sec = (time_t) delay;
+         sleep_time.tv_nsec = (long) ((delay - sleep_time.tv_sec) * 1e9);
+         nanosleep(&sleep_time, NULL);
+      }
+   }
+
+   return MPI_SUCCESS;
+}
+
+int close_checkpoint_writer(MPI_Win_pmem_checkpoint_writer *writer) {
+   int root_file_descriptor;
+
+   // Non-temporal stores of all copies are drained once. Size of preallocated file doesn't change, so only its data is synchronized.
+   if (writer->address != NULL) {
+      pmem_drain();
+      if (!writer->reused) {
+         munmap(writer->address, writer->size);
+      }
+   } else if ((writer->reused ? fdatasync(writer->fd) : fsync(writer->fd)) != 0) {
+      mpi_log_error("Unable to synchronize checkpoint file.");
+      if (!writer->reused) {
+         close(writer->fd);
+      }
+      call_comm_errhandler(writer->comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+   if (!writer->reused) {
+      close(writer->fd);
+   }
+
+   if (writer->offset != writer->size) {
+      mpi_log_error("Checkpoint size is %lu, while %lu was declared.", writer->offset, writer->size);
+      call_comm_errhandler(writer->comm, MPI_ERR_PMEM);
+      return MPI_ERR_PMEM;
+   }
+
+   // Sync also directory containing checkpoints, unless no file was created.
+   if (writer->reused) {
+      return MPI_SUCCESS;
+   }
+   root_file_descriptor = open(mpi_pmem_root_path, O_RDONLY);
+   fsync(root_file_descriptor);
+   close(root_file_descriptor);
+
+   return MPI_SUCCESS;
+}
@@ -0,0 +1,115 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef __MPI_WIN_PMEM_WRITER_H__
+#define __MPI_WIN_PMEM_WRITER_H__
+
+#include <stdbool.h>
+#include <mpi.h>
+#include "mpi_win_pmem_parallel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size of data written at once by writer with limited rate.
+#define MPI_PMEM_RATE_LIMIT_SLICE (1 << 20)
+
+// Writer of checkpoint files. If checkpoint file is placed in persistent memory it is memory mapped and written with non-temporal stores, otherwise it is written with write and fsync.
+typedef struct {
+   MPI_Comm comm;      // Communicator used for error handling.
+   int fd;
+   void *address;      // Address of memory mapped file (NULL if file is written with write).
+   MPI_Aint size;      // Size of checkpoint file.
+   MPI_Aint offset;    // Offset at which next data will be written.
+   MPI_Win_pmem_copy_pool *pool; // Threads used to copy data (NULL if data is copied by calling thread only).
+   double rate;        // Maximum write rate in bytes per second (0 if not limited).
+   double start_time;  // Time (result of MPI_Wtime) when writing with limited rate started.
+   MPI_Aint start_offset; // Offset at which writing with limited rate started.
+   bool reused;        // File is preallocated and stays opened (and mapped) after writer is closed.
+} MPI_Win_pmem_checkpoint_writer;
+
+/**
+ * Create (or truncate) checkpoint file of specified size and prepare it for writing.
+ *
+ * @param comm       Communicator used for error handling.
+ * @param file_name  Name of checkpoint file.
+ * @param size       Size of checkpoint file. Exactly this number of bytes has to be written before writer is closed.
+ * @param pool       Pool of threads used to copy data (may be NULL).
+ * @param writer     Output variable for writer.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int open_checkpoint_writer(MPI_Comm comm, const char *file_name, MPI_Aint size, MPI_Win_pmem_copy_pool *pool, MPI_Win_pmem_checkpoint_writer *writer);
+
+/**
+ * Prepare writer of preallocated checkpoint file, which is already opened (and mapped if it is placed in persistent memory). File isn't closed by
+ * close_checkpoint_writer and directory containing it isn't synchronized, because its metadata doesn't change.
+ *
+ * @param comm     Communicator used for error handling.
+ * @param fd       Descriptor of opened checkpoint file.
+ * @param address  Address of memory mapped file (NULL if file should be written with write).
+ * @param size     Size of checkpoint file. Exactly this number of bytes has to be written before writer is closed.
+ * @param pool     Pool of threads used to copy data (may be NULL).
+ * @param writer   Output variable for writer.
+ */
+void open_reused_checkpoint_writer(MPI_Comm comm, int fd, void *address, MPI_Aint size, MPI_Win_pmem_copy_pool *pool, MPI_Win_pmem_checkpoint_writer *writer);
+
+/**
+ * Limit rate of writing data to checkpoint file. Data written from now on is split into slices and writer sleeps between them, so average rate doesn't exceed the limit.
+ *
+ * @param writer  Checkpoint writer.
+ * @param rate    Maximum write rate in bytes per second (0 if not limited).
+ */
+void limit_checkpoint_writer_rate(MPI_Win_pmem_checkpoint_writer *writer, double rate);
+
+/**
+ * Append data to checkpoint file.
+ *
+ * @param writer  Checkpoint writer.
+ * @param data    Data to write.
+ * @param size    Size of data.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int write_checkpoint_data(MPI_Win_pmem_checkpoint_writer *writer, const void *data, MPI_Aint size);
+
+/**
+ * Make checkpoint file durable and close it. Directory containing checkpoint file is synchronized as well (unless file is preallocated).
+ *
+ * @param writer  Checkpoint writer.
+ *
+ * @returns Error code as described in MPI specification.
+ */
+int close_checkpoint_writer(MPI_Win_pmem_checkpoint_writer *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
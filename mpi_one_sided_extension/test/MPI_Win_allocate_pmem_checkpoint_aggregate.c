@@ -0,0 +1,151 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include "helper.h"
+
+/**
+ * Create or open window with checkpoints aggregated per node.
+ *
+ * @param win          Window object.
+ * @param window_data  Output variable for window data.
+ * @param mode         Mode of window.
+ */
+static void open_aggregated_window(MPI_Win_pmem *win, char **window_data, const char *mode) {
+   MPI_Info info;
+
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", "test_window");
+   MPI_Info_set(info, "pmem_mode", mode);
+   MPI_Info_set(info, "pmem_checkpoint_aggregate", "true");
+   MPI_Win_allocate_pmem(1024, 1, info, MPI_COMM_WORLD, window_data, win);
+   MPI_Info_free(&info);
+}
+
+/**
+ * Check which checkpoint files of specified version exist. Node checkpoint file is owned by node leader, other processes refer to it with link.
+ *
+ * @param root_path    Root path of process.
+ * @param version      Checkpoint version.
+ * @param exists       Flag specifying whether node checkpoint file should exist.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_files(const char *root_path, int version, bool exists) {
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + 32];
+   int result = 0;
+
+   sprintf(file_name, "%s/.test_window-%d", root_path, version);
+   if (check_if_file_exist(file_name)) {
+      mpi_log_error("Checkpoint file '%s' exists, while checkpoint is aggregated.", file_name);
+      result = 1;
+   }
+   sprintf(file_name, "%s/.test_window-%d-node", root_path, version);
+   if (check_if_file_exist(file_name) != exists) {
+      mpi_log_error("Node checkpoint file '%s' %s.", file_name, exists ? "doesn't exist" : "exists");
+      result = 1;
+   }
+
+   return result;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   int rank, node_rank;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char value[6];
+   int flag;
+   char *win_data;
+   MPI_Comm node_comm;
+   MPI_Info info;
+   MPI_Win_pmem win;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+   sprintf(root_path, "%s/%d", argv[1], rank);
+   MPI_Win_pmem_set_root_path(root_path);
+   MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+   MPI_Comm_rank(node_comm, &node_rank);
+
+   open_aggregated_window(&win, &win_data, "expand");
+   if (!win.aggregate_checkpoints) {
+      mpi_log_error("aggregate_checkpoints is false, expected true.");
+      result = 1;
+   }
+   MPI_Win_get_info_pmem(win, &info);
+   MPI_Info_get(info, "pmem_checkpoint_aggregate", 5, value, &flag);
+   if (!flag || strcmp(value, "true") != 0) {
+      mpi_log_error("pmem_checkpoint_aggregate is not reported as true.");
+      result = 1;
+   }
+   MPI_Info_free(&info);
+
+   // Checkpoints of all processes of node are written to one file owned by node leader.
+   memset(win_data, rank + 1, 1024);
+   MPI_Win_fence_pmem_persist(0, win);
+   result |= check_checkpoint_format("test_window", 0, MPI_PMEM_CHECKPOINT_AGGREGATED, 0);
+   result |= check_files(root_path, 0, true);
+
+   // Previous version is deleted together with its node checkpoint file once all processes of node released it.
+   memset(win_data, rank + 11, 1024);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Barrier(MPI_COMM_WORLD);
+   result |= check_checkpoint_format("test_window", 1, MPI_PMEM_CHECKPOINT_AGGREGATED, 1);
+   result |= check_files(root_path, 0, false);
+   result |= check_files(root_path, 1, true);
+   MPI_Win_free_pmem(&win);
+
+   // Every process restores its own data from node checkpoint file.
+   open_aggregated_window(&win, &win_data, "checkpoint");
+   result |= check_data(win_data, 1024, rank + 11);
+   MPI_Win_free_pmem(&win);
+
+   // Node checkpoint file is kept until the last process of node deletes its version.
+   if (node_rank != 0) {
+      result |= MPI_Win_pmem_delete_version("test_window", 1);
+      result |= check_files(root_path, 1, false);
+   }
+   MPI_Barrier(MPI_COMM_WORLD);
+   if (node_rank == 0) {
+      result |= check_files(root_path, 1, true);
+      result |= MPI_Win_pmem_delete_version("test_window", 1);
+      result |= check_files(root_path, 1, false);
+   }
+
+   MPI_Comm_free(&node_comm);
+   MPI_Finalize_pmem();
+
+   return result;
+}
@@ -0,0 +1,127 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include "helper.h"
+
+/**
+ * Open existing window in checkpoint mode with global checkpoints written in background.
+ *
+ * @param win          Window object.
+ * @param window_data  Output variable for window data.
+ */
+static void open_async_window(MPI_Win_pmem *win, char **window_data) {
+   MPI_Info info;
+
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", "test_window");
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Info_set(info, "pmem_checkpoint_async", "true");
+   MPI_Info_set(info, "pmem_global_checkpoint", "true");
+   MPI_Win_allocate_pmem(1024, 1, info, MPI_COMM_WORLD, window_data, win);
+   MPI_Info_free(&info);
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   int rank, peer, global_version, flag = 0;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char buffer[1024];
+   MPI_Group world_group, peer_group;
+   MPI_Win_pmem win;
+   char *win_data;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+   sprintf(root_path, "%s/%d", argv[1], rank);
+   MPI_Win_pmem_set_root_path(root_path);
+   peer = rank == 0 ? 1 : 0;
+   MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+   MPI_Group_incl(world_group, 1, &peer, &peer_group);
+   memset(buffer, 2, 1024);
+
+   // Create window with version 0, checkpoint version 1 is written in background by all processes.
+   allocate_window(&win, (void**) &win_data, "test_window", 1024);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+   open_async_window(&win, &win_data);
+   memset(win_data, 1, 1024);
+   MPI_Win_fence_pmem_persist(0, win);
+
+   // Only processes 0 and 1 create checkpoints in PSCW epochs, so they can't commit checkpoint created in fence.
+   if (rank == 0) {
+      MPI_Win_post_pmem(peer_group, 0, win);
+      result |= MPI_Win_wait_pmem_persist(win);
+      MPI_Win_start_pmem(peer_group, 0, win);
+      MPI_Put(buffer, 1024, MPI_CHAR, peer, 0, 1024, MPI_CHAR, win.win);
+      MPI_Win_complete_pmem(win);
+   } else if (rank == 1) {
+      MPI_Win_start_pmem(peer_group, 0, win);
+      MPI_Put(buffer, 1024, MPI_CHAR, peer, 0, 1024, MPI_CHAR, win.win);
+      MPI_Win_complete_pmem(win);
+      MPI_Win_post_pmem(peer_group, 0, win);
+      while (!flag) {
+         result |= MPI_Win_test_pmem_persist(win, &flag);
+      }
+   }
+   if (rank != 2) {
+      result |= MPI_Win_pmem_wait_checkpoint(win);
+      result |= check_checkpoint_data("test_window", 1, true, 1024, 1);
+      result |= check_checkpoint_data("test_window", 2, true, 1024, 2);
+   }
+
+   // Next fence commits queued checkpoint together with process which still has it pending.
+   memset(win_data, 3, 1024);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+   result |= check_checkpoint_data("test_window", 0, false, 0, 0);
+   result |= check_checkpoint_data("test_window", 1, false, 0, 0);
+   if (rank != 2) {
+      result |= check_checkpoint_data("test_window", 2, false, 0, 0);
+      result |= check_checkpoint_data("test_window", 3, true, 1024, 3);
+   } else {
+      result |= check_checkpoint_data("test_window", 2, true, 1024, 3);
+   }
+
+   read_global_checkpoint_version(MPI_COMM_WORLD, "test_window", &global_version);
+   if (global_version != (rank != 2 ? 3 : 2)) {
+      mpi_log_error("Globally committed checkpoint version is %d.", global_version);
+      result = 1;
+   }
+
+   MPI_Group_free(&peer_group);
+   MPI_Group_free(&world_group);
+   MPI_Finalize_pmem();
+
+   return result;
+}
@@ -0,0 +1,170 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include "helper.h"
+
+/**
+ * Fill window with sparse array of doubles.
+ *
+ * @param data   Window data.
+ * @param count  Number of doubles in window.
+ */
+static void fill_sparse(double *data, int count) {
+   int i;
+
+   for (i = 0; i < count; i++) {
+      data[i] = i % 100 == 0 ? i * 0.25 : 0.0;
+   }
+}
+
+/**
+ * Check whether window contains array filled by fill_sparse.
+ *
+ * @param data   Window data.
+ * @param count  Number of doubles in window.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_sparse(const double *data, int count) {
+   int i;
+
+   for (i = 0; i < count; i++) {
+      if (data[i] != (i % 100 == 0 ? i * 0.25 : 0.0)) {
+         mpi_log_error("Element %d equals %f, expected %f.", i, data[i], i % 100 == 0 ? i * 0.25 : 0.0);
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support, i;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + 20];
+   MPI_Info info;
+   MPI_Win_pmem win;
+   char *window_name = "test_window";
+   double *win_data;
+   unsigned char *random_data;
+   int count = 128 * 1024;
+   MPI_Aint win_size = count * sizeof(double);
+   off_t file_size;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+   random_data = malloc(win_size);
+   srand(1);
+   for (i = 0; i < win_size; i++) {
+      random_data[i] = rand() & 0xff;
+   }
+
+   // Sparse data is compressed, random data is saved uncompressed.
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", window_name);
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Info_set(info, "pmem_keep_all_checkpoints", "true");
+   MPI_Info_set(info, "pmem_checkpoint_codec", "shuffle_lz");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= win.checkpoint_codec != MPI_PMEM_CODEC_SHUFFLE_LZ;
+   fill_sparse(win_data, count);
+   MPI_Win_fence_pmem_persist(0, win);
+   memcpy(win_data, random_data, win_size);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+   result |= check_checkpoint_codec(window_name, 0, MPI_PMEM_CODEC_SHUFFLE_LZ);
+   result |= check_checkpoint_codec(window_name, 1, MPI_PMEM_CODEC_NONE);
+   sprintf(file_name, "%s/.%s-0", root_path, window_name);
+   get_file_size(MPI_COMM_WORLD, file_name, &file_size);
+   if (file_size >= win_size / 10) {
+      mpi_log_error("Size of compressed checkpoint is %ld, window size is %ld.", file_size, win_size);
+      result = 1;
+   }
+   sprintf(file_name, "%s/.%s-1", root_path, window_name);
+   result |= check_if_file_exists_size_and_contents(file_name, true, win_size, false, 0);
+   if (result != 0) {
+      MPI_Info_free(&info);
+      free(random_data);
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Restore compressed checkpoint and compress it with LZ codec only.
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Info_set(info, "pmem_checkpoint_version", "0");
+   MPI_Info_set(info, "pmem_checkpoint_codec", "lz");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= check_sparse(win_data, count);
+   win_data[1] = 1.0;
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+   result |= check_checkpoint_codec(window_name, 1, MPI_PMEM_CODEC_LZ);
+   if (result != 0) {
+      MPI_Info_free(&info);
+      free(random_data);
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Restore checkpoint compressed with LZ codec.
+   MPI_Info_delete(info, "pmem_checkpoint_version");
+   MPI_Info_delete(info, "pmem_checkpoint_codec");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   result |= win_data[1] != 1.0;
+   win_data[1] = 0.0;
+   result |= check_sparse(win_data, count);
+
+   // Restore uncompressed checkpoint.
+   memcpy(win_data, random_data, win_size);
+   MPI_Win_fence_pmem_persist(0, win);
+   memset(win_data, 0, win_size);
+   MPI_Win_free_pmem(&win);
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", window_name);
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   result |= check_checkpoint_codec(window_name, 2, MPI_PMEM_CODEC_NONE);
+   result |= memcmp(win_data, random_data, win_size) != 0;
+
+   MPI_Win_free_pmem(&win);
+   free(random_data);
+   MPI_Finalize_pmem();
+
+   return result;
+}
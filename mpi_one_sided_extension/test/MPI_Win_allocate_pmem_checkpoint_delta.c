@@ -0,0 +1,182 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include "helper.h"
+
+#define VALUES_COUNT (64 * 1024 + 3)
+
+/**
+ * Fill window with values of iteration of solver. Every value of next iteration differs slightly from the previous one.
+ *
+ * @param values     Window data.
+ * @param iteration  Number of iteration.
+ */
+static void set_values(double *values, int iteration) {
+   int i;
+
+   for (i = 0; i < VALUES_COUNT; i++) {
+      values[i] = i + iteration * 1e-9 * (i % 7 + 1);
+   }
+}
+
+/**
+ * Check whether window contains values of specified iteration.
+ *
+ * @param values     Window data.
+ * @param iteration  Number of iteration.
+ * @param changed    Number of values at the beginning of window which were set to -1 after iteration.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_values(const double *values, int iteration, int changed) {
+   int i;
+
+   for (i = 0; i < VALUES_COUNT; i++) {
+      if (values[i] != (i < changed ? -1.0 : i + iteration * 1e-9 * (i % 7 + 1))) {
+         mpi_log_error("Value %d equals %f, expected value of iteration %d.", i, values[i], iteration);
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+/**
+ * Check size of checkpoint file.
+ *
+ * @param window_name         Name of the window.
+ * @param checkpoint_version  Checkpoint version to check.
+ * @param max_size            Maximum expected size of checkpoint file.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_checkpoint_size(const char *window_name, int checkpoint_version, off_t max_size) {
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 14];
+   off_t file_size;
+
+   sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, window_name, checkpoint_version);
+   get_file_size(MPI_COMM_WORLD, file_name, &file_size);
+   if (file_size > max_size) {
+      mpi_log_error("Size of checkpoint version %d equals %ld, expected at most %ld.", checkpoint_version, (long) file_size, (long) max_size);
+      return 1;
+   }
+
+   return 0;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   MPI_Info info;
+   MPI_Win_pmem win;
+   char *window_name = "test_window";
+   double *win_data;
+   MPI_Aint win_size = VALUES_COUNT * sizeof(double);
+   int i, result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Create full checkpoint, two delta checkpoints and full checkpoint again (every third checkpoint is full).
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", window_name);
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Info_set(info, "pmem_keep_all_checkpoints", "true");
+   MPI_Info_set(info, "pmem_checkpoint_delta", "true");
+   MPI_Info_set(info, "pmem_checkpoint_full_interval", "3");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= !win.delta_checkpoints;
+   set_values(win_data, 0);
+   MPI_Win_fence_pmem_persist(0, win);
+   set_values(win_data, 1);
+   MPI_Win_fence_pmem_persist(0, win);
+   for (i = 0; i < 10; i++) {
+      win_data[i] = -1.0;
+   }
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+   result |= check_checkpoint_format(window_name, 0, MPI_PMEM_CHECKPOINT_FULL, -1);
+   result |= check_checkpoint_format(window_name, 1, MPI_PMEM_CHECKPOINT_DELTA, 0);
+   result |= check_checkpoint_format(window_name, 2, MPI_PMEM_CHECKPOINT_DELTA, 1);
+   result |= check_checkpoint_format(window_name, 3, MPI_PMEM_CHECKPOINT_FULL, -1);
+   result |= check_checkpoint_size(window_name, 2, 4096);
+   if (result != 0) {
+      MPI_Info_free(&info);
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Reallocate window from end of delta chain and from its middle.
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Info_set(info, "pmem_checkpoint_version", "2");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= check_values(win_data, 1, 10);
+   MPI_Win_free_pmem(&win);
+   MPI_Info_set(info, "pmem_checkpoint_version", "1");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= check_values(win_data, 1, 0);
+   MPI_Win_free_pmem(&win);
+   if (result != 0) {
+      MPI_Info_free(&info);
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Restored full checkpoint is the base of deltas written in background.
+   MPI_Info_delete(info, "pmem_checkpoint_version");
+   MPI_Info_set(info, "pmem_checkpoint_async", "true");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= check_values(win_data, 1, 10);
+   set_values(win_data, 2);
+   MPI_Win_fence_pmem_persist(0, win);
+   win_data[0] = -1.0;
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+   result |= check_checkpoint_format(window_name, 4, MPI_PMEM_CHECKPOINT_DELTA, 3);
+   result |= check_checkpoint_format(window_name, 5, MPI_PMEM_CHECKPOINT_DELTA, 4);
+   result |= check_checkpoint_size(window_name, 5, 4096);
+
+   // Reallocate window from latest checkpoint.
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   result |= check_values(win_data, 2, 1);
+
+   MPI_Win_free_pmem(&win);
+   MPI_Finalize_pmem();
+
+   return result;
+}
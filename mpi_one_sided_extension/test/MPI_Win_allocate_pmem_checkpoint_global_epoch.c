@@ -0,0 +1,164 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include "helper.h"
+
+/**
+ * Open existing window in checkpoint mode with global checkpoints.
+ *
+ * @param win          Window object.
+ * @param window_data  Output variable for window data.
+ */
+static void open_global_window(MPI_Win_pmem *win, char **window_data) {
+   MPI_Info info;
+
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", "test_window");
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Info_set(info, "pmem_global_checkpoint", "true");
+   MPI_Win_allocate_pmem(1024, 1, info, MPI_COMM_WORLD, window_data, win);
+   MPI_Info_free(&info);
+}
+
+/**
+ * Check globally committed checkpoint version saved in global epoch record.
+ *
+ * @param expected_version  Expected checkpoint version (-1 if there should be none).
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_global_version(int expected_version) {
+   int version;
+
+   read_global_checkpoint_version(MPI_COMM_WORLD, "test_window", &version);
+   if (version != expected_version) {
+      mpi_log_error("Globally committed checkpoint version is %d, expected %d.", version, expected_version);
+      return 1;
+   }
+
+   return 0;
+}
+
+/**
+ * Overwrite global epoch record of calling process, e.g. with previous epoch as if process crashed before it stored the latest one.
+ *
+ * @param version  Checkpoint version saved in record.
+ * @param epoch    Number of global commits saved in record.
+ */
+static void set_global_epoch(int version, int epoch) {
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 9];
+   MPI_Win_pmem_epoch *record;
+
+   sprintf(file_name, "%s/.test_window-global", mpi_pmem_root_path);
+   open_pmem_file(MPI_COMM_WORLD, file_name, sizeof(MPI_Win_pmem_epoch), (void**) &record);
+   store_global_epoch(MPI_COMM_WORLD, record, version, epoch);
+   unmap_pmem_file(MPI_COMM_WORLD, record, sizeof(MPI_Win_pmem_epoch));
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   int rank;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   MPI_Win_pmem win;
+   char *win_data;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+   sprintf(root_path, "%s/%d", argv[1], rank);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Create window with version 0.
+   allocate_window(&win, (void**) &win_data, "test_window", 1024);
+   memset(win_data, 1, 1024);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+
+   // Without global epoch record version is found by processes together.
+   open_global_window(&win, &win_data);
+   result |= check_data(win_data, 1024, 1);
+   result |= check_global_version(-1);
+   if (win.modifiable_values->global_checkpoint_version != 0) {
+      mpi_log_error("Global checkpoint version is %d, expected 0.", win.modifiable_values->global_checkpoint_version);
+      result = 1;
+   }
+
+   // Checkpoint created in MPI_Win_fence is committed globally and replaces previous version.
+   memset(win_data, 2, 1024);
+   MPI_Win_fence_pmem_persist(0, win);
+   result |= check_global_version(1);
+   result |= check_checkpoint_data("test_window", 0, false, 0, 0);
+   result |= check_checkpoint_data("test_window", 1, true, 1024, 2);
+
+   // Checkpoint created outside of MPI_Win_fence doesn't replace globally committed version.
+   memset(win_data, 3, 1024);
+   create_checkpoint(win, false);
+   result |= check_global_version(1);
+   result |= check_checkpoint_data("test_window", 1, true, 1024, 2);
+   result |= check_checkpoint_data("test_window", 2, true, 1024, 3);
+
+   // Next global commit replaces both previous versions.
+   memset(win_data, 4, 1024);
+   MPI_Win_fence_pmem_persist(0, win);
+   result |= check_global_version(3);
+   result |= check_checkpoint_data("test_window", 1, false, 0, 0);
+   result |= check_checkpoint_data("test_window", 2, false, 0, 0);
+   result |= check_checkpoint_data("test_window", 3, true, 1024, 4);
+   MPI_Win_free_pmem(&win);
+
+   // Window is restored from globally committed version.
+   open_global_window(&win, &win_data);
+   result |= check_data(win_data, 1024, 4);
+   result |= check_checkpoint_versions(win, 4, 3, 3);
+   MPI_Win_free_pmem(&win);
+
+   // Process which crashed during global commit still has previous epoch, all processes restore version of the latest one.
+   if (rank == 1) {
+      set_global_epoch(1, 1);
+   }
+   open_global_window(&win, &win_data);
+   result |= check_data(win_data, 1024, 4);
+   result |= check_checkpoint_versions(win, 4, 3, 3);
+   MPI_Win_free_pmem(&win);
+   result |= check_global_version(3);
+
+   // Deleting globally committed version invalidates global epoch record.
+   MPI_Win_pmem_delete_version("test_window", 3);
+   result |= check_global_version(-1);
+
+   MPI_Finalize_pmem();
+
+   return result;
+}
@@ -0,0 +1,144 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include "helper.h"
+
+/**
+ * Check whether window contains pattern written by fill_window_pattern.
+ *
+ * @param data   Window data.
+ * @param size   Size of window in bytes.
+ * @param shift  Value added to every byte of pattern.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_window_pattern(const char *data, MPI_Aint size, char shift) {
+   MPI_Aint i;
+
+   for (i = 0; i < size; i++) {
+      if (data[i] != (char) (i % 251 + shift)) {
+         mpi_log_error("Byte %ld equals %d, expected %d.", i, data[i], (char) (i % 251 + shift));
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+/**
+ * Fill window with pattern which differs between pages.
+ *
+ * @param data   Window data.
+ * @param size   Size of window in bytes.
+ * @param shift  Value added to every byte of pattern.
+ */
+static void fill_window_pattern(char *data, MPI_Aint size, char shift) {
+   MPI_Aint i;
+
+   for (i = 0; i < size; i++) {
+      data[i] = (char) (i % 251 + shift);
+   }
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + 20];
+   struct stat file_status;
+   MPI_Info info;
+   MPI_Win_pmem win;
+   char *window_name = "test_window";
+   char *win_data;
+   MPI_Aint win_size = 3 * 1024 * 1024 + 123;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Create checkpoint of window allocated in RAM.
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_allocate_in_ram", "true");
+   MPI_Info_set(info, "pmem_name", window_name);
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   fill_window_pattern(win_data, win_size, 0);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+
+   // Restore checkpoint on demand, last page is touched before the rest of window is prefetched.
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Info_set(info, "pmem_restore_lazy", "true");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= !win.lazy_restore || win.modifiable_values->lazy_restore == NULL;
+   result |= win_data[win_size - 1] != (char) ((win_size - 1) % 251);
+   result |= check_window_pattern(win_data, win_size, 0);
+   fill_window_pattern(win_data, win_size, 1);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+
+   // Checkpoint created from lazily restored window is restored by copying.
+   MPI_Info_set(info, "pmem_restore_lazy", "false");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= win.modifiable_values->lazy_restore != NULL;
+   result |= check_window_pattern(win_data, win_size, 1);
+   MPI_Win_free_pmem(&win);
+
+   // Window restored from truncated checkpoint isn't persisted nor checkpointed, so last checkpoint isn't replaced.
+   sprintf(file_name, "%s/.%s-1", root_path, window_name);
+   if (truncate(file_name, win_size - 5000) != 0) {
+      mpi_log_error("Unable to truncate file '%s'.", file_name);
+      result = 1;
+   }
+   MPI_Info_set(info, "pmem_restore_lazy", "true");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   MPI_Win_set_errhandler(win.win, MPI_ERRORS_RETURN);
+   result |= win.modifiable_values->lazy_restore == NULL;
+   result |= win_data[win_size - 1] != 0;
+   if (MPI_Win_fence_pmem_persist(0, win) == MPI_SUCCESS) {
+      mpi_log_error("Window restored from truncated checkpoint was persisted.");
+      result = 1;
+   }
+   MPI_Win_free_pmem(&win);
+   if (stat(file_name, &file_status) != 0 || file_status.st_size != win_size - 5000) {
+      mpi_log_error("Checkpoint file '%s' was replaced.", file_name);
+      result = 1;
+   }
+
+   MPI_Finalize_pmem();
+
+   return result;
+}
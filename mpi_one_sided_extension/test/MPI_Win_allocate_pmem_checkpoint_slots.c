@@ -0,0 +1,186 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include "helper.h"
+
+/**
+ * Check whether window contains only specified value.
+ *
+ * @param win_data  Window data.
+ * @param win_size  Size of window.
+ * @param value     Expected value.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_values(const char *win_data, MPI_Aint win_size, char value) {
+   MPI_Aint i;
+
+   for (i = 0; i < win_size; i++) {
+      if (win_data[i] != value) {
+         mpi_log_error("Value at offset %ld equals %d, expected %d.", (long) i, win_data[i], value);
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+/**
+ * Get inode number of checkpoint slot file.
+ *
+ * @param window_name  Name of the window.
+ * @param slot         Index of slot.
+ *
+ * @returns Inode number or 0 if slot file doesn't exist.
+ */
+static ino_t get_slot_inode(const char *window_name, int slot) {
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 19];
+   struct stat file_stat;
+
+   sprintf(file_name, "%s/.%s-slot-%d", mpi_pmem_root_path, window_name, slot);
+   if (stat(file_name, &file_stat) != 0) {
+      mpi_log_error("Slot file '%s' doesn't exist.", file_name);
+      return 0;
+   }
+
+   return file_stat.st_ino;
+}
+
+/**
+ * Check whether checkpoint of specified version is saved in its own file.
+ *
+ * @param window_name         Name of the window.
+ * @param checkpoint_version  Checkpoint version to check.
+ * @param exists              Whether checkpoint file is expected to exist.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_checkpoint_file(const char *window_name, int checkpoint_version, bool exists) {
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 14];
+
+   sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, window_name, checkpoint_version);
+   if (check_if_file_exist(file_name) != exists) {
+      mpi_log_error("Checkpoint file '%s' %s.", file_name, exists ? "doesn't exist" : "exists");
+      return 1;
+   }
+
+   return 0;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   MPI_Info info;
+   MPI_Win_pmem win;
+   char *window_name = "test_window";
+   char *win_data;
+   MPI_Aint win_size = 1024 * 1024 + 5;
+   ino_t slot_inodes[2];
+   int i, result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Latest checkpoint is always kept, so two slots are written alternately.
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", window_name);
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Info_set(info, "pmem_checkpoint_slots", "2");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= win.checkpoint_slots != 2;
+   slot_inodes[0] = get_slot_inode(window_name, 0);
+   slot_inodes[1] = get_slot_inode(window_name, 1);
+   for (i = 0; i < 4; i++) {
+      memset(win_data, i, win_size);
+      MPI_Win_fence_pmem_persist(0, win);
+   }
+   MPI_Win_free_pmem(&win);
+   result |= check_checkpoint_format(window_name, 3, MPI_PMEM_CHECKPOINT_SLOT, 1);
+   for (i = 0; i < 4; i++) {
+      result |= check_checkpoint_file(window_name, i, false);
+   }
+   result |= slot_inodes[0] == 0 || slot_inodes[0] != get_slot_inode(window_name, 0);
+   result |= slot_inodes[1] == 0 || slot_inodes[1] != get_slot_inode(window_name, 1);
+   if (result != 0) {
+      MPI_Info_free(&info);
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Reallocate window from slot and overwrite its checkpoint.
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= check_values(win_data, win_size, 3);
+   memset(win_data, 4, win_size);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= check_values(win_data, win_size, 4);
+   MPI_Win_free_pmem(&win);
+   if (result != 0) {
+      MPI_Info_free(&info);
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // All versions are kept, so checkpoints are saved in their own files once all slots are used.
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Info_set(info, "pmem_keep_all_checkpoints", "true");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   for (i = 0; i < 3; i++) {
+      memset(win_data, i + 5, win_size);
+      MPI_Win_fence_pmem_persist(0, win);
+   }
+   MPI_Win_free_pmem(&win);
+   result |= check_checkpoint_format(window_name, 0, MPI_PMEM_CHECKPOINT_SLOT, 0);
+   result |= check_checkpoint_format(window_name, 1, MPI_PMEM_CHECKPOINT_SLOT, 1);
+   result |= check_checkpoint_format(window_name, 2, MPI_PMEM_CHECKPOINT_FULL, -1);
+   result |= check_checkpoint_file(window_name, 0, false);
+   result |= check_checkpoint_file(window_name, 2, true);
+
+   // Reallocate window from older version saved in slot.
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Info_set(info, "pmem_checkpoint_version", "0");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   result |= check_values(win_data, win_size, 5);
+
+   MPI_Win_free_pmem(&win);
+   MPI_Finalize_pmem();
+
+   return result;
+}
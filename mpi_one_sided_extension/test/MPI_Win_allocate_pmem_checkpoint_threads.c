@@ -0,0 +1,100 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include "helper.h"
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   MPI_Info info;
+   MPI_Win_pmem win;
+   char *window_name = "test_window";
+   char *win_data;
+   MPI_Aint half_size = 8 * 1024 * 1024 + 100;
+   MPI_Aint win_size = 2 * half_size;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Allocate window and create checkpoint using 4 threads.
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", window_name);
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Info_set(info, "pmem_checkpoint_threads", "4");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= win.checkpoint_threads != 4;
+   memset(win_data, 1, half_size);
+   memset(win_data + half_size, 2, half_size);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+   if (result != 0) {
+      MPI_Info_free(&info);
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Restore window using 3 threads and create next checkpoint in background.
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Info_set(info, "pmem_checkpoint_threads", "3");
+   MPI_Info_set(info, "pmem_checkpoint_async", "true");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= check_data(win_data, half_size, 1);
+   result |= check_data(win_data + half_size, half_size, 2);
+   memset(win_data, 3, half_size);
+   MPI_Win_fence_pmem_persist(0, win);
+   memset(win_data, 4, half_size);
+   result |= MPI_Win_pmem_wait_checkpoint(win);
+   MPI_Win_free_pmem(&win);
+   if (result != 0) {
+      MPI_Info_free(&info);
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Restore window using single thread.
+   MPI_Info_delete(info, "pmem_checkpoint_threads");
+   MPI_Info_delete(info, "pmem_checkpoint_async");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   result |= check_data(win_data, half_size, 3);
+   result |= check_data(win_data + half_size, half_size, 2);
+   result |= check_checkpoint_versions(win, 2, 1, 1);
+
+   MPI_Win_free_pmem(&win);
+   MPI_Finalize_pmem();
+
+   return result;
+}
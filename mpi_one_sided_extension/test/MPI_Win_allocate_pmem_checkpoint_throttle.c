@@ -0,0 +1,177 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_throttle.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_writer.h>
+#include "helper.h"
+
+/**
+ * Get time of monotonic clock, which is shared by all processes on the same node (unlike MPI_Wtime).
+ *
+ * @returns Time in seconds.
+ */
+static double node_time(void) {
+   struct timespec time;
+
+   clock_gettime(CLOCK_MONOTONIC, &time);
+
+   return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+/**
+ * Check that processes on the same socket don't hold write token at the same time, if only one writer is allowed.
+ *
+ * @param throttle  Coordinator of checkpoint writes.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_tokens(MPI_Win_pmem_throttle *throttle) {
+   int i;
+   double interval[2];
+   double *intervals;
+   int result = 0;
+
+   intervals = malloc(2 * throttle->size * sizeof(double));
+   acquire_write_token(throttle);
+   interval[0] = node_time();
+   usleep(50000);
+   interval[1] = node_time();
+   release_write_token(throttle);
+   MPI_Allgather(interval, 2, MPI_DOUBLE, intervals, 2, MPI_DOUBLE, throttle->comm);
+
+   // Process holds token only after previous one released it.
+   for (i = 1; i < throttle->size; i++) {
+      if (intervals[2 * i] < intervals[2 * i - 1]) {
+         mpi_log_error("Process %d acquired write token before process %d released it.", i, i - 1);
+         result = 1;
+      }
+   }
+   free(intervals);
+
+   return result;
+}
+
+/**
+ * Check that checkpoint writer with limited rate doesn't write faster than the limit.
+ *
+ * @param root_path  Directory in which test file is created.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_rate(const char *root_path) {
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + 16];
+   char *data;
+   double start_time, elapsed;
+   MPI_Win_pmem_checkpoint_writer writer;
+   int result = 0;
+
+   sprintf(file_name, "%s/rate_test", root_path);
+   data = calloc(512 * 1024, 1);
+   open_checkpoint_writer(MPI_COMM_WORLD, file_name, 512 * 1024, NULL, &writer);
+   limit_checkpoint_writer_rate(&writer, 1048576.0);
+   start_time = MPI_Wtime();
+   write_checkpoint_data(&writer, data, 512 * 1024);
+   elapsed = MPI_Wtime() - start_time;
+   close_checkpoint_writer(&writer);
+   if (elapsed < 0.45) {
+      mpi_log_error("512 KB were written in %f seconds with rate limited to 1 MB/s.", elapsed);
+      result = 1;
+   }
+   remove(file_name);
+   free(data);
+
+   return result;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   int rank;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char value[11];
+   int flag;
+   char *win_data;
+   MPI_Info info;
+   MPI_Win_pmem win;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+   sprintf(root_path, "%s/%d", argv[1], rank);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", "test_window");
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Info_set(info, "pmem_keep_all_checkpoints", "true");
+   MPI_Info_set(info, "pmem_checkpoint_async", "true");
+   MPI_Info_set(info, "pmem_checkpoint_writers", "1");
+   MPI_Info_set(info, "pmem_checkpoint_rate", "1");
+   MPI_Win_allocate_pmem(1024, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   if (win.checkpoint_writers != 1 || win.checkpoint_rate != 1) {
+      mpi_log_error("checkpoint_writers is %d and checkpoint_rate is %d, expected 1 and 1.", win.checkpoint_writers, win.checkpoint_rate);
+      result = 1;
+   }
+   MPI_Win_get_info_pmem(win, &info);
+   MPI_Info_get(info, "pmem_checkpoint_writers", 10, value, &flag);
+   if (!flag || strcmp(value, "1") != 0) {
+      mpi_log_error("pmem_checkpoint_writers is not reported as 1.");
+      result = 1;
+   }
+   MPI_Info_free(&info);
+
+   // Processes running on other sockets write concurrently, so tokens are checked only among processes sharing socket.
+   if (win.modifiable_values->throttle != NULL) {
+      result |= check_tokens(win.modifiable_values->throttle);
+   }
+
+   // Throttled checkpoints are complete and contain data of each process.
+   memset(win_data, rank + 1, 1024);
+   MPI_Win_fence_pmem_persist(0, win);
+   memset(win_data, rank + 11, 1024);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+   result |= check_checkpoint_data("test_window", 0, true, 1024, rank + 1);
+   result |= check_checkpoint_data("test_window", 1, true, 1024, rank + 11);
+
+   result |= check_rate(root_path);
+
+   MPI_Finalize_pmem();
+
+   return result;
+}
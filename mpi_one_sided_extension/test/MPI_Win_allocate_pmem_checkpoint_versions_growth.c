@@ -0,0 +1,99 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include "helper.h"
+
+#define CHECKPOINTS_COUNT 40
+
+int main(int argc, char *argv[]) {
+   int thread_support, i;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + 20];
+   MPI_Info info;
+   MPI_Win_pmem win;
+   char *window_name = "test_window";
+   char *win_data;
+   MPI_Aint win_size = 1024;
+   off_t file_size;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Create many checkpoints with versions metadata file kept mapped by window.
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", window_name);
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Info_set(info, "pmem_keep_all_checkpoints", "true");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   for (i = 0; i < CHECKPOINTS_COUNT; i++) {
+      memset(win_data, i, win_size);
+      MPI_Win_fence_pmem_persist(0, win);
+   }
+   MPI_Win_free_pmem(&win);
+
+   // Versions metadata file grows geometrically.
+   sprintf(file_name, "%s/.%s", root_path, window_name);
+   get_file_size(MPI_COMM_WORLD, file_name, &file_size);
+   if (file_size < (off_t) ((CHECKPOINTS_COUNT + 1) * sizeof(MPI_Win_pmem_version)) || file_size > (off_t) (2 * (CHECKPOINTS_COUNT + 1) * sizeof(MPI_Win_pmem_version))) {
+      mpi_log_error("Size of versions metadata file is %ld, expected space for %d versions.", file_size, CHECKPOINTS_COUNT + 1);
+      result = 1;
+   }
+   for (i = 0; i < CHECKPOINTS_COUNT; i++) {
+      result |= check_checkpoint_data(window_name, i, true, win_size, i);
+   }
+   if (result != 0) {
+      MPI_Info_free(&info);
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Restore checkpoint from the middle and the newest one.
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Info_set(info, "pmem_checkpoint_version", "17");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= win_data[0] != 17 || win_data[win_size - 1] != 17;
+   MPI_Win_free_pmem(&win);
+   MPI_Info_delete(info, "pmem_checkpoint_version");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   result |= win.modifiable_values->last_checkpoint_version != CHECKPOINTS_COUNT - 1;
+   result |= win_data[0] != CHECKPOINTS_COUNT - 1 || win_data[win_size - 1] != CHECKPOINTS_COUNT - 1;
+
+   MPI_Win_free_pmem(&win);
+   MPI_Finalize_pmem();
+
+   return result;
+}
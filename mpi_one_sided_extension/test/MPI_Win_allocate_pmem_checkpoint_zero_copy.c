@@ -0,0 +1,126 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include "helper.h"
+
+/**
+ * Check whether every byte of window equals specified value.
+ *
+ * @param data   Window data.
+ * @param size   Size of window in bytes.
+ * @param value  Expected value.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_window_data(const char *data, MPI_Aint size, char value) {
+   MPI_Aint i;
+
+   for (i = 0; i < size; i++) {
+      if (data[i] != value) {
+         mpi_log_error("Byte %ld equals %d, expected %d.", i, data[i], value);
+         return 1;
+      }
+   }
+
+   return 0;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   MPI_Info info;
+   MPI_Win_pmem win;
+   char *window_name = "test_window";
+   char *win_data;
+   MPI_Aint win_size = 4 * 1024 * 1024;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Create two checkpoints.
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", window_name);
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Info_set(info, "pmem_keep_all_checkpoints", "true");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   memset(win_data, 'a', win_size);
+   MPI_Win_fence_pmem_persist(0, win);
+   memset(win_data, 'b', win_size);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+
+   // Use first checkpoint as window, modifications must not change it.
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Info_set(info, "pmem_checkpoint_version", "0");
+   MPI_Info_set(info, "pmem_restore_zero_copy", "true");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= !win.zero_copy_restore;
+   result |= check_window_data(win_data, win_size, 'a');
+   memset(win_data, 'c', win_size);
+   MPI_Win_fence_pmem_persist(0, win);
+   result |= check_checkpoint_data(window_name, 0, true, win_size, 'a');
+   result |= check_checkpoint_data(window_name, 1, true, win_size, 'c');
+   MPI_Win_free_pmem(&win);
+   if (result != 0) {
+      MPI_Info_free(&info);
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Use newest checkpoint as window and delete it while it is mapped.
+   MPI_Info_delete(info, "pmem_checkpoint_version");
+   MPI_Info_set(info, "pmem_keep_all_checkpoints", "false");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= check_window_data(win_data, win_size, 'c');
+   win_data[0] = 'd';
+   MPI_Win_fence_pmem_persist(0, win);
+   result |= check_checkpoint_data(window_name, 1, false, 0, 0);
+   win_data[0] = 'c';
+   result |= check_window_data(win_data, win_size, 'c');
+   MPI_Win_free_pmem(&win);
+
+   // Copy checkpoint into window.
+   MPI_Info_set(info, "pmem_restore_zero_copy", "false");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   result |= win_data[0] != 'd';
+   win_data[0] = 'c';
+   result |= check_window_data(win_data, win_size, 'c');
+
+   MPI_Win_free_pmem(&win);
+   MPI_Finalize_pmem();
+
+   return result;
+}
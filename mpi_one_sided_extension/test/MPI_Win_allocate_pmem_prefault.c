@@ -0,0 +1,108 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include "helper.h"
+
+#define WINDOW_SIZE (5 * 1024 * 1024 + 100)
+
+/**
+ * Create or open window which is prefaulted by pool of threads.
+ *
+ * @param win          Window object.
+ * @param window_data  Output variable for window data.
+ * @param mode         Mode of window.
+ */
+static void open_prefaulted_window(MPI_Win_pmem *win, char **window_data, const char *mode) {
+   MPI_Info info;
+
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", "test_window");
+   MPI_Info_set(info, "pmem_mode", mode);
+   MPI_Info_set(info, "pmem_map_sync", "true");
+   MPI_Info_set(info, "pmem_prefault", "true");
+   MPI_Info_set(info, "pmem_checkpoint_threads", "2");
+   MPI_Win_allocate_pmem(WINDOW_SIZE, 1, info, MPI_COMM_WORLD, window_data, win);
+   MPI_Info_free(&info);
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char value[6];
+   int flag;
+   char *win_data;
+   MPI_Info info;
+   MPI_Win_pmem win;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Window larger than huge page is mapped at aligned address and prefaulting doesn't change its data.
+   open_prefaulted_window(&win, &win_data, "expand");
+   if ((uintptr_t) win_data % MPI_PMEM_HUGE_PAGE_SIZE != 0) {
+      mpi_log_error("Window data at 0x%lx isn't aligned to huge page.", (long int) win_data);
+      result = 1;
+   }
+   MPI_Win_get_info_pmem(win, &info);
+   MPI_Info_get(info, "pmem_prefault", 5, value, &flag);
+   if (!flag || strcmp(value, "true") != 0) {
+      mpi_log_error("pmem_prefault is not reported as true.");
+      result = 1;
+   }
+   MPI_Info_get(info, "pmem_map_sync", 5, value, &flag);
+   if (!flag || strcmp(value, "true") != 0) {
+      mpi_log_error("pmem_map_sync is not reported as true.");
+      result = 1;
+   }
+   MPI_Info_free(&info);
+   memset(win_data, 1, WINDOW_SIZE);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+   result |= check_data_file("test_window", true, WINDOW_SIZE, true, 1);
+
+   open_prefaulted_window(&win, &win_data, "checkpoint");
+   result |= check_data(win_data, WINDOW_SIZE, 1);
+   memset(win_data, 2, WINDOW_SIZE);
+   MPI_Win_free_pmem(&win);
+
+   open_prefaulted_window(&win, &win_data, "expand");
+   result |= check_data(win_data, WINDOW_SIZE, 2);
+   MPI_Win_free_pmem(&win);
+
+   MPI_Finalize_pmem();
+
+   return result;
+}
@@ -0,0 +1,199 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include "helper.h"
+
+#define STRIPE_SIZE 8192
+#define STRIPES_COUNT 6
+#define WINDOW_SIZE (STRIPES_COUNT * STRIPE_SIZE - 100)
+
+/**
+ * Create or open striped window.
+ *
+ * @param win          Window object.
+ * @param window_data  Output variable for window data.
+ * @param mode         Mode of window.
+ */
+static void open_striped_window(MPI_Win_pmem *win, char **window_data, const char *mode) {
+   MPI_Info info;
+
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", "test_window");
+   MPI_Info_set(info, "pmem_mode", mode);
+   MPI_Info_set(info, "pmem_stripe_size", "8000");
+   MPI_Win_allocate_pmem(WINDOW_SIZE, 1, info, MPI_COMM_WORLD, window_data, win);
+   MPI_Info_free(&info);
+}
+
+/**
+ * Fill every stripe of window with different value.
+ *
+ * @param window_data  Window data.
+ * @param offset       Value added to number of stripe.
+ */
+static void fill_stripes(char *window_data, int offset) {
+   int i;
+
+   for (i = 0; i < STRIPES_COUNT; i++) {
+      memset(window_data + i * STRIPE_SIZE, i + offset, i < STRIPES_COUNT - 1 ? STRIPE_SIZE : WINDOW_SIZE - i * STRIPE_SIZE);
+   }
+}
+
+/**
+ * Check that every stripe of window contains value written by fill_stripes.
+ *
+ * @param window_data  Window data.
+ * @param offset       Value added to number of stripe.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_stripes(const char *window_data, int offset) {
+   int i;
+   int result = 0;
+
+   for (i = 0; i < STRIPES_COUNT; i++) {
+      result |= check_data(window_data + i * STRIPE_SIZE, i < STRIPES_COUNT - 1 ? STRIPE_SIZE : WINDOW_SIZE - i * STRIPE_SIZE, i + offset);
+   }
+
+   return result;
+}
+
+/**
+ * Check that part of data file placed in one root path contains every second stripe of window.
+ *
+ * @param file_name  Name of part of data file.
+ * @param first      Number of first stripe placed in file.
+ * @param offset     Value added to number of stripe.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_stripe_file(const char *file_name, int first, int offset) {
+   FILE *file;
+   struct stat file_status;
+   char *data;
+   int i, stripe;
+   int result = 0;
+
+   if (stat(file_name, &file_status) != 0 || file_status.st_size != STRIPES_COUNT / 2 * STRIPE_SIZE) {
+      mpi_log_error("File '%s' doesn't exist or doesn't have size of %d stripes.", file_name, STRIPES_COUNT / 2);
+      return 1;
+   }
+   data = malloc(STRIPES_COUNT / 2 * STRIPE_SIZE);
+   file = fopen(file_name, "r");
+   if (fread(data, STRIPE_SIZE, STRIPES_COUNT / 2, file) != STRIPES_COUNT / 2) {
+      mpi_log_error("Unable to read file '%s'.", file_name);
+      result = 1;
+   }
+   fclose(file);
+   for (i = 0; i < STRIPES_COUNT / 2; i++) {
+      stripe = first + 2 * i;
+      result |= check_data(data + i * STRIPE_SIZE, stripe < STRIPES_COUNT - 1 ? STRIPE_SIZE : WINDOW_SIZE - stripe * STRIPE_SIZE, stripe + offset);
+   }
+   free(data);
+
+   return result;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char namespaces[2][MPI_PMEM_MAX_ROOT_PATH + 8];
+   const char *paths[2];
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + 40];
+   char value[16];
+   int flag, local_index;
+   char *win_data;
+   MPI_Info info;
+   MPI_Win_pmem win;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   sprintf(namespaces[0], "%s/numa0", root_path);
+   sprintf(namespaces[1], "%s/numa1", root_path);
+   mkdir(namespaces[0], 0777);
+   mkdir(namespaces[1], 0777);
+   paths[0] = namespaces[0];
+   paths[1] = namespaces[1];
+   MPI_Win_pmem_set_root_paths(2, paths);
+
+   // Root path local to NUMA node of process is used for window metadata.
+   local_index = mpi_pmem_root_path_index;
+   if (mpi_pmem_root_paths_count != 2 || strcmp(mpi_pmem_root_path, namespaces[local_index]) != 0) {
+      mpi_log_error("Root path is '%s', expected '%s'.", mpi_pmem_root_path, namespaces[local_index]);
+      result = 1;
+   }
+
+   // Stripe size is rounded up to page size.
+   open_striped_window(&win, &win_data, "expand");
+   MPI_Win_get_info_pmem(win, &info);
+   MPI_Info_get(info, "pmem_stripe_size", 15, value, &flag);
+   if (!flag || atoi(value) != STRIPE_SIZE) {
+      mpi_log_error("pmem_stripe_size is not reported as %d.", STRIPE_SIZE);
+      result = 1;
+   }
+   MPI_Info_free(&info);
+   fill_stripes(win_data, 1);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_free_pmem(&win);
+
+   // Stripes are placed alternately in local and remote root path, starting with local one.
+   sprintf(file_name, "%s/test_window", namespaces[local_index]);
+   result |= check_stripe_file(file_name, 0, 1);
+   sprintf(file_name, "%s/.test_window-stripe-%d", namespaces[1 - local_index], local_index);
+   result |= check_stripe_file(file_name, 1, 1);
+
+   // Checkpoint contains contiguous data, which is restored into stripes.
+   open_striped_window(&win, &win_data, "checkpoint");
+   result |= check_stripes(win_data, 1);
+   fill_stripes(win_data, 11);
+   MPI_Win_free_pmem(&win);
+
+   // Window opened in expand mode contains data of striped data file.
+   open_striped_window(&win, &win_data, "expand");
+   result |= check_stripes(win_data, 11);
+   MPI_Win_free_pmem(&win);
+
+   // Deleted window doesn't leave its parts in other root paths.
+   MPI_Win_pmem_delete("test_window");
+   if (check_if_file_exist(file_name)) {
+      mpi_log_error("File '%s' exists after window was deleted.", file_name);
+      result = 1;
+   }
+
+   MPI_Finalize_pmem();
+
+   return result;
+}
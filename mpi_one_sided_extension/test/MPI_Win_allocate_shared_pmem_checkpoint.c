@@ -0,0 +1,129 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include "helper.h"
+
+/**
+ * Create or open shared window, in which segment of every process has different size.
+ *
+ * @param win          Window object.
+ * @param window_data  Output variable for segment of calling process.
+ * @param rank         Rank of calling process.
+ * @param mode         Mode of window.
+ */
+static void open_shared_window(MPI_Win_pmem *win, char **window_data, int rank, const char *mode) {
+   MPI_Info info;
+
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", "test_window");
+   MPI_Info_set(info, "pmem_mode", mode);
+   MPI_Win_allocate_shared_pmem((rank + 1) * 256, 1, info, MPI_COMM_WORLD, window_data, win);
+   MPI_Info_free(&info);
+}
+
+/**
+ * Check that segments of all processes are placed contiguously and are accessible by calling process.
+ *
+ * @param win          Window object.
+ * @param window_data  Segment of calling process.
+ * @param rank         Rank of calling process.
+ * @param processes    Number of processes.
+ * @param offset       Value added to rank of process filling its segment.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_segments(MPI_Win_pmem win, char *window_data, int rank, int processes, int offset) {
+   MPI_Aint size;
+   int disp_unit, i;
+   char *base, *expected_base;
+   int result = 0;
+
+   MPI_Win_shared_query_pmem(win, MPI_PROC_NULL, &size, &disp_unit, &base);
+   expected_base = base;
+   if (size != 256 || disp_unit != 1) {
+      mpi_log_error("First segment has size %lu and displacement unit %d, expected 256 and 1.", size, disp_unit);
+      result = 1;
+   }
+   for (i = 0; i < processes; i++) {
+      MPI_Win_shared_query_pmem(win, i, &size, &disp_unit, &base);
+      if (base != expected_base || size != (i + 1) * 256) {
+         mpi_log_error("Segment of process %d has address 0x%lx and size %lu, expected 0x%lx and %d.", i, (long int) base, size, (long int) expected_base, (i + 1) * 256);
+         result = 1;
+      } else {
+         result |= check_data(base, size, i + offset);
+      }
+      expected_base += (i + 1) * 256;
+   }
+   MPI_Win_shared_query_pmem(win, rank, &size, &disp_unit, &base);
+   if (base != window_data) {
+      mpi_log_error("Segment of calling process isn't placed at address returned by MPI_Win_allocate_shared_pmem.");
+      result = 1;
+   }
+
+   return result;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   int rank, processes;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char *win_data;
+   MPI_Win_pmem win;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+   MPI_Comm_size(MPI_COMM_WORLD, &processes);
+   sprintf(root_path, "%s/%d", argv[1], rank);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Data stored by every process is visible to all processes through shared mapping.
+   open_shared_window(&win, &win_data, rank, "expand");
+   memset(win_data, rank + 1, (rank + 1) * 256);
+   MPI_Win_fence_pmem_persist(0, win);
+   result |= check_segments(win, win_data, rank, processes, 1);
+   result |= check_checkpoint_data("test_window", 0, true, (rank + 1) * 256, rank + 1);
+   MPI_Win_fence_pmem(0, win);
+   memset(win_data, rank + 11, (rank + 1) * 256);
+   MPI_Win_fence_pmem(0, win);
+   MPI_Win_free_pmem(&win);
+
+   // Every process restores its own segment from its checkpoint.
+   open_shared_window(&win, &win_data, rank, "checkpoint");
+   MPI_Win_fence_pmem(0, win);
+   result |= check_segments(win, win_data, rank, processes, 1);
+   MPI_Win_free_pmem(&win);
+
+   MPI_Finalize_pmem();
+
+   return result;
+}
@@ -0,0 +1,115 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_extents.h>
+#include "helper.h"
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + MPI_PMEM_MAX_NAME + 14];
+   MPI_Info info;
+   MPI_Win_pmem win;
+   char *window_name = "test_window";
+   char area1[512], area2[1024], area3[2048];
+   MPI_Aint checkpoint_size = sizeof(MPI_Win_pmem_extents_header) + 3 * sizeof(MPI_Win_pmem_extent) + 512 + 1024 + 2048;
+   MPI_Win_pmem_version versions[1];
+   MPI_Win_pmem_metadata windows[1];
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Create dynamic window, attach 3 memory areas and create checkpoint.
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", window_name);
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Info_set(info, "pmem_keep_all_checkpoints", "true");
+   MPI_Win_create_dynamic_pmem(info, MPI_COMM_WORLD, &win);
+   memset(area1, 1, 512);
+   memset(area2, 2, 1024);
+   memset(area3, 3, 2048);
+   MPI_Win_attach_pmem(win, area1, 512);
+   MPI_Win_attach_pmem(win, area2, 1024);
+   MPI_Win_attach_pmem(win, area3, 2048);
+   MPI_Win_fence_pmem_persist(0, win);
+   MPI_Win_detach_pmem(win, area1);
+   MPI_Win_detach_pmem(win, area2);
+   MPI_Win_detach_pmem(win, area3);
+   MPI_Win_free_pmem(&win);
+
+   // Check result.
+   versions[0].flags = MPI_PMEM_FLAG_OBJECT_EXISTS;
+   versions[0].timestamp = 1;
+   versions[0].version = 0;
+   windows[0].flags = MPI_PMEM_FLAG_OBJECT_EXISTS;
+   windows[0].size = 0;
+   strcpy(windows[0].name, window_name);
+   sprintf(file_name, "%s/.%s-%d", mpi_pmem_root_path, window_name, 0);
+   result |= check_if_file_exists_size_and_contents(file_name, true, checkpoint_size, false, 0);
+   result |= check_checkpoint_format(window_name, 0, MPI_PMEM_CHECKPOINT_EXTENTS, -1);
+   result |= check_versions_metadata_file(window_name, true, versions, 1);
+   result |= check_global_metadata_file(windows, 1);
+   if (result != 0) {
+      MPI_Info_free(&info);
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Recreate window from checkpoint and attach memory areas in the same order.
+   memset(area1, 0, 512);
+   memset(area2, 0, 1024);
+   memset(area3, 0, 2048);
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Win_create_dynamic_pmem(info, MPI_COMM_WORLD, &win);
+   MPI_Info_free(&info);
+   MPI_Win_attach_pmem(win, area1, 512);
+   MPI_Win_attach_pmem(win, area2, 1024);
+   MPI_Win_attach_pmem(win, area3, 2048);
+   result |= check_data(area1, 512, 1);
+   result |= check_data(area2, 1024, 2);
+   result |= check_data(area3, 2048, 3);
+   result |= check_checkpoint_versions(win, 1, 0, 0);
+   MPI_Win_detach_pmem(win, area1);
+   MPI_Win_detach_pmem(win, area2);
+   MPI_Win_detach_pmem(win, area3);
+
+   MPI_Win_free_pmem(&win);
+   MPI_Finalize_pmem();
+
+   return result;
+}
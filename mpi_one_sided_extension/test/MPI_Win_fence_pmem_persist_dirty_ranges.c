@@ -0,0 +1,154 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_persist.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_dirty.h>
+#include "helper.h"
+
+#define WINDOW_LENGTH 2048
+
+/**
+ * Check that range in batch covers given bytes of window and is not longer than unit of flushing requires.
+ *
+ * @param batch   Batch of ranges.
+ * @param i       Index of range.
+ * @param base    Base address of window.
+ * @param begin   Beginning of modified bytes (relative to base address).
+ * @param end     End of modified bytes (relative to base address).
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_range(const MPI_Win_pmem_persist_batch *batch, int i, uintptr_t base, uintptr_t begin, uintptr_t end) {
+   uintptr_t alignment = batch->ranges[i].is_pmem ? MPI_PMEM_CACHE_LINE_SIZE : (uintptr_t) sysconf(_SC_PAGESIZE);
+
+   if (batch->ranges[i].begin > base + begin || batch->ranges[i].end < base + end || batch->ranges[i].end - batch->ranges[i].begin > end - begin + 2 * alignment) {
+      mpi_log_error("Range %d is [%lu, %lu), expected to cover [%lu, %lu).", i, batch->ranges[i].begin - base, batch->ranges[i].end - base, begin, end);
+      return 1;
+   }
+
+   return 0;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   int rank, other_rank, i;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char value[6];
+   int flag;
+   double values[4] = { 1.0, 2.0, 3.0, 4.0 };
+   double read_values[4];
+   double *win_data;
+   MPI_Info info;
+   MPI_Win_pmem win;
+   MPI_Win_pmem_persist_batch batch;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+   other_rank = 1 - rank;
+   sprintf(root_path, "%s/%d", argv[1], rank);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Allocate window with displacement unit different than 1, so conversion of displacements to bytes is checked.
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", "test_window");
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Info_set(info, "pmem_track_dirty_ranges", "true");
+   MPI_Win_allocate_pmem(WINDOW_LENGTH * sizeof(double), sizeof(double), info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   if (!win.track_dirty_ranges || win.modifiable_values->dirty_tracker == NULL) {
+      mpi_log_error("Dirty ranges are not tracked.");
+      result = 1;
+   }
+   MPI_Win_get_info_pmem(win, &info);
+   MPI_Info_get(info, "pmem_track_dirty_ranges", 5, value, &flag);
+   if (!flag || strcmp(value, "true") != 0) {
+      mpi_log_error("pmem_track_dirty_ranges is not reported as true.");
+      result = 1;
+   }
+   MPI_Info_free(&info);
+   for (i = 0; i < WINDOW_LENGTH; i++) {
+      win_data[i] = 0.0;
+   }
+
+   // Adjacent puts are merged, gets and MPI_NO_OP accumulates are not tracked.
+   MPI_Win_fence_pmem(0, win);
+   MPI_Put_pmem(values, 4, MPI_DOUBLE, other_rank, 100, 4, MPI_DOUBLE, win);
+   MPI_Put_pmem(values, 4, MPI_DOUBLE, other_rank, 104, 4, MPI_DOUBLE, win);
+   MPI_Accumulate_pmem(values, 1, MPI_DOUBLE, other_rank, 1500, 1, MPI_DOUBLE, MPI_SUM, win);
+   MPI_Get_pmem(read_values, 4, MPI_DOUBLE, other_rank, 500, 4, MPI_DOUBLE, win);
+   MPI_Get_accumulate_pmem(values, 1, MPI_DOUBLE, read_values, 1, MPI_DOUBLE, other_rank, 1000, 1, MPI_DOUBLE, MPI_NO_OP, win);
+   MPI_Win_fence_pmem(0, win);
+   init_persist_batch(&batch);
+   collect_dirty_ranges(win, &batch);
+   merge_persist_ranges(&batch);
+   if (batch.count != 2) {
+      mpi_log_error("Number of dirty ranges is %d, expected 2.", batch.count);
+      result = 1;
+   } else {
+      result |= check_range(&batch, 0, (uintptr_t) win_data, 100 * sizeof(double), 108 * sizeof(double));
+      result |= check_range(&batch, 1, (uintptr_t) win_data, 1500 * sizeof(double), 1501 * sizeof(double));
+   }
+
+   // Ranges are cleared after they are exchanged.
+   batch.count = 0;
+   collect_dirty_ranges(win, &batch);
+   if (batch.count != 0) {
+      mpi_log_error("Number of dirty ranges after second exchange is %d, expected 0.", batch.count);
+      result = 1;
+   }
+   free_persist_batch(&batch);
+
+   // Data written in epoch completed by MPI_Win_fence_pmem_persist is in window.
+   MPI_Put_pmem(values, 4, MPI_DOUBLE, other_rank, 2000, 4, MPI_DOUBLE, win);
+   MPI_Win_fence_pmem_persist(0, win);
+   for (i = 0; i < 4; i++) {
+      if (win_data[100 + i] != values[i] || win_data[104 + i] != values[i] || win_data[2000 + i] != values[i]) {
+         mpi_log_error("Window data at index %d is not equal to written value.", i);
+         result = 1;
+      }
+   }
+   if (win_data[1500] != values[0]) {
+      mpi_log_error("Window data at index 1500 equals %f, expected %f.", win_data[1500], values[0]);
+      result = 1;
+   }
+
+   MPI_Win_free_pmem(&win);
+   MPI_Finalize_pmem();
+
+   return result;
+}
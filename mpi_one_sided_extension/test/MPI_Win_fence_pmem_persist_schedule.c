@@ -0,0 +1,125 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_schedule.h>
+#include "helper.h"
+
+/**
+ * Check interval computed for specified parameters.
+ *
+ * @param cost      Time of creating checkpoint in seconds.
+ * @param mtbf      Mean time between failures in seconds.
+ * @param overhead  Maximum percentage of run time spent on checkpoints.
+ * @param expected  Expected interval.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_interval(double cost, int mtbf, int overhead, double expected) {
+   double interval = optimal_checkpoint_interval(cost, mtbf, overhead);
+
+   if (fabs(interval - expected) > 0.01) {
+      mpi_log_error("Interval for cost %f, MTBF %d and overhead %d is %f, expected %f.", cost, mtbf, overhead, interval, expected);
+      return 1;
+   }
+
+   return 0;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char value[11];
+   int flag;
+   char *win_data;
+   MPI_Info info;
+   MPI_Win_pmem win;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Daly's interval, interval extended by overhead budget and interval for checkpoints longer than MTBF.
+   result |= check_interval(10.0, 1000, 0, 134.84);
+   result |= check_interval(10.0, 1000, 50, 134.84);
+   result |= check_interval(10.0, 1000, 5, 200.0);
+   result |= check_interval(3000.0, 1000, 0, 1000.0);
+
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", "test_window");
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Info_set(info, "pmem_keep_all_checkpoints", "true");
+   MPI_Info_set(info, "pmem_checkpoint_mtbf", "86400");
+   MPI_Info_set(info, "pmem_checkpoint_overhead", "10");
+   MPI_Win_allocate_pmem(1024, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   if (win.checkpoint_mtbf != 86400 || win.checkpoint_overhead != 10) {
+      mpi_log_error("checkpoint_mtbf is %d and checkpoint_overhead is %d, expected 86400 and 10.", win.checkpoint_mtbf, win.checkpoint_overhead);
+      result = 1;
+   }
+   MPI_Win_get_info_pmem(win, &info);
+   MPI_Info_get(info, "pmem_checkpoint_mtbf", 10, value, &flag);
+   if (!flag || strcmp(value, "86400") != 0) {
+      mpi_log_error("pmem_checkpoint_mtbf is not reported as 86400.");
+      result = 1;
+   }
+   MPI_Info_free(&info);
+
+   // Cost of checkpoint isn't known yet, so first checkpoint is created.
+   memset(win_data, 1, 1024);
+   MPI_Win_fence_pmem_persist(0, win);
+   result |= check_checkpoint_data("test_window", 0, true, 1024, 1);
+   if (win.modifiable_values->checkpoint_cost <= 0.0) {
+      mpi_log_error("Cost of checkpoint wasn't measured.");
+      result = 1;
+   }
+
+   // Interval for checkpoint taking 1 second didn't elapse.
+   win.modifiable_values->checkpoint_cost = 1.0;
+   memset(win_data, 2, 1024);
+   MPI_Win_fence_pmem_persist(0, win);
+   result |= check_checkpoint_data("test_window", 1, false, 0, 0);
+
+   // Checkpoint is created when interval elapsed.
+   win.modifiable_values->last_checkpoint_time -= 1000.0;
+   MPI_Win_fence_pmem_persist(0, win);
+   result |= check_checkpoint_data("test_window", 1, true, 1024, 2);
+
+   MPI_Win_free_pmem(&win);
+   MPI_Finalize_pmem();
+
+   return result;
+}
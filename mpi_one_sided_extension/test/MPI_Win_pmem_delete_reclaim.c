@@ -0,0 +1,135 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_reclaim.h>
+#include "helper.h"
+
+/**
+ * Check number of files waiting in reclaim directory.
+ *
+ * @param root_path  Root path containing reclaim directory.
+ * @param expected   Expected number of files.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_reclaimed_count(const char *root_path, int expected) {
+   char path[MPI_PMEM_MAX_ROOT_PATH + 10];
+   DIR *directory;
+   struct dirent *entry;
+   int count = 0;
+
+   sprintf(path, "%s/%s", root_path, MPI_PMEM_RECLAIM_DIRECTORY);
+   directory = opendir(path);
+   if (directory == NULL) {
+      mpi_log_error("Reclaim directory '%s' doesn't exist.", path);
+      return 1;
+   }
+   while ((entry = readdir(directory)) != NULL) {
+      if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+         count++;
+      }
+   }
+   closedir(directory);
+   if (count != expected) {
+      mpi_log_error("Reclaim directory contains %d files, expected %d.", count, expected);
+      return 1;
+   }
+
+   return 0;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + 24];
+   MPI_Info info;
+   MPI_Win_pmem win;
+   char *window_name = "test_window";
+   char *win_data;
+   MPI_Aint win_size = 1024 * 1024;
+   FILE *file;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Checkpoint replaced by newer one disappears at once and is unlinked in background.
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", window_name);
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   memset(win_data, 1, win_size);
+   MPI_Win_fence_pmem_persist(0, win);
+   memset(win_data, 2, win_size);
+   MPI_Win_fence_pmem_persist(0, win);
+   result |= check_checkpoint_data(window_name, 0, false, win_size, 1);
+   result |= check_checkpoint_data(window_name, 1, true, win_size, 2);
+   MPI_Win_free_pmem(&win);
+   wait_for_reclaimed_files();
+   result |= check_reclaimed_count(root_path, 0);
+
+   // Deleted window's files don't wait for reclamation.
+   result |= MPI_Win_pmem_delete(window_name);
+   result |= check_data_file(window_name, false, 0, false, 0);
+   result |= check_checkpoint_data(window_name, 1, false, win_size, 2);
+   wait_for_reclaimed_files();
+   result |= check_reclaimed_count(root_path, 0);
+   if (result != 0) {
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // File left in reclaim directory by crashed process is unlinked after root path is set.
+   sprintf(file_name, "%s/%s/0-0-leftover", root_path, MPI_PMEM_RECLAIM_DIRECTORY);
+   file = fopen(file_name, "w");
+   if (file == NULL) {
+      mpi_log_error("Unable to create file '%s'.", file_name);
+      MPI_Finalize_pmem();
+      return 1;
+   }
+   fputs("leftover", file);
+   fclose(file);
+   result |= check_reclaimed_count(root_path, 1);
+   result |= MPI_Win_pmem_set_root_path(root_path);
+   wait_for_reclaimed_files();
+   result |= check_reclaimed_count(root_path, 0);
+
+   MPI_Finalize_pmem();
+
+   return result;
+}
@@ -0,0 +1,137 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_chunks.h>
+#include "helper.h"
+
+/**
+ * Check number of chunks in chunk store.
+ *
+ * @param root_path  Root path of chunk store.
+ * @param expected   Expected number of chunks.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_chunks_count(const char *root_path, int expected) {
+   char path[MPI_PMEM_MAX_ROOT_PATH + 9];
+   DIR *directory;
+   struct dirent *entry;
+   int count = 0;
+
+   sprintf(path, "%s/.chunks", root_path);
+   directory = opendir(path);
+   if (directory == NULL) {
+      mpi_log_error("Chunk store '%s' doesn't exist.", path);
+      return 1;
+   }
+   while ((entry = readdir(directory)) != NULL) {
+      if (entry->d_name[0] != '.') {
+         count++;
+      }
+   }
+   closedir(directory);
+   if (count != expected) {
+      mpi_log_error("Chunk store contains %d chunks, expected %d.", count, expected);
+      return 1;
+   }
+
+   return 0;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   MPI_Info info;
+   MPI_Win_pmem win;
+   char *window_name = "test_window";
+   char *win_data;
+   MPI_Aint win_size = 4 * MPI_PMEM_CHUNK_SIZE + 100;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Equal chunks of both versions are stored only once.
+   MPI_Info_create(&info);
+   MPI_Info_set(info, "pmem_is_pmem", "true");
+   MPI_Info_set(info, "pmem_name", window_name);
+   MPI_Info_set(info, "pmem_mode", "expand");
+   MPI_Info_set(info, "pmem_keep_all_checkpoints", "true");
+   MPI_Info_set(info, "pmem_checkpoint_dedup", "true");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= !win.dedup_checkpoints;
+   memset(win_data, 0, win_size);
+   MPI_Win_fence_pmem_persist(0, win);
+   result |= check_chunks_count(root_path, 2);
+   memset(win_data + MPI_PMEM_CHUNK_SIZE, 1, MPI_PMEM_CHUNK_SIZE);
+   MPI_Win_fence_pmem_persist(0, win);
+   result |= check_chunks_count(root_path, 3);
+   MPI_Win_free_pmem(&win);
+   result |= check_checkpoint_format(window_name, 0, MPI_PMEM_CHECKPOINT_CHUNKED, -1);
+   result |= check_checkpoint_format(window_name, 1, MPI_PMEM_CHECKPOINT_CHUNKED, -1);
+   if (result != 0) {
+      MPI_Info_free(&info);
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Restore both versions.
+   MPI_Info_set(info, "pmem_mode", "checkpoint");
+   MPI_Info_set(info, "pmem_checkpoint_version", "0");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   result |= check_data(win_data, win_size, 0);
+   MPI_Win_free_pmem(&win);
+   MPI_Info_delete(info, "pmem_checkpoint_version");
+   MPI_Win_allocate_pmem(win_size, 1, info, MPI_COMM_WORLD, &win_data, &win);
+   MPI_Info_free(&info);
+   result |= check_data(win_data, MPI_PMEM_CHUNK_SIZE, 0);
+   result |= check_data(win_data + MPI_PMEM_CHUNK_SIZE, MPI_PMEM_CHUNK_SIZE, 1);
+   result |= check_data(win_data + 2 * MPI_PMEM_CHUNK_SIZE, 2 * MPI_PMEM_CHUNK_SIZE + 100, 0);
+   MPI_Win_free_pmem(&win);
+   if (result != 0) {
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Chunks are removed when last version referring to them is deleted.
+   result |= MPI_Win_pmem_delete_version(window_name, 0);
+   result |= check_chunks_count(root_path, 3);
+   result |= MPI_Win_pmem_delete_version(window_name, 1);
+   result |= check_chunks_count(root_path, 0);
+
+   MPI_Finalize_pmem();
+
+   return result;
+}
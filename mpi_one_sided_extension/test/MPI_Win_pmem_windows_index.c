@@ -0,0 +1,125 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_index.h>
+#include "helper.h"
+
+#define WINDOWS_COUNT 300
+
+/**
+ * Check whether list of windows contains all created windows (window "w70" has size 4096, other windows "w<i>" have size i + 1) and whether all of them
+ * are found in index.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_windows(void) {
+   int i, record;
+   char name[MPI_PMEM_MAX_NAME];
+   MPI_Win_pmem_windows windows;
+   MPI_Win_pmem_windows_index index;
+   int result = 0;
+
+   MPI_Win_pmem_list(&windows);
+   if (windows.size != WINDOWS_COUNT) {
+      mpi_log_error("Number of returned windows is %d, expected %d.", windows.size, WINDOWS_COUNT);
+      MPI_Win_pmem_free_windows_list(&windows);
+      return 1;
+   }
+   open_windows_index(MPI_COMM_WORLD, &index);
+   for (i = 0; i < WINDOWS_COUNT; i++) {
+      sprintf(name, "w%d", i);
+      if (strcmp(windows.windows[i].name, name) != 0 || windows.windows[i].size != (i == 70 ? 4096 : i + 1)) {
+         mpi_log_error("Window at index %d is '%s' of size %lu, expected '%s'.", i, windows.windows[i].name, windows.windows[i].size, name);
+         result = 1;
+      }
+      record = find_window_record(&index, name);
+      if (record != i) {
+         mpi_log_error("Window '%s' found at record %d, expected %d.", name, record, i);
+         result = 1;
+      }
+   }
+   if (find_window_record(&index, "w") != -1) {
+      mpi_log_error("Window 'w' found, but it was never created.");
+      result = 1;
+   }
+   if (index.table->records != WINDOWS_COUNT || index.table->capacity < 2 * WINDOWS_COUNT) {
+      mpi_log_error("Index contains %lu records in %lu slots.", index.table->records, index.table->capacity);
+      result = 1;
+   }
+   close_windows_index(MPI_COMM_WORLD, &index);
+   MPI_Win_pmem_free_windows_list(&windows);
+
+   return result;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support, i;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char name[MPI_PMEM_MAX_NAME];
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + 20];
+   MPI_Win_pmem_windows_index index;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+
+   // Create enough windows to grow index a few times, then recreate deleted window.
+   for (i = 0; i < WINDOWS_COUNT; i++) {
+      sprintf(name, "w%d", i);
+      result |= create_window(name, i + 1);
+   }
+   MPI_Win_pmem_delete("w70");
+   result |= create_window("w70", 4096);
+   result |= check_windows();
+   if (result != 0) {
+      MPI_Finalize_pmem();
+      return result;
+   }
+
+   // Records appended to global metadata file but not indexed are indexed on next use.
+   open_windows_index(MPI_COMM_WORLD, &index);
+   index.table->records = 10;
+   close_windows_index(MPI_COMM_WORLD, &index);
+   result |= check_windows();
+
+   // Missing index is rebuilt.
+   sprintf(file_name, "%s/.windows_index", root_path);
+   remove(file_name);
+   result |= check_windows();
+
+   MPI_Finalize_pmem();
+
+   return result;
+}
@@ -284,6 +284,40 @@ int check_checkpoint_data(const char *window_name, int checkpoint_version, bool
    return result;
 }
 
+int check_checkpoint_format(const char *window_name, int checkpoint_version, char format, int parent_version) {
+   off_t file_size;
+   MPI_Win_pmem_version *versions;
+   int result = 0;
+
+   open_versions_metadata_file(MPI_COMM_WORLD, window_name, &versions, &file_size);
+   if (versions[checkpoint_version].format != format) {
+      mpi_log_error("Format of checkpoint version %d equals %d, expected %d.", checkpoint_version, versions[checkpoint_version].format, format);
+      result = 1;
+   }
+   if ((format == MPI_PMEM_CHECKPOINT_INCREMENTAL || format == MPI_PMEM_CHECKPOINT_DELTA || format == MPI_PMEM_CHECKPOINT_SLOT) && versions[checkpoint_version].parent_version != parent_version) {
+      mpi_log_error("Parent of checkpoint version %d equals %d, expected %d.", checkpoint_version, versions[checkpoint_version].parent_version, parent_version);
+      result = 1;
+   }
+   unmap_pmem_file(MPI_COMM_WORLD, versions, file_size);
+
+   return result;
+}
+
+int check_checkpoint_codec(const char *window_name, int checkpoint_version, char codec) {
+   off_t file_size;
+   MPI_Win_pmem_version *versions;
+   int result = 0;
+
+   open_versions_metadata_file(MPI_COMM_WORLD, window_name, &versions, &file_size);
+   if (versions[checkpoint_version].codec != codec) {
+      mpi_log_error("Codec of checkpoint version %d equals %d, expected %d.", checkpoint_version, versions[checkpoint_version].codec, codec);
+      result = 1;
+   }
+   unmap_pmem_file(MPI_COMM_WORLD, versions, file_size);
+
+   return result;
+}
+
 int check_window_object(const MPI_Win_pmem win, const MPI_Win_pmem expected, bool name, bool memory_areas) {
    int result = 0;
 
@@ -311,6 +345,82 @@ int check_window_object(const MPI_Win_pmem win, const MPI_Win_pmem expected, boo
       mpi_log_error("global_checkpoint is %s, expected %s.", win.global_checkpoint ? "true" : "false", expected.global_checkpoint ? "true" : "false");
       result = 1;
    }
+   if (win.incremental_checkpoints != expected.incremental_checkpoints) {
+      mpi_log_error("incremental_checkpoints is %s, expected %s.", win.incremental_checkpoints ? "true" : "false", expected.incremental_checkpoints ? "true" : "false");
+      result = 1;
+   }
+   if (win.delta_checkpoints != expected.delta_checkpoints) {
+      mpi_log_error("delta_checkpoints is %s, expected %s.", win.delta_checkpoints ? "true" : "false", expected.delta_checkpoints ? "true" : "false");
+      result = 1;
+   }
+   if (win.async_checkpoints != expected.async_checkpoints) {
+      mpi_log_error("async_checkpoints is %s, expected %s.", win.async_checkpoints ? "true" : "false", expected.async_checkpoints ? "true" : "false");
+      result = 1;
+   }
+   if (win.full_checkpoint_interval != expected.full_checkpoint_interval) {
+      mpi_log_error("full_checkpoint_interval is %d, expected %d.", win.full_checkpoint_interval, expected.full_checkpoint_interval);
+      result = 1;
+   }
+   if (win.checkpoint_threads != expected.checkpoint_threads) {
+      mpi_log_error("checkpoint_threads is %d, expected %d.", win.checkpoint_threads, expected.checkpoint_threads);
+      result = 1;
+   }
+   if (win.checkpoint_codec != expected.checkpoint_codec) {
+      mpi_log_error("checkpoint_codec is %d, expected %d.", win.checkpoint_codec, expected.checkpoint_codec);
+      result = 1;
+   }
+   if (win.dedup_checkpoints != expected.dedup_checkpoints) {
+      mpi_log_error("dedup_checkpoints is %s, expected %s.", win.dedup_checkpoints ? "true" : "false", expected.dedup_checkpoints ? "true" : "false");
+      result = 1;
+   }
+   if (win.zero_copy_restore != expected.zero_copy_restore) {
+      mpi_log_error("zero_copy_restore is %s, expected %s.", win.zero_copy_restore ? "true" : "false", expected.zero_copy_restore ? "true" : "false");
+      result = 1;
+   }
+   if (win.lazy_restore != expected.lazy_restore) {
+      mpi_log_error("lazy_restore is %s, expected %s.", win.lazy_restore ? "true" : "false", expected.lazy_restore ? "true" : "false");
+      result = 1;
+   }
+   if (win.aggregate_checkpoints != expected.aggregate_checkpoints) {
+      mpi_log_error("aggregate_checkpoints is %s, expected %s.", win.aggregate_checkpoints ? "true" : "false", expected.aggregate_checkpoints ? "true" : "false");
+      result = 1;
+   }
+   if (win.checkpoint_mtbf != expected.checkpoint_mtbf) {
+      mpi_log_error("checkpoint_mtbf is %d, expected %d.", win.checkpoint_mtbf, expected.checkpoint_mtbf);
+      result = 1;
+   }
+   if (win.checkpoint_overhead != expected.checkpoint_overhead) {
+      mpi_log_error("checkpoint_overhead is %d, expected %d.", win.checkpoint_overhead, expected.checkpoint_overhead);
+      result = 1;
+   }
+   if (win.checkpoint_writers != expected.checkpoint_writers) {
+      mpi_log_error("checkpoint_writers is %d, expected %d.", win.checkpoint_writers, expected.checkpoint_writers);
+      result = 1;
+   }
+   if (win.checkpoint_rate != expected.checkpoint_rate) {
+      mpi_log_error("checkpoint_rate is %d, expected %d.", win.checkpoint_rate, expected.checkpoint_rate);
+      result = 1;
+   }
+   if (win.checkpoint_slots != expected.checkpoint_slots) {
+      mpi_log_error("checkpoint_slots is %d, expected %d.", win.checkpoint_slots, expected.checkpoint_slots);
+      result = 1;
+   }
+   if (win.map_sync != expected.map_sync) {
+      mpi_log_error("map_sync is %s, expected %s.", win.map_sync ? "true" : "false", expected.map_sync ? "true" : "false");
+      result = 1;
+   }
+   if (win.prefault != expected.prefault) {
+      mpi_log_error("prefault is %s, expected %s.", win.prefault ? "true" : "false", expected.prefault ? "true" : "false");
+      result = 1;
+   }
+   if (win.stripe_size != expected.stripe_size) {
+      mpi_log_error("stripe_size is %d, expected %d.", win.stripe_size, expected.stripe_size);
+      result = 1;
+   }
+   if (win.track_dirty_ranges != expected.track_dirty_ranges) {
+      mpi_log_error("track_dirty_ranges is %s, expected %s.", win.track_dirty_ranges ? "true" : "false", expected.track_dirty_ranges ? "true" : "false");
+      result = 1;
+   }
    if (name && strcmp(win.name, expected.name) != 0) {
       mpi_log_error("name is '%s', expected '%s'.", win.name, expected.name);
       result = 1;
@@ -137,6 +137,29 @@ int check_data_file(const char *window_name, bool exists, MPI_Aint size, bool ch
  */
 int check_checkpoint_data(const char *window_name, int checkpoint_version, bool exists, MPI_Aint size, char value);
 
+/**
+ * Checks format of specified checkpoint version saved in window's versions metadata file.
+ *
+ * @param window_name         Name of the window.
+ * @param checkpoint_version  Checkpoint version to check.
+ * @param format              Expected checkpoint format.
+ * @param parent_version      Expected base version of incremental and delta checkpoints or slot index of slot checkpoints.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+int check_checkpoint_format(const char *window_name, int checkpoint_version, char format, int parent_version);
+
+/**
+ * Checks codec of specified checkpoint version saved in window's versions metadata file.
+ *
+ * @param window_name         Name of the window.
+ * @param checkpoint_version  Checkpoint version to check.
+ * @param codec               Expected checkpoint codec.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+int check_checkpoint_codec(const char *window_name, int checkpoint_version, char codec);
+
 /**
  * Checks metadata associated with window object.
  *
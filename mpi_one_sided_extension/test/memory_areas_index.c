@@ -0,0 +1,144 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_areas.h>
+#include "helper.h"
+
+#define AREAS_COUNT 64
+#define AREA_STRIDE 128
+#define AREA_SIZE 100
+
+/**
+ * Check that index visits areas in order of their addresses and list of areas contains the same number of consistently linked areas.
+ *
+ * @param win      Window object.
+ * @param data     Memory containing areas.
+ * @param removed  Flag specifying whether areas with even numbers were removed.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_areas(MPI_Win_pmem win, char *data, bool removed) {
+   MPI_Win_memory_areas_list *current_item, *previous_item;
+   int i, count = 0;
+   int result = 0;
+
+   for (i = removed ? 1 : 0, current_item = find_memory_area(win, NULL); current_item != NULL; i += removed ? 2 : 1, current_item = current_item->index_next[0]) {
+      if (current_item->base != data + i * AREA_STRIDE || current_item->size != AREA_SIZE) {
+         mpi_log_error("Area %d has base 0x%lx and size %lu, expected 0x%lx and %d.", i, (long int) current_item->base, current_item->size,
+                       (long int) (data + i * AREA_STRIDE), AREA_SIZE);
+         result = 1;
+      }
+      count++;
+   }
+   for (previous_item = NULL, current_item = win.modifiable_values->memory_areas; current_item != NULL; previous_item = current_item, current_item = current_item->next) {
+      if (current_item->previous != previous_item) {
+         mpi_log_error("Area with base 0x%lx isn't linked with previous area.", (long int) current_item->base);
+         result = 1;
+      }
+      count--;
+   }
+   if (count != 0) {
+      mpi_log_error("Index and list of areas contain different number of areas.");
+      result = 1;
+   }
+
+   return result;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char *data;
+   MPI_Win_pmem win;
+   MPI_Win_memory_areas_list *area;
+   int i, area_number;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   data = malloc(AREAS_COUNT * AREA_STRIDE);
+   set_default_window_metadata(&win, MPI_COMM_WORLD);
+
+   // Areas are added in shuffled order and the last added one is placed at the beginning of list.
+   for (i = 0; i < AREAS_COUNT; i++) {
+      area_number = (i * 37) % AREAS_COUNT;
+      add_memory_area(win, data + area_number * AREA_STRIDE, AREA_SIZE, &area);
+      if (win.modifiable_values->memory_areas != area || area->id != i) {
+         mpi_log_error("Area %d isn't placed at the beginning of list or has identifier %d.", area_number, area->id);
+         result = 1;
+      }
+   }
+   result |= check_areas(win, data, false);
+
+   // Address is mapped to area containing it or to the first area above it.
+   for (i = 0; i < AREAS_COUNT; i++) {
+      area = find_memory_area(win, data + i * AREA_STRIDE + AREA_SIZE / 2);
+      if (area == NULL || area->base != data + i * AREA_STRIDE) {
+         mpi_log_error("Address inside area %d isn't found in this area.", i);
+         result = 1;
+      }
+      area = find_memory_area(win, data + i * AREA_STRIDE + AREA_SIZE);
+      if (i < AREAS_COUNT - 1 ? (area == NULL || area->base != data + (i + 1) * AREA_STRIDE) : area != NULL) {
+         mpi_log_error("Address following area %d isn't mapped to the next area.", i);
+         result = 1;
+      }
+   }
+
+   // Only areas with exactly matching base are removed.
+   if (remove_memory_area(win, data + 1) != NULL) {
+      mpi_log_error("Area was removed using address which isn't its base.");
+      result = 1;
+   }
+   for (i = 0; i < AREAS_COUNT; i += 2) {
+      area = remove_memory_area(win, data + i * AREA_STRIDE);
+      if (area == NULL || area->base != data + i * AREA_STRIDE) {
+         mpi_log_error("Area %d wasn't removed.", i);
+         result = 1;
+      }
+      free(area);
+   }
+   result |= check_areas(win, data, true);
+   area = find_memory_area(win, data);
+   if (area == NULL || area->base != data + AREA_STRIDE) {
+      mpi_log_error("Address of removed area isn't mapped to the next area.");
+      result = 1;
+   }
+
+   free_memory_areas(win);
+   if (win.modifiable_values->memory_areas != NULL || find_memory_area(win, NULL) != NULL) {
+      mpi_log_error("Memory areas weren't freed.");
+      result = 1;
+   }
+   free(win.modifiable_values);
+   free(data);
+   MPI_Finalize_pmem();
+
+   return result;
+}
@@ -0,0 +1,110 @@
+/*
+Copyright 2014-2016, Gdansk University of Technology
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its contributors
+      may be used to endorse or promote products derived from this software
+      without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <common/logger.h>
+#include <common/mpi_init_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_helper.h>
+#include <mpi_one_sided_extension/mpi_win_pmem_persist.h>
+#include "helper.h"
+
+/**
+ * Check beginning and end (relative to base address) of range in batch.
+ *
+ * @param batch    Batch of ranges.
+ * @param i        Index of range.
+ * @param base     Base address.
+ * @param begin    Expected beginning of range.
+ * @param end      Expected end of range.
+ * @param is_pmem  Expected kind of range.
+ *
+ * @returns 0 on success or non zero value on failure.
+ */
+static int check_range(const MPI_Win_pmem_persist_batch *batch, int i, uintptr_t base, uintptr_t begin, uintptr_t end, bool is_pmem) {
+   if (batch->ranges[i].begin - base != begin || batch->ranges[i].end - base != end || batch->ranges[i].is_pmem != is_pmem) {
+      mpi_log_error("Range %d is [%lu, %lu) (pmem: %d), expected [%lu, %lu) (pmem: %d).", i, batch->ranges[i].begin - base, batch->ranges[i].end - base,
+                    batch->ranges[i].is_pmem, begin, end, is_pmem);
+      return 1;
+   }
+
+   return 0;
+}
+
+int main(int argc, char *argv[]) {
+   int thread_support;
+   char root_path[MPI_PMEM_MAX_ROOT_PATH];
+   char file_name[MPI_PMEM_MAX_ROOT_PATH + 20];
+   char *data;
+   MPI_Aint size = 4 * 4096;
+   MPI_Win_pmem_persist_batch batch;
+   int result = 0;
+
+   MPI_Init_thread_pmem(&argc, &argv, MPI_THREAD_MULTIPLE, &thread_support);
+   sprintf(root_path, "%s/0", argv[1]);
+   MPI_Win_pmem_set_root_path(root_path);
+   sprintf(file_name, "%s/data", root_path);
+   open_pmem_file(MPI_COMM_WORLD, file_name, size, (void**) &data);
+
+   // Ranges are aligned to cache lines (pmem) or pages (msync) and merged if they overlap or are adjacent.
+   init_persist_batch(&batch);
+   add_persist_range(&batch, data + 1000, 8, true);
+   add_persist_range(&batch, data + 70, 10, true);
+   add_persist_range(&batch, data + 5000, 10, false);
+   add_persist_range(&batch, data + 10, 20, true);
+   add_persist_range(&batch, data + 100, 10, false);
+   add_persist_range(&batch, data + 10, 0, false);
+   merge_persist_ranges(&batch);
+   if (batch.count != 3) {
+      mpi_log_error("Number of merged ranges is %d, expected 3.", batch.count);
+      result = 1;
+   } else {
+      result |= check_range(&batch, 0, (uintptr_t) data, 0, 2 * MPI_PMEM_CACHE_LINE_SIZE, true);
+      result |= check_range(&batch, 1, (uintptr_t) data, 15 * MPI_PMEM_CACHE_LINE_SIZE, 16 * MPI_PMEM_CACHE_LINE_SIZE, true);
+      result |= check_range(&batch, 2, (uintptr_t) data, 0, 2 * 4096, false);
+   }
+
+   // Persisted batch is empty.
+   data[0] = 1;
+   data[3 * 4096] = 1;
+   add_persist_range(&batch, data + 3 * 4096, 1, false);
+   if (!persist_batch(&batch)) {
+      mpi_log_error("Unable to persist batch.");
+      result = 1;
+   }
+   if (batch.count != 0) {
+      mpi_log_error("Number of ranges after persist is %d, expected 0.", batch.count);
+      result = 1;
+   }
+   free_persist_batch(&batch);
+   unmap_pmem_file(MPI_COMM_WORLD, data, size);
+
+   MPI_Finalize_pmem();
+
+   return result;
+}